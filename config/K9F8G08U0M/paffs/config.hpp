@@ -31,7 +31,11 @@ namespace paffs{
 	//Cache sizes
 	static constexpr uint8_t  treeNodeCacheSize = 5;		//max. 1,5 * dataBytesPerPage(TreeNode) Bytes per Entry
 	static constexpr uint8_t  areaSummaryCacheSize = 4;		//Currently  2 Bit per dataPagesPerArea
+	static constexpr uint8_t  inodeCacheSize = 1;		//sizeof(Inode) Bytes per Entry, for repeated lookups of the same Inodes
+	static constexpr uint8_t  pageAddressCacheSets = 1;		//6 * dataBytesPerPage Bytes per Entry, Inodes with loaded address lists
+	static constexpr uint8_t  readCacheSize = 1;		//dataBytesPerPage Bytes per Entry
 	static constexpr uint8_t  maxNumberOfDevices = 2;
 	static constexpr uint8_t  maxNumberOfInodes = 10;		//limits simultaneously open files/folders excluding duplicates
 	static constexpr uint8_t  maxNumberOfFiles = 10;		//limits simultaneously open files including duplicates
+	static constexpr uint8_t  maxWriteBufferedFiles = 0;		//dataBytesPerPage Bytes per Entry, files opened with FB that buffer at once
 }
@@ -31,8 +31,12 @@ static constexpr uint16_t reservedLogsize = 4098;       //bytes
 //Cache sizes
 static constexpr uint8_t  treeNodeCacheSize = 5;		//max. 1,5 * dataBytesPerPage(TreeNode) Bytes per Entry
 static constexpr uint8_t  areaSummaryCacheSize = 8;		//Currently  2 Bit per dataPagesPerArea
+static constexpr uint8_t  inodeCacheSize = 20;		//sizeof(Inode) Bytes per Entry, for repeated lookups of the same Inodes
+static constexpr uint8_t  pageAddressCacheSets = 3;		//6 * dataBytesPerPage Bytes per Entry, Inodes with loaded address lists
+static constexpr uint8_t  readCacheSize = 4;		//dataBytesPerPage Bytes per Entry
 static constexpr uint8_t  maxNumberOfDevices = 1;
 static constexpr uint8_t  maxNumberOfInodes = 10;		//limits simultaneously open files/folders excluding duplicates
 static constexpr uint8_t  maxNumberOfFiles = 10;		//limits simultaneously open files including duplicates
-static constexpr uint16_t maxPagesPerWrite     = 256;   //limits the size of a single write to a file or folder
+static constexpr uint8_t  maxWriteBufferedFiles = 4;		//dataBytesPerPage Bytes per Entry, files opened with FB that buffer at once
+static constexpr uint16_t maxPagesPerWrite     = 32;    //pages committed at once, larger writes are split into segments
 };
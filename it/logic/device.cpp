@@ -682,3 +682,277 @@ TEST_F(FileTest, readOnlyChecks)
     r = fs.remove("/a/b");
     ASSERT_EQ(r, Result::readOnly);
 }
+
+TEST_F(FileTest, bufferedSmallWrites)
+{
+    static constexpr unsigned int records = 100;
+    static constexpr FileSize recordSize = 40;
+    Device* dev = fs.getDevice(0);
+    char record[recordSize];
+    char cmp[recordSize];
+    FileSize b;
+    Result r;
+
+    // Unbuffered, each append programs its page again
+    Obj* fil = fs.open("/unbuffered", FW | FC);
+    ASSERT_NE(fil, nullptr);
+    dev->dataIO.resetStatistics();
+    for (unsigned int i = 0; i < records; i++)
+    {
+        memset(record, i, recordSize);
+        ASSERT_EQ(fs.write(*fil, record, recordSize, &b), Result::ok);
+    }
+    ASSERT_EQ(fs.close(*fil), Result::ok);
+    EXPECT_GE(dev->dataIO.getStatistics().pagesWritten, records);
+
+    // Buffered, each page is programmed once
+    fil = fs.open("/buffered", FW | FC | FB);
+    ASSERT_NE(fil, nullptr);
+    dev->dataIO.resetStatistics();
+    for (unsigned int i = 0; i < records; i++)
+    {
+        memset(record, i, recordSize);
+        ASSERT_EQ(fs.write(*fil, record, recordSize, &b), Result::ok);
+        ASSERT_EQ(b, recordSize);
+    }
+    ASSERT_EQ(fs.close(*fil), Result::ok);
+    static constexpr FileSize size = records * recordSize;
+    EXPECT_EQ(dev->dataIO.getStatistics().pagesWritten,
+              (size + dataBytesPerPage - 1) / dataBytesPerPage);
+    EXPECT_EQ(dev->dataIO.getStatistics().readModifyWrites, 0u);
+
+    ObjInfo info;
+    ASSERT_EQ(fs.getObjInfo("/buffered", info), Result::ok);
+    ASSERT_EQ(info.size, size);
+
+    // Reading and seeking see the buffered data
+    fil = fs.open("/buffered", FR | FW | FB);
+    ASSERT_NE(fil, nullptr);
+    ASSERT_EQ(fs.seek(*fil, 3 * recordSize), Result::ok);
+    memset(record, 0xAA, recordSize);
+    ASSERT_EQ(fs.write(*fil, record, recordSize, &b), Result::ok);
+    ASSERT_EQ(fs.seek(*fil, 3 * recordSize), Result::ok);
+    ASSERT_EQ(fs.read(*fil, cmp, recordSize, &b), Result::ok);
+    EXPECT_TRUE(ArraysMatch(cmp, record, recordSize));
+    ASSERT_EQ(fs.seek(*fil, 0, Seekmode::end), Result::ok);
+    ASSERT_EQ(fs.write(*fil, record, recordSize, &b), Result::ok);
+    ASSERT_EQ(fs.read(*fil, cmp, 1, &b), Result::ok);
+    EXPECT_EQ(b, 0u);
+    ASSERT_EQ(fs.close(*fil), Result::ok);
+
+    r = fs.unmount();
+    ASSERT_EQ(r, Result::ok);
+    r = fs.mount();
+    ASSERT_EQ(r, Result::ok);
+
+    fil = fs.open("/buffered", FR);
+    ASSERT_NE(fil, nullptr);
+    for (unsigned int i = 0; i <= records; i++)
+    {
+        memset(record, i == 3 || i == records ? 0xAA : i, recordSize);
+        ASSERT_EQ(fs.read(*fil, cmp, recordSize, &b), Result::ok);
+        ASSERT_EQ(b, recordSize);
+        ASSERT_TRUE(ArraysMatch(cmp, record, recordSize));
+    }
+    ASSERT_EQ(fs.close(*fil), Result::ok);
+}
+
+TEST_F(FileTest, bufferedWritesWithSeveralObjects)
+{
+    static constexpr FileSize len = 5;
+    char a[2 * len], b[len], c[len], d[len], e[len];
+    char cmp[4 * len];
+    memset(a, 'a', sizeof(a));
+    memset(b, 'b', sizeof(b));
+    memset(c, 'c', sizeof(c));
+    memset(d, 'd', sizeof(d));
+    memset(e, 'e', sizeof(e));
+    FileSize bw;
+
+    Obj* buffered = fs.open("/shared", FW | FC | FB);
+    ASSERT_NE(buffered, nullptr);
+    Obj* direct = fs.open("/shared", FR | FW);
+    ASSERT_NE(direct, nullptr);
+
+    // Reading through another object sees the buffered data
+    ASSERT_EQ(fs.write(*buffered, a, sizeof(a), &bw), Result::ok);
+    ASSERT_EQ(fs.read(*direct, cmp, sizeof(a), &bw), Result::ok);
+    ASSERT_EQ(bw, sizeof(a));
+    EXPECT_TRUE(ArraysMatch(a, cmp, sizeof(a)));
+
+    // The older buffered data does not overwrite a later direct write
+    ASSERT_EQ(fs.write(*buffered, b, sizeof(b), &bw), Result::ok);
+    ASSERT_EQ(fs.write(*direct, c, sizeof(c), &bw), Result::ok);
+    ASSERT_EQ(fs.close(*buffered), Result::ok);
+
+    // The same between two buffering objects
+    Obj* first = fs.open("/shared", FW | FB);
+    ASSERT_NE(first, nullptr);
+    Obj* second = fs.open("/shared", FW | FB);
+    ASSERT_NE(second, nullptr);
+    ASSERT_EQ(fs.seek(*first, 3 * len), Result::ok);
+    ASSERT_EQ(fs.seek(*second, 3 * len), Result::ok);
+    ASSERT_EQ(fs.write(*first, d, sizeof(d), &bw), Result::ok);
+    ASSERT_EQ(fs.write(*second, e, sizeof(e), &bw), Result::ok);
+    ASSERT_EQ(fs.close(*second), Result::ok);
+    ASSERT_EQ(fs.close(*first), Result::ok);
+
+    ASSERT_EQ(fs.seek(*direct, 0), Result::ok);
+    ASSERT_EQ(fs.read(*direct, cmp, sizeof(cmp), &bw), Result::ok);
+    ASSERT_EQ(bw, sizeof(cmp));
+    EXPECT_TRUE(ArraysMatch(a, cmp, sizeof(a)));
+    EXPECT_TRUE(ArraysMatch(c, &cmp[2 * len], sizeof(c)));
+    EXPECT_TRUE(ArraysMatch(e, &cmp[3 * len], sizeof(e)));
+    ASSERT_EQ(fs.close(*direct), Result::ok);
+}
+
+TEST_F(FileTest, writeBuffersArePooled)
+{
+    char data[10];
+    char cmp[sizeof(data)];
+    FileSize bw;
+    Obj* buffered[maxWriteBufferedFiles + 1];
+
+    for (unsigned int i = 0; i <= maxWriteBufferedFiles; i++)
+    {
+        buffered[i] = fs.open("/pooled", FR | FW | FC | FB);
+        ASSERT_NE(buffered[i], nullptr);
+    }
+    // The last object got no buffer and writes to flash directly
+    EXPECT_EQ(buffered[maxWriteBufferedFiles]->writeBuffer, nullptr);
+    for (unsigned int i = 0; i <= maxWriteBufferedFiles; i++)
+    {
+        memset(data, 'a' + i, sizeof(data));
+        ASSERT_EQ(fs.seek(*buffered[i], i * sizeof(data)), Result::ok);
+        ASSERT_EQ(fs.write(*buffered[i], data, sizeof(data), &bw), Result::ok);
+    }
+    for (unsigned int i = 0; i <= maxWriteBufferedFiles; i++)
+    {
+        memset(data, 'a' + i, sizeof(data));
+        ASSERT_EQ(fs.seek(*buffered[0], i * sizeof(data)), Result::ok);
+        ASSERT_EQ(fs.read(*buffered[0], cmp, sizeof(cmp), &bw), Result::ok);
+        ASSERT_EQ(bw, sizeof(cmp));
+        EXPECT_TRUE(ArraysMatch(data, cmp, sizeof(data)));
+    }
+
+    // A closed object returns its buffer
+    ASSERT_EQ(fs.close(*buffered[0]), Result::ok);
+    buffered[0] = fs.open("/pooled", FW | FB);
+    ASSERT_NE(buffered[0], nullptr);
+    EXPECT_NE(buffered[0]->writeBuffer, nullptr);
+    for (unsigned int i = 0; i <= maxWriteBufferedFiles; i++)
+    {
+        ASSERT_EQ(fs.close(*buffered[i]), Result::ok);
+    }
+}
+
+TEST_F(FileTest, bufferedObjectStaysOpenIfFlushFails)
+{
+    char data[10];
+    char cmp[sizeof(data)];
+    char block[dataBytesPerPage];
+    memset(data, 'x', sizeof(data));
+    memset(block, 'f', sizeof(block));
+    FileSize bw;
+    Result r;
+
+    Obj* buffered = fs.open("/buffered", FR | FW | FC | FB);
+    ASSERT_NE(buffered, nullptr);
+    ASSERT_EQ(fs.write(*buffered, data, sizeof(data), &bw), Result::ok);
+
+    Obj* filler = fs.open("/filler", FW | FC);
+    ASSERT_NE(filler, nullptr);
+    while ((r = fs.write(*filler, block, sizeof(block), &bw)) == Result::ok)
+    {
+    }
+    ASSERT_EQ(r, Result::noSpace);
+    ASSERT_EQ(fs.close(*filler), Result::ok);
+
+    // Closing fails, but the buffered data is kept
+    ASSERT_EQ(fs.close(*buffered), Result::noSpace);
+    ASSERT_EQ(fs.getNumberOfOpenFiles(), 1u);
+    ASSERT_NE(buffered->writeBuffer, nullptr);
+    EXPECT_EQ(buffered->writeBuffer->bytes, sizeof(data));
+
+    ASSERT_EQ(fs.remove("/filler"), Result::ok);
+    bool idle = false;
+    while (!idle)
+    {
+        ASSERT_EQ(fs.collectGarbage(dataPagesPerArea, idle), Result::ok);
+    }
+    ASSERT_EQ(fs.close(*buffered), Result::ok);
+    ASSERT_EQ(fs.getNumberOfOpenFiles(), 0u);
+
+    buffered = fs.open("/buffered", FR);
+    ASSERT_NE(buffered, nullptr);
+    ASSERT_EQ(fs.read(*buffered, cmp, sizeof(cmp), &bw), Result::ok);
+    ASSERT_EQ(bw, sizeof(cmp));
+    EXPECT_TRUE(ArraysMatch(data, cmp, sizeof(data)));
+    ASSERT_EQ(fs.close(*buffered), Result::ok);
+}
+
+TEST_F(FileTest, writeLargerThanMaxPagesPerWrite)
+{
+    static constexpr FileSize offs = 50;
+    static constexpr FileSize size = (2 * maxPagesPerWrite + 10) * dataBytesPerPage + 100;
+    std::unique_ptr<char[]> in(new char[size]);
+    std::unique_ptr<char[]> out(new char[size]);
+    for (FileSize i = 0; i < size; i++)
+    {
+        in[i] = i * 7 % 251;
+    }
+    FileSize b;
+    Result r;
+
+    Obj* fil = fs.open("/big", FW | FC);
+    ASSERT_NE(fil, nullptr);
+    ASSERT_EQ(fs.seek(*fil, offs), Result::ok);
+    r = fs.write(*fil, in.get(), size, &b);
+    ASSERT_EQ(r, Result::ok);
+    ASSERT_EQ(b, size);
+    ASSERT_EQ(fs.close(*fil), Result::ok);
+
+    ObjInfo info;
+    ASSERT_EQ(fs.getObjInfo("/big", info), Result::ok);
+    ASSERT_EQ(info.size, offs + size);
+
+    r = fs.unmount();
+    ASSERT_EQ(r, Result::ok);
+    r = fs.mount();
+    ASSERT_EQ(r, Result::ok);
+
+    fil = fs.open("/big", FR);
+    ASSERT_NE(fil, nullptr);
+    ASSERT_EQ(fs.seek(*fil, offs), Result::ok);
+    r = fs.read(*fil, out.get(), size, &b);
+    ASSERT_EQ(r, Result::ok);
+    ASSERT_EQ(b, size);
+    EXPECT_TRUE(ArraysMatch(in.get(), out.get(), size));
+    ASSERT_EQ(fs.close(*fil), Result::ok);
+
+    // Truncating and deleting more than maxPagesPerWrite pages releases all of them
+    ASSERT_EQ(fs.truncate("/big", offs + dataBytesPerPage), Result::ok);
+    ASSERT_EQ(fs.getObjInfo("/big", info), Result::ok);
+    ASSERT_EQ(info.size, offs + dataBytesPerPage);
+    fil = fs.open("/big", FR);
+    ASSERT_NE(fil, nullptr);
+    ASSERT_EQ(fs.seek(*fil, offs), Result::ok);
+    r = fs.read(*fil, out.get(), dataBytesPerPage, &b);
+    ASSERT_EQ(r, Result::ok);
+    ASSERT_EQ(b, dataBytesPerPage);
+    EXPECT_TRUE(ArraysMatch(in.get(), out.get(), dataBytesPerPage));
+    ASSERT_EQ(fs.close(*fil), Result::ok);
+    ASSERT_EQ(fs.remove("/big"), Result::ok);
+
+    Device* dev = fs.getDevice(0);
+    PageOffs usedPages = 0;
+    for (AreaPos area = 0; area < areasNo; area++)
+    {
+        if (dev->superblock.getType(area) == AreaType::data)
+        {
+            usedPages += dev->sumCache.getUsedPages(area);
+        }
+    }
+    // Only the root directory is left
+    EXPECT_LE(usedPages, 1u);
+}
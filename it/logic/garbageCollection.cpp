@@ -0,0 +1,890 @@
+/*
+ * Copyright (c) 2017, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Authors:
+ * - 2017, Pascal Pieper (DLR RY-AVS)
+ */
+// ----------------------------------------------------------------------------
+
+#include "commonTest.hpp"
+#include <chrono>
+#include <memory>
+#include <simu/flashCell.hpp>
+#include <simu/mram.hpp>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+using namespace paffs;
+using namespace testing;
+
+class GarbageCollectionPolicy : public InitFs, public WithParamInterface<GcPolicy>
+{
+};
+
+class IncrementalGarbageCollection : public InitFs
+{
+};
+
+static constexpr unsigned int coldPages = 1024;
+static constexpr unsigned int hotFiles = 4;
+static constexpr unsigned int hotPages = 32;
+static constexpr unsigned int overwrites = 2000;
+static constexpr unsigned int hotPercentage = 90;
+
+static void
+writeAt(Paffs& fs, Obj& fil, std::vector<uint8_t>& shadow, unsigned int page, uint8_t value)
+{
+    uint8_t buf[dataBytesPerPage];
+    unsigned int bw;
+    memset(buf, value, dataBytesPerPage);
+    ASSERT_EQ(fs.seek(fil, page * dataBytesPerPage, Seekmode::set), Result::ok);
+    ASSERT_EQ(fs.write(fil, buf, dataBytesPerPage, &bw), Result::ok);
+    ASSERT_EQ(bw, dataBytesPerPage);
+    memset(&shadow[page * dataBytesPerPage], value, dataBytesPerPage);
+}
+
+static void
+verifyFile(Paffs& fs, const char* path, std::vector<uint8_t>& shadow)
+{
+    std::vector<uint8_t> buf(shadow.size());
+    unsigned int br;
+    Obj* fil = fs.open(path, FR);
+    ASSERT_NE(fil, nullptr);
+    ASSERT_EQ(fs.read(*fil, buf.data(), buf.size(), &br), Result::ok);
+    ASSERT_EQ(br, buf.size());
+    ASSERT_TRUE(ArraysMatch(shadow.data(), buf.data(), buf.size()));
+    ASSERT_EQ(fs.close(*fil), Result::ok);
+}
+
+/**
+ * Hot/cold overwrite workload. Prints write amplification, GC time
+ * and erase count spread of the selected policy, so they can be compared.
+ */
+TEST_P(GarbageCollectionPolicy, hotColdOverwrite)
+{
+    Device* dev = fs.getDevice(0);
+    char path[20];
+    std::vector<uint8_t> cold(coldPages * dataBytesPerPage);
+    std::vector<std::vector<uint8_t>> hot(hotFiles,
+                                          std::vector<uint8_t>(hotPages * dataBytesPerPage));
+    Obj* hotFil[hotFiles];
+
+    fs.setGcPolicy(GetParam());
+    ASSERT_EQ(fs.getGcPolicy(), GetParam());
+    srand(1);
+
+    Obj* coldFil = fs.open("/cold", FW | FC);
+    ASSERT_NE(coldFil, nullptr);
+    for (unsigned int page = 0; page < coldPages; page++)
+    {
+        writeAt(fs, *coldFil, cold, page, rand());
+    }
+    for (unsigned int i = 0; i < hotFiles; i++)
+    {
+        sprintf(path, "/hot%u", i);
+        hotFil[i] = fs.open(path, FW | FC);
+        ASSERT_NE(hotFil[i], nullptr);
+        for (unsigned int page = 0; page < hotPages; page++)
+        {
+            writeAt(fs, *hotFil[i], hot[i], page, rand());
+        }
+    }
+
+    dev->areaMgmt.gc.resetStatistics();
+    uint64_t deletionsBefore = dev->superblock.getOverallDeletions();
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < overwrites; i++)
+    {
+        if (static_cast<unsigned int>(rand() % 100) < hotPercentage)
+        {
+            unsigned int file = rand() % hotFiles;
+            writeAt(fs, *hotFil[file], hot[file], rand() % hotPages, rand());
+        }
+        else
+        {
+            writeAt(fs, *coldFil, cold, rand() % coldPages, rand());
+        }
+        if (HasFatalFailure())
+        {
+            return;
+        }
+    }
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+
+    GcStatistics stats = dev->areaMgmt.gc.getStatistics();
+    uint32_t minErases = ~0, maxErases = 0;
+    for (AreaPos area = 0; area < areasNo; area++)
+    {
+        if (dev->superblock.getType(area) == AreaType::superblock
+            || dev->superblock.getType(area) == AreaType::retired)
+        {
+            continue;
+        }
+        minErases = std::min(minErases, dev->superblock.getErasecount(area));
+        maxErases = std::max(maxErases, dev->superblock.getErasecount(area));
+    }
+    printf("%12s: %5" PRIu32 " collections, %6" PRIu32 " moved pages, write amplification %.2f, "
+           "%5" PRIu64 " erases, erase spread %" PRIu32 ", %5lld ms\n",
+           gcPolicyNames[static_cast<uint8_t>(GetParam())],
+           stats.collections,
+           stats.movedPages,
+           static_cast<float>(overwrites + stats.movedPages) / overwrites,
+           dev->superblock.getOverallDeletions() - deletionsBefore,
+           maxErases - minErases,
+           static_cast<long long>(duration.count()));
+
+    ASSERT_EQ(fs.close(*coldFil), Result::ok);
+    for (unsigned int i = 0; i < hotFiles; i++)
+    {
+        ASSERT_EQ(fs.close(*hotFil[i]), Result::ok);
+    }
+
+    verifyFile(fs, "/cold", cold);
+    for (unsigned int i = 0; i < hotFiles; i++)
+    {
+        sprintf(path, "/hot%u", i);
+        verifyFile(fs, path, hot[i]);
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(Policies,
+                        GarbageCollectionPolicy,
+                        Values(GcPolicy::greedy, GcPolicy::costBenefit, GcPolicy::wearAware));
+
+/**
+ * Collects in small steps while files are written in between and checks
+ * that no step moves more pages than allowed.
+ */
+TEST_F(IncrementalGarbageCollection, budgetedCollection)
+{
+    static constexpr PageOffs budget = 16;
+    Device* dev = fs.getDevice(0);
+    std::vector<uint8_t> cold(coldPages * dataBytesPerPage);
+    std::vector<uint8_t> hot(hotPages * dataBytesPerPage);
+    srand(2);
+
+    Obj* coldFil = fs.open("/cold", FW | FC);
+    ASSERT_NE(coldFil, nullptr);
+    for (unsigned int page = 0; page < coldPages; page++)
+    {
+        writeAt(fs, *coldFil, cold, page, rand());
+    }
+    Obj* hotFil = fs.open("/hot", FW | FC);
+    ASSERT_NE(hotFil, nullptr);
+    for (unsigned int i = 0; i < overwrites / 4; i++)
+    {
+        writeAt(fs, *hotFil, hot, i % hotPages, rand());
+    }
+
+    // Collect as long as there is anything to gain
+    fs.setGcReserve(areasNo);
+    dev->areaMgmt.gc.resetStatistics();
+    bool idle = false;
+    unsigned int steps = 0;
+    while (!idle)
+    {
+        ASSERT_LT(steps, areasNo * dataPagesPerArea);
+        uint32_t movedBefore = dev->areaMgmt.gc.getStatistics().movedPages;
+        ASSERT_EQ(fs.collectGarbage(budget, idle), Result::ok);
+        ASSERT_LE(dev->areaMgmt.gc.getStatistics().movedPages - movedBefore, budget);
+        if (steps < 32)
+        {
+            // Overwrite pages of both files while a collection may be pending
+            writeAt(fs, *hotFil, hot, rand() % hotPages, rand());
+            writeAt(fs, *coldFil, cold, rand() % coldPages, rand());
+        }
+        steps++;
+    }
+    EXPECT_GT(dev->areaMgmt.gc.getStatistics().collections, 0u);
+    EXPECT_EQ(dev->areaMgmt.gc.getPendingVictim(), 0);
+
+    // Writes use the compacted areas
+    for (unsigned int i = 0; i < overwrites / 4; i++)
+    {
+        writeAt(fs, *hotFil, hot, rand() % hotPages, rand());
+    }
+
+    ASSERT_EQ(fs.close(*coldFil), Result::ok);
+    ASSERT_EQ(fs.close(*hotFil), Result::ok);
+    verifyFile(fs, "/cold", cold);
+    verifyFile(fs, "/hot", hot);
+
+    ASSERT_EQ(fs.unmount(), Result::ok);
+    ASSERT_EQ(fs.mount(), Result::ok);
+    verifyFile(fs, "/cold", cold);
+    verifyFile(fs, "/hot", hot);
+}
+
+/**
+ * Erases an area queued before an incremental collection started while the
+ * collection is pending and loses power. The copied pages are not kept, so the
+ * garbage buffer has to be empty again after the remount.
+ */
+TEST_F(IncrementalGarbageCollection, powerLossAfterEraseWhilePending)
+{
+    std::vector<uint8_t> dead(2 * dataPagesPerArea * dataBytesPerPage);
+    std::vector<uint8_t> cold(2 * dataPagesPerArea * dataBytesPerPage);
+    std::stringstream flashImage;
+    std::stringstream mramImage;
+    srand(6);
+    {
+        std::vector<Driver*> drv;
+        FlashCell* fc = new FlashCell();
+        Mram* mram = new Mram(mramSize);
+        drv.push_back(getDriverSpecial(0, fc, mram));
+        Paffs fs(drv);
+        BadBlockList bbl[maxNumberOfDevices];
+        ASSERT_EQ(fs.format(bbl), Result::ok);
+        ASSERT_EQ(fs.mount(), Result::ok);
+        Device* dev = fs.getDevice(0);
+
+        Obj* deadFil = fs.open("/dead", FW | FC);
+        ASSERT_NE(deadFil, nullptr);
+        Obj* coldFil = fs.open("/cold", FW | FC);
+        ASSERT_NE(coldFil, nullptr);
+        for (unsigned int page = 0; page < 2 * dataPagesPerArea; page++)
+        {
+            writeAt(fs, *deadFil, dead, page, rand());
+        }
+        for (unsigned int page = 0; page < 2 * dataPagesPerArea; page++)
+        {
+            writeAt(fs, *coldFil, cold, page, rand());
+        }
+        for (unsigned int page = 0; page < 2 * dataPagesPerArea; page += 2)
+        {
+            writeAt(fs, *coldFil, cold, page, rand());
+        }
+        ASSERT_EQ(fs.close(*deadFil), Result::ok);
+        ASSERT_EQ(fs.close(*coldFil), Result::ok);
+        ASSERT_EQ(fs.remove("/dead"), Result::ok);
+
+        // Empty victims are queued for erasure, then valid pages are copied
+        fs.setEraseWatermark(0);
+        fs.setGcReserve(areasNo);
+        bool idle = false;
+        unsigned int steps = 0;
+        while (dev->areaMgmt.gc.getPendingVictim() == 0)
+        {
+            ASSERT_LT(steps++, areasNo);
+            ASSERT_EQ(fs.collectGarbage(20, idle), Result::ok);
+            ASSERT_FALSE(idle);
+        }
+        ASSERT_GT(dev->areaMgmt.getQueuedErases(), 0);
+        ASSERT_EQ(fs.eraseQueuedAreas(1, idle), Result::ok);
+        ASSERT_NE(dev->areaMgmt.gc.getPendingVictim(), 0);
+
+        //---- Whoops, power went out! ----//
+        fc->getDebugInterface()->serialize(flashImage);
+        mram->serialize(mramImage);
+
+        ASSERT_EQ(fs.unmount(), Result::ok);
+        delete fc;
+        delete mram;
+    }
+
+    std::vector<Driver*> drv;
+    FlashCell* fc = new FlashCell();
+    Mram* mram = new Mram(mramSize);
+    drv.push_back(getDriverSpecial(0, fc, mram));
+    fc->getDebugInterface()->deserialize(flashImage);
+    mram->deserialize(mramImage);
+    {
+        Paffs fs(drv);
+        ASSERT_EQ(fs.mount(), Result::ok);
+        Device* dev = fs.getDevice(0);
+        EXPECT_EQ(dev->areaMgmt.gc.getPendingVictim(), 0);
+
+        AreaPos gcBuffer = dev->superblock.getActiveArea(AreaType::garbageBuffer);
+        ASSERT_NE(gcBuffer, 0);
+        TwoBitList<dataPagesPerArea> summary;
+        ASSERT_EQ(dev->sumCache.scanAreaForSummaryStatus(gcBuffer, summary), Result::ok);
+        EXPECT_EQ(summary.countValue(static_cast<uint8_t>(SummaryEntry::free)),
+                  dataPagesPerArea);
+
+        fs.setGcReserve(areasNo);
+        bool idle = false;
+        unsigned int steps = 0;
+        while (!idle)
+        {
+            ASSERT_LT(steps++, areasNo * dataPagesPerArea);
+            ASSERT_EQ(fs.collectGarbage(20, idle), Result::ok);
+        }
+        verifyFile(fs, "/cold", cold);
+        ASSERT_EQ(fs.unmount(), Result::ok);
+    }
+    delete fc;
+    delete mram;
+}
+
+class CompactingGarbageCollection : public InitFs
+{
+};
+
+/**
+ * Leaves only every eighth page of a file in its old areas valid
+ * and merges these sparse areas by compaction.
+ */
+TEST_F(CompactingGarbageCollection, mergeSparseAreas)
+{
+    Device* dev = fs.getDevice(0);
+    std::vector<uint8_t> cold(coldPages * dataBytesPerPage);
+    std::vector<uint8_t> small(3 * dataBytesPerPage + 100);
+    unsigned int bw;
+    srand(3);
+
+    Obj* fil = fs.open("/cold", FW | FC);
+    ASSERT_NE(fil, nullptr);
+    for (unsigned int page = 0; page < coldPages; page++)
+    {
+        writeAt(fs, *fil, cold, page, rand());
+    }
+    for (unsigned int page = 0; page < coldPages; page++)
+    {
+        if (page % 8 != 0)
+        {
+            writeAt(fs, *fil, cold, page, rand());
+        }
+    }
+    ASSERT_EQ(fs.close(*fil), Result::ok);
+
+    // A file with a partially filled last page
+    for (uint8_t& byte : small)
+    {
+        byte = rand();
+    }
+    fil = fs.open("/small", FW | FC);
+    ASSERT_NE(fil, nullptr);
+    ASSERT_EQ(fs.write(*fil, small.data(), small.size(), &bw), Result::ok);
+    ASSERT_EQ(fs.close(*fil), Result::ok);
+
+    ObjInfo coldInfo, smallInfo, info;
+    ASSERT_EQ(fs.getObjInfo("/cold", coldInfo), Result::ok);
+    ASSERT_EQ(fs.getObjInfo("/small", smallInfo), Result::ok);
+    // Any rewrite as a file change would now show a later modification time
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    dev->areaMgmt.gc.resetStatistics();
+    AreaPos gcBufferPos = dev->superblock.getPos(
+            dev->superblock.getActiveArea(AreaType::garbageBuffer));
+    bool idle = false;
+    unsigned int rounds = 0;
+    while (!idle)
+    {
+        ASSERT_LT(rounds++, areasNo);
+        ASSERT_EQ(fs.compactGarbage(idle), Result::ok);
+    }
+    ASSERT_EQ(fs.getObjInfo("/cold", info), Result::ok);
+    EXPECT_EQ(info.modified.timeSinceEpoch().milliseconds(),
+              coldInfo.modified.timeSinceEpoch().milliseconds());
+    ASSERT_EQ(fs.getObjInfo("/small", info), Result::ok);
+    EXPECT_EQ(info.modified.timeSinceEpoch().milliseconds(),
+              smallInfo.modified.timeSinceEpoch().milliseconds());
+    GcStatistics stats = dev->areaMgmt.gc.getStatistics();
+    EXPECT_GT(stats.compactedAreas, 0u);
+    EXPECT_GT(stats.compactedPages, 0u);
+    EXPECT_EQ(stats.movedPages, 0u);
+    // The garbage buffer was not used
+    EXPECT_EQ(dev->superblock.getPos(dev->superblock.getActiveArea(AreaType::garbageBuffer)),
+              gcBufferPos);
+
+    verifyFile(fs, "/cold", cold);
+    verifyFile(fs, "/small", small);
+    ASSERT_EQ(fs.unmount(), Result::ok);
+    ASSERT_EQ(fs.mount(), Result::ok);
+    verifyFile(fs, "/cold", cold);
+    verifyFile(fs, "/small", small);
+}
+
+class WearLeveling : public InitFs
+{
+};
+
+static uint32_t
+minErasesOfDataAreas(Device* dev)
+{
+    uint32_t minErases = ~0;
+    for (AreaPos area = 0; area < areasNo; area++)
+    {
+        if (dev->superblock.getType(area) == AreaType::data
+            && dev->superblock.getStatus(area) == AreaStatus::closed
+            && dev->sumCache.getUsedPages(area) > 0)
+        {
+            minErases = std::min(minErases, dev->superblock.getErasecount(area));
+        }
+    }
+    return minErases;
+}
+
+/**
+ * Wears out a few areas by overwriting a hot file while a cold file is never touched.
+ * Between bursts of hot writes, the cold areas are moved to the worn positions in small steps.
+ */
+TEST_F(WearLeveling, moveColdAreas)
+{
+    static constexpr PageOffs budget = 32;
+    static constexpr uint32_t threshold = 2;
+    static constexpr unsigned int rounds = 10;
+    Device* dev = fs.getDevice(0);
+    std::vector<uint8_t> cold(coldPages * dataBytesPerPage);
+    std::vector<uint8_t> hot(hotPages * dataBytesPerPage);
+    srand(4);
+
+    Obj* coldFil = fs.open("/cold", FW | FC);
+    ASSERT_NE(coldFil, nullptr);
+    for (unsigned int page = 0; page < coldPages; page++)
+    {
+        writeAt(fs, *coldFil, cold, page, rand());
+    }
+    ASSERT_EQ(fs.close(*coldFil), Result::ok);
+    Obj* hotFil = fs.open("/hot", FW | FC);
+    ASSERT_NE(hotFil, nullptr);
+    for (unsigned int i = 0; i < overwrites; i++)
+    {
+        writeAt(fs, *hotFil, hot, rand() % hotPages, rand());
+    }
+    ASSERT_EQ(fs.flush(*hotFil), Result::ok);
+
+    uint32_t coldErasesBefore = minErasesOfDataAreas(dev);
+    printf("Before wear leveling, data is on areas with at least %" PRIu32 " erases\n",
+           coldErasesBefore);
+    dev->areaMgmt.gc.printEraseHistogram();
+
+    fs.setWearThreshold(threshold);
+    dev->areaMgmt.gc.resetStatistics();
+    for (unsigned int round = 0; round < rounds; round++)
+    {
+        bool idle = false;
+        unsigned int steps = 0;
+        while (!idle)
+        {
+            ASSERT_LT(steps++, areasNo * dataPagesPerArea);
+            uint32_t movedBefore = dev->areaMgmt.gc.getStatistics().movedPages;
+            ASSERT_EQ(fs.levelWear(budget, idle), Result::ok);
+            ASSERT_LE(dev->areaMgmt.gc.getStatistics().movedPages - movedBefore, budget);
+        }
+        EXPECT_EQ(dev->areaMgmt.gc.getPendingVictim(), 0);
+        for (unsigned int i = 0; i < overwrites / 2; i++)
+        {
+            writeAt(fs, *hotFil, hot, rand() % hotPages, rand());
+        }
+        ASSERT_EQ(fs.flush(*hotFil), Result::ok);
+    }
+    EXPECT_GT(dev->areaMgmt.gc.getStatistics().leveledAreas, 0u);
+
+    uint32_t coldErasesAfter = minErasesOfDataAreas(dev);
+    printf("After wear leveling, data is on areas with at least %" PRIu32 " erases\n",
+           coldErasesAfter);
+    dev->areaMgmt.gc.printEraseHistogram();
+    EXPECT_GT(coldErasesAfter, coldErasesBefore);
+
+    ASSERT_EQ(fs.close(*hotFil), Result::ok);
+    verifyFile(fs, "/cold", cold);
+    verifyFile(fs, "/hot", hot);
+    ASSERT_EQ(fs.unmount(), Result::ok);
+    ASSERT_EQ(fs.mount(), Result::ok);
+    verifyFile(fs, "/cold", cold);
+    verifyFile(fs, "/hot", hot);
+}
+
+class DeferredErase : public InitFs
+{
+};
+
+/**
+ * Areas freed by compaction are only queued for erasure.
+ * The queue survives a remount and is processed later.
+ */
+TEST_F(DeferredErase, eraseQueuedAreas)
+{
+    Device* dev = fs.getDevice(0);
+    std::vector<uint8_t> cold(coldPages * dataBytesPerPage);
+    std::vector<uint8_t> hot(hotPages * dataBytesPerPage);
+    srand(5);
+
+    Obj* fil = fs.open("/cold", FW | FC);
+    ASSERT_NE(fil, nullptr);
+    for (unsigned int page = 0; page < coldPages; page++)
+    {
+        writeAt(fs, *fil, cold, page, rand());
+    }
+    for (unsigned int page = 0; page < coldPages; page++)
+    {
+        if (page % 8 != 0)
+        {
+            writeAt(fs, *fil, cold, page, rand());
+        }
+    }
+    ASSERT_EQ(fs.close(*fil), Result::ok);
+
+    fs.setEraseWatermark(0);
+    bool idle = false;
+    unsigned int rounds = 0;
+    while (!idle)
+    {
+        ASSERT_LT(rounds++, areasNo);
+        ASSERT_EQ(fs.compactGarbage(idle), Result::ok);
+    }
+    AreaPos queued = dev->areaMgmt.getQueuedErases();
+    EXPECT_GT(queued, 0);
+
+    ASSERT_EQ(fs.unmount(), Result::ok);
+    ASSERT_EQ(fs.mount(), Result::ok);
+    dev = fs.getDevice(0);
+    fs.setEraseWatermark(0);
+    EXPECT_EQ(dev->areaMgmt.getQueuedErases(), queued);
+    verifyFile(fs, "/cold", cold);
+
+    uint64_t deletionsBefore = dev->superblock.getOverallDeletions();
+    idle = false;
+    rounds = 0;
+    while (!idle)
+    {
+        ASSERT_LT(rounds++, areasNo);
+        ASSERT_EQ(fs.eraseQueuedAreas(1, idle), Result::ok);
+    }
+    EXPECT_EQ(dev->areaMgmt.getQueuedErases(), 0);
+    EXPECT_GE(dev->superblock.getOverallDeletions() - deletionsBefore, queued);
+
+    // Queued areas are erased on demand if the idle task does not run
+    ASSERT_EQ(fs.compactGarbage(idle), Result::ok);
+    fil = fs.open("/hot", FW | FC);
+    ASSERT_NE(fil, nullptr);
+    for (unsigned int i = 0; i < overwrites; i++)
+    {
+        writeAt(fs, *fil, hot, rand() % hotPages, rand());
+    }
+    ASSERT_EQ(fs.close(*fil), Result::ok);
+
+    verifyFile(fs, "/cold", cold);
+    verifyFile(fs, "/hot", hot);
+    ASSERT_EQ(fs.unmount(), Result::ok);
+    ASSERT_EQ(fs.mount(), Result::ok);
+    verifyFile(fs, "/cold", cold);
+    verifyFile(fs, "/hot", hot);
+}
+
+// Mounts the images taken at a power loss while a collection was pending.
+// The copied pages are not kept, so the garbage buffer has to be empty.
+static void
+checkPowerLossWhilePending(std::stringstream& flashImage, std::stringstream& mramImage,
+                           std::vector<uint8_t>& cold)
+{
+    std::vector<Driver*> drv;
+    std::unique_ptr<FlashCell> fc(new FlashCell());
+    std::unique_ptr<Mram> mram(new Mram(mramSize));
+    drv.push_back(getDriverSpecial(0, fc.get(), mram.get()));
+    fc->getDebugInterface()->deserialize(flashImage);
+    mram->deserialize(mramImage);
+
+    Paffs fs(drv);
+    ASSERT_EQ(fs.mount(), Result::ok);
+    Device* dev = fs.getDevice(0);
+    AreaPos gcBuffer = dev->superblock.getActiveArea(AreaType::garbageBuffer);
+    ASSERT_NE(gcBuffer, 0);
+    TwoBitList<dataPagesPerArea> summary;
+    ASSERT_EQ(dev->sumCache.scanAreaForSummaryStatus(gcBuffer, summary), Result::ok);
+    EXPECT_EQ(summary.countValue(static_cast<uint8_t>(SummaryEntry::free)), dataPagesPerArea);
+
+    fs.setGcReserve(areasNo);
+    bool idle = false;
+    unsigned int steps = 0;
+    while (!idle)
+    {
+        ASSERT_LT(steps++, areasNo * dataPagesPerArea);
+        ASSERT_EQ(fs.collectGarbage(dataPagesPerArea / 4, idle), Result::ok);
+    }
+    verifyFile(fs, "/cold", cold);
+    ASSERT_EQ(fs.unmount(), Result::ok);
+}
+
+/**
+ * Queued areas are erased by the idle task, at the erase watermark and on demand
+ * while an incremental collection is pending. Power is lost at each step of these erases.
+ */
+TEST_F(DeferredErase, eraseWhileCollectionPending)
+{
+    std::vector<uint8_t> dead(3 * dataPagesPerArea * dataBytesPerPage);
+    std::vector<uint8_t> cold(2 * dataPagesPerArea * dataBytesPerPage);
+    std::vector<uint8_t> hot;
+    srand(7);
+
+    std::vector<Driver*> drv;
+    std::unique_ptr<FlashCell> fc(new FlashCell());
+    std::unique_ptr<Mram> mram(new Mram(mramSize));
+    drv.push_back(getDriverSpecial(0, fc.get(), mram.get()));
+    Paffs fs(drv);
+    BadBlockList bbl[maxNumberOfDevices];
+    ASSERT_EQ(fs.format(bbl), Result::ok);
+    ASSERT_EQ(fs.mount(), Result::ok);
+    Device* dev = fs.getDevice(0);
+
+    Obj* deadFil = fs.open("/dead", FW | FC);
+    ASSERT_NE(deadFil, nullptr);
+    Obj* coldFil = fs.open("/cold", FW | FC);
+    ASSERT_NE(coldFil, nullptr);
+    for (unsigned int page = 0; page < 3 * dataPagesPerArea; page++)
+    {
+        writeAt(fs, *deadFil, dead, page, rand());
+    }
+    for (unsigned int page = 0; page < 2 * dataPagesPerArea; page++)
+    {
+        writeAt(fs, *coldFil, cold, page, rand());
+    }
+    // Leaves the old areas sparse enough for compaction
+    for (unsigned int page = 0; page < 2 * dataPagesPerArea; page++)
+    {
+        if (page % 4 != 0)
+        {
+            writeAt(fs, *coldFil, cold, page, rand());
+        }
+    }
+    ASSERT_EQ(fs.close(*deadFil), Result::ok);
+    ASSERT_EQ(fs.close(*coldFil), Result::ok);
+    ASSERT_EQ(fs.remove("/dead"), Result::ok);
+
+    fs.setEraseWatermark(0);
+    fs.setGcReserve(areasNo);
+    bool idle = false;
+    unsigned int steps = 0;
+    while (dev->areaMgmt.gc.getPendingVictim() == 0)
+    {
+        ASSERT_LT(steps++, areasNo);
+        ASSERT_EQ(fs.collectGarbage(20, idle), Result::ok);
+        ASSERT_FALSE(idle);
+    }
+    ASSERT_GE(dev->areaMgmt.getQueuedErases(), 2);
+
+    unsigned int powerLosses = 0;
+    bool checking = false;
+    failCallback = [&](const char* file, unsigned int, unsigned int)
+    {
+        if (checking || HasFailure() || strcmp(file, "area.cpp") != 0
+            || dev->areaMgmt.gc.getPendingVictim() == 0)
+        {
+            return;
+        }
+        checking = true;
+        std::stringstream flashImage;
+        std::stringstream mramImage;
+        fc->getDebugInterface()->serialize(flashImage);
+        mram->serialize(mramImage);
+        checkPowerLossWhilePending(flashImage, mramImage, cold);
+        powerLosses++;
+        checking = false;
+    };
+
+    // Idle task
+    AreaPos queued = dev->areaMgmt.getQueuedErases();
+    ASSERT_EQ(fs.eraseQueuedAreas(1, idle), Result::ok);
+    EXPECT_EQ(dev->areaMgmt.getQueuedErases(), queued - 1);
+
+    // Erase watermark
+    uint64_t deletionsBefore = dev->superblock.getOverallDeletions();
+    fs.setEraseWatermark(areasNo);
+    ASSERT_EQ(fs.compactGarbage(idle), Result::ok);
+    fs.setEraseWatermark(0);
+    EXPECT_GT(dev->superblock.getOverallDeletions(), deletionsBefore);
+
+    // On demand, when the flash fills up
+    Obj* hotFil = fs.open("/hot", FW | FC);
+    ASSERT_NE(hotFil, nullptr);
+    queued = dev->areaMgmt.getQueuedErases();
+    ASSERT_GT(queued, 0);
+    for (unsigned int page = 0; dev->areaMgmt.getQueuedErases() == queued; page++)
+    {
+        ASSERT_LT(page, areasNo * dataPagesPerArea);
+        hot.resize((page + 1) * dataBytesPerPage);
+        writeAt(fs, *hotFil, hot, page, rand());
+    }
+    failCallback = nullptr;
+    EXPECT_GT(powerLosses, 0u);
+    ASSERT_EQ(fs.close(*hotFil), Result::ok);
+
+    verifyFile(fs, "/cold", cold);
+    verifyFile(fs, "/hot", hot);
+    ASSERT_EQ(fs.unmount(), Result::ok);
+}
+
+/**
+ * A collection on the write path queues the erase of its victim and takes an erased area,
+ * so no erase is done while writing if the idle task keeps up with the queue.
+ */
+TEST_F(DeferredErase, foregroundCollectionQueuesErase)
+{
+    Device* dev = fs.getDevice(0);
+    std::vector<uint8_t> cold;
+    std::vector<uint8_t> hot(hotPages * dataBytesPerPage);
+    srand(11);
+
+    fs.setEraseWatermark(0);
+    // Fills the flash up to the reserved areas, so new areas are only gained by collections
+    Obj* coldFil = fs.open("/cold", FW | FC);
+    ASSERT_NE(coldFil, nullptr);
+    for (unsigned int page = 0; dev->superblock.getUsedAreas() < areasNo - minFreeAreas; page++)
+    {
+        ASSERT_LT(page, areasNo * dataPagesPerArea);
+        cold.resize((page + 1) * dataBytesPerPage);
+        writeAt(fs, *coldFil, cold, page, rand());
+    }
+    ASSERT_EQ(fs.close(*coldFil), Result::ok);
+    Obj* hotFil = fs.open("/hot", FW | FC);
+    ASSERT_NE(hotFil, nullptr);
+    for (unsigned int page = 0; page < hotPages; page++)
+    {
+        writeAt(fs, *hotFil, hot, page, rand());
+    }
+
+    dev->areaMgmt.gc.resetStatistics();
+    uint64_t writeErases = 0;
+    bool idle = false;
+    for (unsigned int i = 0; i < overwrites; i++)
+    {
+        uint64_t deletionsBefore = dev->superblock.getOverallDeletions();
+        writeAt(fs, *hotFil, hot, rand() % hotPages, rand());
+        writeErases += dev->superblock.getOverallDeletions() - deletionsBefore;
+        ASSERT_EQ(fs.eraseQueuedAreas(areasNo, idle), Result::ok);
+    }
+    const GcStatistics& stats = dev->areaMgmt.gc.getStatistics();
+    printf("%" PRIu32 " collections, %" PRIu32 " queued erases, %" PRIu64 " erases while writing\n",
+           stats.collections, stats.queuedErases, writeErases);
+    EXPECT_GT(stats.collections, 0u);
+    EXPECT_EQ(stats.queuedErases, stats.collections);
+    EXPECT_EQ(writeErases, 0u);
+    ASSERT_EQ(fs.close(*hotFil), Result::ok);
+
+    verifyFile(fs, "/cold", cold);
+    verifyFile(fs, "/hot", hot);
+    ASSERT_EQ(fs.unmount(), Result::ok);
+    ASSERT_EQ(fs.mount(), Result::ok);
+    verifyFile(fs, "/cold", cold);
+    verifyFile(fs, "/hot", hot);
+}
+
+static bool
+isErased(Device* dev, AreaPos area)
+{
+    unsigned char buf[totalBytesPerPage];
+    for (unsigned int page = 0; page < totalPagesPerArea; page++)
+    {
+        Addr addr = combineAddress(area, page);
+        dev->driver.readPage(getPageNumber(addr, *dev), buf, totalBytesPerPage);
+        for (unsigned int byte = 0; byte < totalBytesPerPage; byte++)
+        {
+            if (buf[byte] != 0xFF)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Mounts the images taken at a power loss while an erase was queued.
+// Empty areas and the garbage buffer must not hold the contents waiting for erasure.
+static void
+checkPowerLossWhileQueueing(std::stringstream& flashImage, std::stringstream& mramImage,
+                            std::vector<uint8_t>& cold)
+{
+    std::vector<Driver*> drv;
+    std::unique_ptr<FlashCell> fc(new FlashCell());
+    std::unique_ptr<Mram> mram(new Mram(mramSize));
+    drv.push_back(getDriverSpecial(0, fc.get(), mram.get()));
+    fc->getDebugInterface()->deserialize(flashImage);
+    mram->deserialize(mramImage);
+
+    Paffs fs(drv);
+    ASSERT_EQ(fs.mount(), Result::ok);
+    Device* dev = fs.getDevice(0);
+    for (AreaPos area = 0; area < areasNo; area++)
+    {
+        if ((dev->superblock.getStatus(area) == AreaStatus::empty
+             && dev->superblock.getType(area) != AreaType::retired)
+            || area == dev->superblock.getActiveArea(AreaType::garbageBuffer))
+        {
+            EXPECT_TRUE(isErased(dev, area)) << "Area " << area;
+        }
+    }
+    verifyFile(fs, "/cold", cold);
+    ASSERT_EQ(fs.unmount(), Result::ok);
+}
+
+/**
+ * Power is lost at each step of collections on the write path that queue their erase.
+ */
+TEST_F(DeferredErase, powerLossWhileQueueingForegroundErase)
+{
+    std::vector<uint8_t> cold;
+    std::vector<uint8_t> hot(hotPages * dataBytesPerPage);
+    srand(13);
+
+    std::vector<Driver*> drv;
+    std::unique_ptr<FlashCell> fc(new FlashCell());
+    std::unique_ptr<Mram> mram(new Mram(mramSize));
+    drv.push_back(getDriverSpecial(0, fc.get(), mram.get()));
+    Paffs fs(drv);
+    BadBlockList bbl[maxNumberOfDevices];
+    ASSERT_EQ(fs.format(bbl), Result::ok);
+    ASSERT_EQ(fs.mount(), Result::ok);
+    Device* dev = fs.getDevice(0);
+
+    fs.setEraseWatermark(0);
+    Obj* coldFil = fs.open("/cold", FW | FC);
+    ASSERT_NE(coldFil, nullptr);
+    for (unsigned int page = 0; dev->superblock.getUsedAreas() < areasNo - minFreeAreas; page++)
+    {
+        ASSERT_LT(page, areasNo * dataPagesPerArea);
+        cold.resize((page + 1) * dataBytesPerPage);
+        writeAt(fs, *coldFil, cold, page, rand());
+    }
+    ASSERT_EQ(fs.close(*coldFil), Result::ok);
+    Obj* hotFil = fs.open("/hot", FW | FC);
+    ASSERT_NE(hotFil, nullptr);
+    for (unsigned int page = 0; page < hotPages; page++)
+    {
+        writeAt(fs, *hotFil, hot, page, rand());
+    }
+
+    dev->areaMgmt.gc.resetStatistics();
+    unsigned int powerLosses = 0;
+    bool checking = false;
+    failCallback = [&](const char* file, unsigned int, unsigned int)
+    {
+        if (checking || HasFailure() || dev->areaMgmt.gc.getStatistics().queuedErases >= 2
+            || (strcmp(file, "area.cpp") != 0 && strcmp(file, "garbage_collection.cpp") != 0))
+        {
+            return;
+        }
+        checking = true;
+        std::stringstream flashImage;
+        std::stringstream mramImage;
+        fc->getDebugInterface()->serialize(flashImage);
+        mram->serialize(mramImage);
+        checkPowerLossWhileQueueing(flashImage, mramImage, cold);
+        powerLosses++;
+        checking = false;
+    };
+    bool idle = false;
+    for (unsigned int i = 0; dev->areaMgmt.gc.getStatistics().queuedErases < 2; i++)
+    {
+        ASSERT_LT(i, overwrites);
+        writeAt(fs, *hotFil, hot, rand() % hotPages, rand());
+        ASSERT_EQ(fs.eraseQueuedAreas(areasNo, idle), Result::ok);
+    }
+    failCallback = nullptr;
+    EXPECT_GT(powerLosses, 0u);
+    ASSERT_EQ(fs.close(*hotFil), Result::ok);
+
+    verifyFile(fs, "/cold", cold);
+    verifyFile(fs, "/hot", hot);
+    ASSERT_EQ(fs.unmount(), Result::ok);
+}
@@ -17,6 +17,8 @@
 #include <stdio.h>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <simu/flashCell.hpp>
 #include <simu/mram.hpp>
 
@@ -44,6 +46,399 @@ TEST_F(JournalTest, BreakAfterFileWrite)
     import();
 }
 
+TEST_F(JournalTest, BreakWithStagedWrite)
+{
+    stringstream flashImage;
+    stringstream mramImage;
+    FileSize bw;
+    Result r;
+    {
+        std::vector<paffs::Driver*> drv;
+        FlashCell* fc = new FlashCell();
+        Mram* mram = new Mram(mramSize);
+        drv.push_back(paffs::getDriverSpecial(0, fc, mram));
+        Paffs fs(drv);
+        BadBlockList bbl[maxNumberOfDevices];
+        ASSERT_EQ(fs.format(bbl), Result::ok);
+        ASSERT_EQ(fs.mount(), Result::ok);
+
+        Obj* fil = fs.open(filename, paffs::FW | paffs::FC | paffs::FB);
+        ASSERT_NE(fil, nullptr);
+        fs.getDevice(0)->dataIO.resetStatistics();
+        r = fs.write(*fil, text, sizeof(text), &bw);
+        ASSERT_EQ(r, Result::ok);
+        r = fs.write(*fil, text, sizeof(text), &bw);
+        ASSERT_EQ(r, Result::ok);
+        // Both writes are durable in MRAM only
+        EXPECT_EQ(fs.getDevice(0)->dataIO.getStatistics().pagesWritten, 0u);
+
+        //---- Whoops, power went out! ----//
+        fc->getDebugInterface()->serialize(flashImage);
+        mram->serialize(mramImage);
+
+        fs.close(*fil);
+        fs.unmount();
+        delete fc;
+        delete mram;
+    }
+
+    std::vector<paffs::Driver*> drv;
+    FlashCell* fc = new FlashCell();
+    Mram* mram = new Mram(mramSize);
+    drv.push_back(paffs::getDriverSpecial(0, fc, mram));
+    fc->getDebugInterface()->deserialize(flashImage);
+    mram->deserialize(mramImage);
+
+    Paffs fs(drv);
+    ASSERT_EQ(fs.mount(), Result::ok);
+    ObjInfo info;
+    ASSERT_EQ(fs.getObjInfo(filename, info), Result::ok);
+    ASSERT_EQ(info.size, 2 * sizeof(text));
+
+    Obj* fil = fs.open(filename, paffs::FR);
+    ASSERT_NE(fil, nullptr);
+    char input[2 * sizeof(text)];
+    ASSERT_EQ(fs.read(*fil, input, sizeof(input), &bw), Result::ok);
+    ASSERT_EQ(bw, sizeof(input));
+    EXPECT_EQ(memcmp(input, text, sizeof(text)), 0);
+    EXPECT_EQ(memcmp(&input[sizeof(text)], text, sizeof(text)), 0);
+    ASSERT_EQ(fs.close(*fil), Result::ok);
+
+    // The replayed data is on flash now and is not written again
+    ASSERT_EQ(fs.unmount(), Result::ok);
+    fs.getDevice(0)->dataIO.resetStatistics();
+    ASSERT_EQ(fs.mount(), Result::ok);
+    EXPECT_EQ(fs.getDevice(0)->dataIO.getStatistics().pagesWritten, 0u);
+    ASSERT_EQ(fs.unmount(), Result::ok);
+    delete fc;
+    delete mram;
+}
+
+// Mounts the images taken at a power loss during an append of `size` bytes to a file of
+// `oldSize` bytes starting with `text`. The file has either its old or its new size, appending
+// again has to succeed and no pages may be left behind after removing the file.
+static void
+checkInterruptedAppend(stringstream& flashImage, stringstream& mramImage,
+                       const char* data, FileSize oldSize, FileSize size)
+{
+    std::vector<paffs::Driver*> drv;
+    FlashCell* fc = new FlashCell();
+    Mram* mram = new Mram(mramSize);
+    drv.push_back(paffs::getDriverSpecial(0, fc, mram));
+    fc->getDebugInterface()->deserialize(flashImage);
+    mram->deserialize(mramImage);
+
+    {
+        Paffs fs(drv);
+        ASSERT_EQ(fs.mount(), Result::ok);
+        ObjInfo info;
+        ASSERT_EQ(fs.getObjInfo(filename, info), Result::ok);
+        ASSERT_THAT(info.size, testing::AnyOf(testing::Eq(oldSize),
+                                              testing::Eq(oldSize + size)));
+
+        FileSize bw;
+        Obj* fil = fs.open(filename, paffs::FR | paffs::FW);
+        ASSERT_NE(fil, nullptr);
+        if (info.size == oldSize)
+        {
+            ASSERT_EQ(fs.seek(*fil, 0, Seekmode::end), Result::ok);
+            ASSERT_EQ(fs.write(*fil, data, size, &bw), Result::ok);
+            ASSERT_EQ(bw, size);
+        }
+        char start[sizeof(text)];
+        ASSERT_EQ(fs.seek(*fil, 0), Result::ok);
+        ASSERT_EQ(fs.read(*fil, start, sizeof(text), &bw), Result::ok);
+        ASSERT_EQ(bw, sizeof(text));
+        EXPECT_EQ(memcmp(start, text, sizeof(text)), 0);
+        std::unique_ptr<char[]> input(new char[size]);
+        ASSERT_EQ(fs.seek(*fil, oldSize), Result::ok);
+        ASSERT_EQ(fs.read(*fil, input.get(), size, &bw), Result::ok);
+        ASSERT_EQ(bw, size);
+        EXPECT_TRUE(ArraysMatch(data, input.get(), size));
+        ASSERT_EQ(fs.close(*fil), Result::ok);
+
+        ASSERT_EQ(fs.remove(filename), Result::ok);
+        Device* dev = fs.getDevice(0);
+        PageOffs usedPages = 0;
+        for (AreaPos area = 0; area < areasNo; area++)
+        {
+            if (dev->superblock.getType(area) == AreaType::data)
+            {
+                usedPages += dev->sumCache.getUsedPages(area);
+            }
+        }
+        // Only the root directory is left
+        EXPECT_LE(usedPages, 1u);
+        ASSERT_EQ(fs.unmount(), Result::ok);
+    }
+    delete fc;
+    delete mram;
+}
+
+TEST_F(JournalTest, BreakBetweenWriteSegments)
+{
+    static constexpr FileSize size = (maxPagesPerWrite + maxPagesPerWrite / 2) * dataBytesPerPage;
+    std::unique_ptr<char[]> data(new char[size]);
+    for (FileSize i = 0; i < size; i++)
+    {
+        data[i] = i * 7 % 251;
+    }
+
+    std::vector<paffs::Driver*> drv;
+    FlashCell* fc = new FlashCell();
+    Mram* mram = new Mram(mramSize);
+    drv.push_back(paffs::getDriverSpecial(0, fc, mram));
+    {
+        Paffs fs(drv);
+        BadBlockList bbl[maxNumberOfDevices];
+        ASSERT_EQ(fs.format(bbl), Result::ok);
+        ASSERT_EQ(fs.mount(), Result::ok);
+
+        FileSize bw;
+        Obj* fil = fs.open(filename, paffs::FW | paffs::FC);
+        ASSERT_NE(fil, nullptr);
+        ASSERT_EQ(fs.write(*fil, text, sizeof(text), &bw), Result::ok);
+
+        // Power goes out at each failpoint of the segmented write in turn
+        unsigned int powerLosses = 0;
+        bool checking = false;
+        failCallback = [&](const char* file, unsigned int, unsigned int)
+        {
+            if (checking || HasFailure() || strcmp(file, "dataIO.cpp") != 0)
+            {
+                return;
+            }
+            checking = true;
+            stringstream flashImage;
+            stringstream mramImage;
+            fc->getDebugInterface()->serialize(flashImage);
+            mram->serialize(mramImage);
+            checkInterruptedAppend(flashImage, mramImage, data.get(), sizeof(text), size);
+            powerLosses++;
+            checking = false;
+        };
+        Result r = fs.write(*fil, data.get(), size, &bw);
+        failCallback = nullptr;
+        ASSERT_EQ(r, Result::ok);
+        ASSERT_EQ(bw, size);
+        EXPECT_GT(powerLosses, 0u);
+
+        ASSERT_EQ(fs.close(*fil), Result::ok);
+        ASSERT_EQ(fs.unmount(), Result::ok);
+    }
+    delete fc;
+    delete mram;
+}
+
+TEST_F(JournalTest, FlushBetweenWriteSegments)
+{
+    // Three segments, the journal runs full after the first one
+    static constexpr FileSize size = (2 * maxPagesPerWrite + maxPagesPerWrite / 2) * dataBytesPerPage;
+    std::unique_ptr<char[]> data(new char[size]);
+    for (FileSize i = 0; i < size; i++)
+    {
+        data[i] = i * 13 % 241;
+    }
+
+    std::vector<paffs::Driver*> drv;
+    std::unique_ptr<FlashCell> fc(new FlashCell());
+    std::unique_ptr<Mram> mram(new Mram(mramSize));
+    drv.push_back(paffs::getDriverSpecial(0, fc.get(), mram.get()));
+    {
+        Paffs fs(drv);
+        BadBlockList bbl[maxNumberOfDevices];
+        ASSERT_EQ(fs.format(bbl), Result::ok);
+        ASSERT_EQ(fs.mount(), Result::ok);
+
+        FileSize bw;
+        Obj* fil = fs.open(filename, paffs::FW | paffs::FC);
+        ASSERT_NE(fil, nullptr);
+        ASSERT_EQ(fs.write(*fil, text, sizeof(text), &bw), Result::ok);
+        ASSERT_EQ(fs.close(*fil), Result::ok);
+
+        auto journalEnd = [&]()
+        {
+            PageAbs end;
+            for (unsigned int i = 0; i < sizeof(PageAbs); i++)
+            {
+                reinterpret_cast<uint8_t*>(&end)[i] = mram->getByte(i);
+            }
+            return end;
+        };
+
+        // Journal space an append takes
+        PageAbs before = journalEnd();
+        fil = fs.open(filename, paffs::FW);
+        ASSERT_NE(fil, nullptr);
+        ASSERT_EQ(fs.seek(*fil, 0, Seekmode::end), Result::ok);
+        ASSERT_EQ(fs.write(*fil, data.get(), size, &bw), Result::ok);
+        ASSERT_EQ(fs.close(*fil), Result::ok);
+        ASSERT_GT(journalEnd(), before);
+        PageAbs growth = journalEnd() - before;
+        FileSize oldSize = sizeof(text) + size;
+
+        // Updating the modification time fills the journal without writing to flash,
+        // until the next append runs it full after its first segment
+        while (journalEnd() < mramJournalSize - reservedLogsize - growth / 4)
+        {
+            ASSERT_EQ(fs.touch(filename), Result::ok);
+        }
+
+        // Power goes out at the last failpoint before the flush and at each one after it
+        bool flushedBetweenSegments = false;
+        unsigned int powerLosses = 0;
+        PageAbs last = 0;
+        bool started = false;
+        bool checking = false;
+        stringstream flashImage;
+        stringstream mramImage;
+        failCallback = [&](const char* file, unsigned int, unsigned int)
+        {
+            if (checking || HasFailure() || strcmp(file, "dataIO.cpp") != 0)
+            {
+                return;
+            }
+            checking = true;
+            PageAbs now = journalEnd();
+            if (started && now < last && !flushedBetweenSegments)
+            {
+                flushedBetweenSegments = true;
+                checkInterruptedAppend(flashImage, mramImage, data.get(), oldSize, size);
+                powerLosses++;
+            }
+            started = true;
+            last = now;
+            flashImage.str("");
+            mramImage.str("");
+            fc->getDebugInterface()->serialize(flashImage);
+            mram->serialize(mramImage);
+            if (flushedBetweenSegments)
+            {
+                checkInterruptedAppend(flashImage, mramImage, data.get(), oldSize, size);
+                powerLosses++;
+            }
+            checking = false;
+        };
+        fil = fs.open(filename, paffs::FW);
+        ASSERT_NE(fil, nullptr);
+        ASSERT_EQ(fs.seek(*fil, 0, Seekmode::end), Result::ok);
+        Result r = fs.write(*fil, data.get(), size, &bw);
+        failCallback = nullptr;
+        ASSERT_EQ(r, Result::ok);
+        ASSERT_EQ(bw, size);
+        ASSERT_EQ(fs.close(*fil), Result::ok);
+
+        EXPECT_TRUE(flushedBetweenSegments);
+        EXPECT_GT(powerLosses, 1u);
+        ASSERT_EQ(fs.unmount(), Result::ok);
+    }
+}
+
+// Mounts the images taken at a power loss while /telemetry and /log were written in turns.
+// Page i of /telemetry holds i and page i of /log holds i + 64, starting behind the direct
+// addresses. No pages may be left behind after removing both files.
+static void
+checkInterleavedWriters(stringstream& flashImage, stringstream& mramImage,
+                        PageNo telemetryPages, PageNo logPages)
+{
+    static constexpr FileSize start = directAddrCount * dataBytesPerPage;
+    std::vector<paffs::Driver*> drv;
+    std::unique_ptr<FlashCell> fc(new FlashCell());
+    std::unique_ptr<Mram> mram(new Mram(mramSize));
+    drv.push_back(paffs::getDriverSpecial(0, fc.get(), mram.get()));
+    fc->getDebugInterface()->deserialize(flashImage);
+    mram->deserialize(mramImage);
+
+    Paffs fs(drv);
+    ASSERT_EQ(fs.mount(), Result::ok);
+    char buf[dataBytesPerPage];
+    char cmp[dataBytesPerPage];
+    FileSize br;
+    const char* names[] = {"/telemetry", "/log"};
+    PageNo pages[] = {telemetryPages, logPages};
+    for (unsigned int f = 0; f < 2; f++)
+    {
+        ObjInfo info;
+        ASSERT_EQ(fs.getObjInfo(names[f], info), Result::ok);
+        ASSERT_EQ(info.size, start + pages[f] * dataBytesPerPage);
+        Obj* fil = fs.open(names[f], FR);
+        ASSERT_NE(fil, nullptr);
+        for (PageNo i = 0; i < pages[f]; i++)
+        {
+            ASSERT_EQ(fs.seek(*fil, start + i * dataBytesPerPage), Result::ok);
+            ASSERT_EQ(fs.read(*fil, buf, sizeof(buf), &br), Result::ok);
+            ASSERT_EQ(br, sizeof(buf));
+            memset(cmp, i + f * 64, sizeof(cmp));
+            ASSERT_TRUE(ArraysMatch(buf, cmp, sizeof(cmp)));
+        }
+        ASSERT_EQ(fs.close(*fil), Result::ok);
+        ASSERT_EQ(fs.remove(names[f]), Result::ok);
+    }
+    Device* dev = fs.getDevice(0);
+    PageOffs usedPages = 0;
+    for (AreaPos area = 0; area < areasNo; area++)
+    {
+        if (dev->superblock.getType(area) == AreaType::data)
+        {
+            usedPages += dev->sumCache.getUsedPages(area);
+        }
+    }
+    // Only the root directory is left
+    EXPECT_LE(usedPages, 1u);
+    ASSERT_EQ(fs.unmount(), Result::ok);
+}
+
+TEST_F(JournalTest, BreakWithInterleavedWriters)
+{
+    static constexpr PageNo pages = 8;
+    static constexpr FileSize start = directAddrCount * dataBytesPerPage;
+    char buf[dataBytesPerPage];
+    FileSize bw;
+    stringstream flashImage[2];
+    stringstream mramImage[2];
+
+    std::vector<paffs::Driver*> drv;
+    std::unique_ptr<FlashCell> fc(new FlashCell());
+    std::unique_ptr<Mram> mram(new Mram(mramSize));
+    drv.push_back(paffs::getDriverSpecial(0, fc.get(), mram.get()));
+    {
+        Paffs fs(drv);
+        BadBlockList bbl[maxNumberOfDevices];
+        ASSERT_EQ(fs.format(bbl), Result::ok);
+        ASSERT_EQ(fs.mount(), Result::ok);
+
+        Obj* telemetry = fs.open("/telemetry", FW | FC);
+        ASSERT_NE(telemetry, nullptr);
+        Obj* log = fs.open("/log", FW | FC);
+        ASSERT_NE(log, nullptr);
+        for (PageNo i = 0; i < pages; i++)
+        {
+            memset(buf, i, sizeof(buf));
+            ASSERT_EQ(fs.seek(*telemetry, start + i * dataBytesPerPage), Result::ok);
+            ASSERT_EQ(fs.write(*telemetry, buf, sizeof(buf), &bw), Result::ok);
+            memset(buf, i + 64, sizeof(buf));
+            ASSERT_EQ(fs.seek(*log, start + i * dataBytesPerPage), Result::ok);
+            ASSERT_EQ(fs.write(*log, buf, sizeof(buf), &bw), Result::ok);
+        }
+        // The lists of both files are only in the journal
+        EXPECT_EQ(fs.getDevice(0)->dataIO.pac.getStatistics().pagesWritten, 0u);
+        fc->getDebugInterface()->serialize(flashImage[0]);
+        mram->serialize(mramImage[0]);
+
+        // Lists of /telemetry get committed while the ones of /log are still dirty
+        ASSERT_EQ(fs.close(*telemetry), Result::ok);
+        memset(buf, pages + 64, sizeof(buf));
+        ASSERT_EQ(fs.write(*log, buf, sizeof(buf), &bw), Result::ok);
+        fc->getDebugInterface()->serialize(flashImage[1]);
+        mram->serialize(mramImage[1]);
+
+        ASSERT_EQ(fs.close(*log), Result::ok);
+        ASSERT_EQ(fs.unmount(), Result::ok);
+    }
+    checkInterleavedWriters(flashImage[0], mramImage[0], pages, pages);
+    checkInterleavedWriters(flashImage[1], mramImage[1], pages, pages + 1);
+}
+
 void
 import()
 {
@@ -16,6 +16,7 @@
 
 #include "commonTest.hpp"
 
+#include <chrono>
 #include <iostream>
 #include <stdlib.h> /* srand, rand */
 #include <time.h>   /* time */
@@ -145,3 +146,134 @@ void seekAndReadCompare(Paffs& fs, Obj* fil, FileSize pos, char* buf, FileSize l
     ASSERT_EQ(r, Result::ok);
     ASSERT_TRUE(ArraysMatch(buf, cmp, len));
 }
+
+TEST_F(PageAddressCacheTest, interleavedWritersKeepTheirLists)
+{
+    Device* d = fs.getDevice(0);
+    static constexpr unsigned int pages = 20;
+    // Start behind the direct addresses, so every write needs the first indirection
+    const FileSize start = directAddrCount * dataBytesPerPage;
+    char buf[dataBytesPerPage];
+    char cmp[dataBytesPerPage];
+    Result r;
+
+    Obj* telemetry = fs.open("/telemetry", FW | FC);
+    ASSERT_NE(telemetry, nullptr);
+    Obj* log = fs.open("/log", FW | FC);
+    ASSERT_NE(log, nullptr);
+
+    d->dataIO.pac.resetStatistics();
+    for (unsigned int i = 0; i < pages; i++)
+    {
+        memset(buf, i, sizeof(buf));
+        seekAndWriteTo(fs, telemetry, start + i * dataBytesPerPage, buf, sizeof(buf));
+        memset(buf, i + pages, sizeof(buf));
+        seekAndWriteTo(fs, log, start + i * dataBytesPerPage, buf, sizeof(buf));
+    }
+    const PageAddressCacheStatistics& stats = d->dataIO.pac.getStatistics();
+    printf("PageAddressCache: %u hits, %u misses, %u evictions, %u list pages written\n",
+           stats.hits, stats.misses, stats.evictions, stats.pagesWritten);
+    EXPECT_GE(stats.hits, 2 * pages - 2);
+    EXPECT_EQ(stats.evictions, 0u);
+    // Switching between the writers does not commit their lists
+    EXPECT_EQ(stats.pagesWritten, 0u);
+
+    ASSERT_EQ(fs.close(*telemetry), Result::ok);
+    ASSERT_EQ(fs.close(*log), Result::ok);
+    // Each file commits its first indirection once
+    EXPECT_EQ(stats.pagesWritten, 2u);
+    r = fs.unmount();
+    ASSERT_EQ(r, Result::ok);
+    r = fs.mount();
+    ASSERT_EQ(r, Result::ok);
+
+    telemetry = fs.open("/telemetry", FR);
+    ASSERT_NE(telemetry, nullptr);
+    log = fs.open("/log", FR);
+    ASSERT_NE(log, nullptr);
+    for (unsigned int i = 0; i < pages; i++)
+    {
+        memset(cmp, i, sizeof(cmp));
+        seekAndReadCompare(fs, telemetry, start + i * dataBytesPerPage, buf, sizeof(buf), cmp);
+        memset(cmp, i + pages, sizeof(cmp));
+        seekAndReadCompare(fs, log, start + i * dataBytesPerPage, buf, sizeof(buf), cmp);
+    }
+    ASSERT_EQ(fs.close(*telemetry), Result::ok);
+    ASSERT_EQ(fs.close(*log), Result::ok);
+}
+
+/**
+ * Reads a file in quarter pages, once with the read cache and once with an empty cache
+ * before each read. Prints flash reads, bytes transferred and time of both.
+ */
+TEST_F(PageAddressCacheTest, repeatedReadsAreCached)
+{
+    Device* d = fs.getDevice(0);
+    ReadCache& cache = d->dataIO.readCache;
+    static constexpr PageNo pages = 20;
+    static constexpr FileSize chunk = dataBytesPerPage / 4;
+    char buf[dataBytesPerPage];
+    char cmp[dataBytesPerPage];
+
+    Obj* fil = fs.open("/recording", FW | FC);
+    ASSERT_NE(fil, nullptr);
+    for (PageNo i = 0; i < pages; i++)
+    {
+        memset(buf, i, sizeof(buf));
+        seekAndWriteTo(fs, fil, i * dataBytesPerPage, buf, sizeof(buf));
+    }
+    ASSERT_EQ(fs.close(*fil), Result::ok);
+
+    fil = fs.open("/recording", FR);
+    ASSERT_NE(fil, nullptr);
+    ReadCacheStatistics stats[2];
+    std::chrono::nanoseconds duration[2];
+    for (unsigned int cached = 0; cached < 2; cached++)
+    {
+        ASSERT_EQ(fs.seek(*fil, 0, Seekmode::set), Result::ok);
+        cache.clear();
+        cache.resetStatistics();
+        auto start = std::chrono::steady_clock::now();
+        FileSize br;
+        for (FileSize pos = 0; pos < pages * dataBytesPerPage; pos += chunk)
+        {
+            if (!cached)
+            {
+                cache.clear();
+            }
+            ASSERT_EQ(fs.read(*fil, buf, chunk, &br), Result::ok);
+            ASSERT_EQ(br, chunk);
+            memset(cmp, pos / dataBytesPerPage, chunk);
+            ASSERT_TRUE(ArraysMatch(buf, cmp, chunk));
+        }
+        duration[cached] = std::chrono::steady_clock::now() - start;
+        stats[cached] = cache.getStatistics();
+        printf("%s: %" PRIu32 " flash reads, %" PRIu32 " bytes, %lld us\n",
+               cached ? "cached" : "uncached", stats[cached].misses, stats[cached].readBytes,
+               static_cast<long long>(duration[cached].count() / 1000));
+    }
+    // Without cache, every read transfers the page up to its end, as before the cache
+    EXPECT_EQ(stats[0].misses, pages * 4);
+    EXPECT_EQ(stats[0].readBytes, pages * (chunk + 2 * chunk + 3 * chunk + 4 * chunk));
+    // The first read of a page only transfers its beginning, the second one the whole page
+    EXPECT_EQ(stats[1].misses, pages * 2);
+    EXPECT_EQ(stats[1].hits, pages * 2);
+    EXPECT_EQ(stats[1].readBytes, pages * (chunk + dataBytesPerPage));
+
+    // A single small read transfers no more than it needs
+    cache.clear();
+    cache.resetStatistics();
+    memset(cmp, 3, sizeof(cmp));
+    seekAndReadCompare(fs, fil, 3 * dataBytesPerPage, buf, chunk, cmp);
+    EXPECT_EQ(cache.getStatistics().readBytes, chunk);
+    ASSERT_EQ(fs.close(*fil), Result::ok);
+
+    // A cached page is not returned after it was overwritten
+    fil = fs.open("/recording", FW);
+    ASSERT_NE(fil, nullptr);
+    memset(buf, 0xAA, sizeof(buf));
+    seekAndWriteTo(fs, fil, 4 * dataBytesPerPage, buf, sizeof(buf));
+    memset(cmp, 0xAA, sizeof(cmp));
+    seekAndReadCompare(fs, fil, 4 * dataBytesPerPage, buf, sizeof(buf), cmp);
+    ASSERT_EQ(fs.close(*fil), Result::ok);
+}
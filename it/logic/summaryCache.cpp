@@ -15,6 +15,7 @@
 
 #include "../../src/driver/simu.hpp"
 #include "commonTest.hpp"
+#include <chrono>
 #include <paffs.hpp>
 #include <stdio.h>
 #include <stdlib.h>
@@ -156,6 +157,9 @@ public:
 void
 fillFlashAndVerify(paffs::Paffs& fs);
 
+void
+verifyPageCounters(paffs::Paffs& fs);
+
 TEST_F(SummaryCache, fillFlashAndVerify)
 {
     fillFlashAndVerify(fs);
@@ -248,10 +252,12 @@ fillFlashAndVerify(paffs::Paffs& fs)
                 | PAFFS_TRACE_VERBOSE);*/
 
     ASSERT_EQ(r, paffs::Result::ok);
+    verifyPageCounters(fs);
     r = fs.unmount();
     ASSERT_EQ(r, paffs::Result::ok);
     r = fs.mount();
     ASSERT_EQ(r, paffs::Result::ok);
+    verifyPageCounters(fs);
 
     // second check, after remount
     i = ic;
@@ -276,3 +282,135 @@ fillFlashAndVerify(paffs::Paffs& fs)
         j = 100;
     }
 }
+
+void
+verifyPageCounters(paffs::Paffs& fs)
+{
+    paffs::Device* dev = fs.getDevice(0);
+    for (paffs::AreaPos area = 1; area < paffs::areasNo; area++)
+    {
+        if (dev->superblock.getType(area) != paffs::AreaType::data
+            && dev->superblock.getType(area) != paffs::AreaType::index)
+        {
+            continue;
+        }
+        paffs::TwoBitList<paffs::dataPagesPerArea> summary;
+        ASSERT_EQ(dev->sumCache.getSummaryStatus(area, summary), paffs::Result::ok);
+        paffs::PageOffs dirty = 0, used = 0;
+        for (paffs::PageOffs page = 0; page < paffs::dataPagesPerArea; page++)
+        {
+            paffs::SummaryEntry e = paffs::AreaSummaryElem::getStatus(page, summary);
+            dirty += e == paffs::SummaryEntry::dirty ? 1 : 0;
+            used += e == paffs::SummaryEntry::used ? 1 : 0;
+        }
+        EXPECT_EQ(dev->sumCache.getDirtyPages(area), dirty) << "Area " << area;
+        EXPECT_EQ(dev->sumCache.getUsedPages(area), used) << "Area " << area;
+    }
+}
+
+/**
+ * Times the page status lookups of cached areas, which happen for every written page.
+ */
+TEST_F(SummaryCache, pageStatusLookupSpeed)
+{
+    static constexpr unsigned int lookups = 1000000;
+    paffs::Device* dev = fs.getDevice(0);
+    uint8_t buf[paffs::dataBytesPerPage * 4];
+    unsigned int bw;
+    memset(buf, 0xAA, sizeof(buf));
+
+    paffs::Obj* fil = fs.open("/file", paffs::FC);
+    ASSERT_NE(fil, nullptr);
+    ASSERT_EQ(fs.write(*fil, buf, sizeof(buf), &bw), paffs::Result::ok);
+    ASSERT_EQ(fs.close(*fil), paffs::Result::ok);
+
+    paffs::AreaPos area = dev->superblock.getActiveArea(paffs::AreaType::data);
+    ASSERT_NE(area, 0);
+    paffs::Result r;
+    unsigned int usedPages = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < lookups; i++)
+    {
+        if (dev->sumCache.getPageStatus(area, i % paffs::dataPagesPerArea, r)
+            == paffs::SummaryEntry::used)
+        {
+            usedPages++;
+        }
+    }
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start);
+    ASSERT_EQ(r, paffs::Result::ok);
+    EXPECT_GT(usedPages, 0u);
+    printf("%u page status lookups: %.1f ns per lookup\n",
+           lookups, static_cast<double>(duration.count()) / lookups);
+}
+
+/**
+ * Reads and overwrites random pages of two hot files, scanning the cold ones now and then.
+ * More areas are touched than fit into the cache, so summaries are evicted and reloaded,
+ * but garbage collection never has to free cache space.
+ */
+TEST_F(SummaryCache, mixedWorkloadReplacement)
+{
+    static constexpr unsigned int files = 8;
+    static constexpr unsigned int pagesPerFile = paffs::dataPagesPerArea;
+    static constexpr unsigned int operations = 20000;
+    paffs::Device* dev = fs.getDevice(0);
+    uint8_t buf[paffs::dataBytesPerPage];
+    unsigned int bw;
+    char filename[20];
+    paffs::Obj* fil[files];
+
+    for (unsigned int f = 0; f < files; f++)
+    {
+        sprintf(filename, "/file%u", f);
+        fil[f] = fs.open(filename, paffs::FC);
+        ASSERT_NE(fil[f], nullptr);
+        memset(buf, f, sizeof(buf));
+        for (unsigned int p = 0; p < pagesPerFile; p++)
+        {
+            ASSERT_EQ(fs.write(*fil[f], buf, sizeof(buf), &bw), paffs::Result::ok);
+        }
+    }
+    dev->sumCache.resetStatistics();
+
+    srand(1);
+    for (unsigned int i = 0; i < operations; i++)
+    {
+        if (i % 64 == 63)
+        {
+            for (unsigned int f = 2; f < files; f++)
+            {
+                ASSERT_EQ(fs.seek(*fil[f], (rand() % pagesPerFile) * paffs::dataBytesPerPage),
+                          paffs::Result::ok);
+                ASSERT_EQ(fs.read(*fil[f], buf, sizeof(buf), &bw), paffs::Result::ok);
+            }
+        }
+        unsigned int f = rand() % 2;
+        ASSERT_EQ(fs.seek(*fil[f], (rand() % pagesPerFile) * paffs::dataBytesPerPage),
+                  paffs::Result::ok);
+        if (f == 0 && i % 4 == 0)
+        {
+            memset(buf, i, sizeof(buf));
+            ASSERT_EQ(fs.write(*fil[f], buf, sizeof(buf), &bw), paffs::Result::ok);
+        }
+        else
+        {
+            ASSERT_EQ(fs.read(*fil[f], buf, sizeof(buf), &bw), paffs::Result::ok);
+        }
+    }
+    for (unsigned int f = 0; f < files; f++)
+    {
+        ASSERT_EQ(fs.close(*fil[f]), paffs::Result::ok);
+    }
+
+    const paffs::SummaryCacheStatistics& stats = dev->sumCache.getStatistics();
+    printf("%u hits, %u misses, %u evictions, %u collections, %u hard commits\n",
+           stats.hits, stats.misses, stats.evictions, stats.collections, stats.hardCommits);
+    EXPECT_GT(stats.hits, stats.misses);
+    // The cold areas can always be evicted instead of relocating one
+    EXPECT_GT(stats.evictions, 0u);
+    EXPECT_EQ(stats.collections, 0u);
+    EXPECT_EQ(stats.hardCommits, 0u);
+    verifyPageCounters(fs);
+}
@@ -22,9 +22,16 @@ class TreeTest : public InitFs
 
 TEST_F(TreeTest, Sizes)
 {
-    EXPECT_LE(sizeof(paffs::TreeNode), paffs::dataBytesPerPage);
     EXPECT_LE(paffs::leafOrder * sizeof(paffs::Inode), sizeof(paffs::TreeNode));
     EXPECT_LE(paffs::branchOrder * sizeof(paffs::Addr), sizeof(paffs::TreeNode));
+    // Leaves are packed on flash, so more inodes fit than their in-memory size suggests
+    EXPECT_GT(paffs::leafOrder,
+              (paffs::dataBytesPerPage - paffs::treeNodeHeaderSize)
+              / (sizeof(paffs::Inode) + sizeof(paffs::InodeNo)));
+    // Cached nodes only add a small link table to the raw node
+    EXPECT_LE(sizeof(paffs::TreeCacheNode),
+              sizeof(paffs::TreeNode) + (paffs::branchOrder + 2) * sizeof(paffs::TreeCacheLink)
+              + alignof(paffs::TreeNode));
 }
 
 TEST_F(TreeTest, handleMoreThanCacheLimit)
@@ -172,3 +179,454 @@ TEST_F(TreeTest, redistributeTree)
         d->journal.clear();
     }
 }
+
+TEST_F(TreeTest, inodeCacheServesRepeatedPathLookups)
+{
+    paffs::Device* d = fs.getDevice(0);
+    paffs::Result r;
+    paffs::ObjInfo info;
+    const char* dirs[] = {"/a", "/a/b", "/a/b/c", "/a/b/c/d"};
+    for (const char* dir : dirs)
+    {
+        r = fs.mkDir(dir, paffs::R | paffs::W);
+        ASSERT_EQ(r, paffs::Result::ok);
+    }
+    r = fs.touch("/a/b/c/d/file");
+    ASSERT_EQ(r, paffs::Result::ok);
+
+    d->tree.mInodeCache.resetStatistics();
+    for (unsigned int i = 0; i < 20; i++)
+    {
+        r = fs.getObjInfo("/a/b/c/d/file", info);
+        ASSERT_EQ(r, paffs::Result::ok);
+    }
+    const paffs::InodeCacheStatistics& stats = d->tree.mInodeCache.getStatistics();
+    // Root, four directories and the file; all were touched while creating them
+    EXPECT_EQ(stats.misses, 0u);
+    EXPECT_GE(stats.hits, 20u * 6);
+}
+
+TEST_F(TreeTest, inodeCacheStaysCoherent)
+{
+    paffs::Device* d = fs.getDevice(0);
+    paffs::Result r;
+    const unsigned int numberOfInodes = paffs::inodeCacheSize * 3;
+
+    d->journal.clear();
+    for (unsigned int i = 1; i <= numberOfInodes; i++)
+    {
+        paffs::Inode test;
+        memset(&test, 0, sizeof(paffs::Inode));
+        test.no = i;
+        r = d->tree.insertInode(test);
+        ASSERT_EQ(r, paffs::Result::ok);
+        d->journal.clear();
+    }
+    // Update in an order that keeps evicting the cached copies
+    for (unsigned int round = 1; round <= 3; round++)
+    {
+        for (unsigned int i = 1; i <= numberOfInodes; i++)
+        {
+            paffs::Inode test;
+            r = d->tree.getInode(i, test);
+            ASSERT_EQ(r, paffs::Result::ok);
+            ASSERT_EQ(test.size, (round - 1) * i);
+            test.size = round * i;
+            r = d->tree.updateExistingInode(test);
+            ASSERT_EQ(r, paffs::Result::ok);
+            d->journal.clear();
+        }
+    }
+    for (unsigned int i = 1; i <= numberOfInodes; i += 2)
+    {
+        r = d->tree.deleteInode(i);
+        ASSERT_EQ(r, paffs::Result::ok);
+        d->journal.clear();
+    }
+    for (unsigned int i = 1; i <= numberOfInodes; i++)
+    {
+        paffs::Inode test;
+        r = d->tree.getInode(i, test);
+        if (i % 2 == 1)
+        {
+            ASSERT_EQ(r, paffs::Result::notFound);
+            continue;
+        }
+        ASSERT_EQ(r, paffs::Result::ok);
+        ASSERT_EQ(test.size, 3 * i);
+        // Cached copy has to match the one in the tree
+        paffs::Inode fromTree;
+        r = d->tree.getInodeFromTree(i, fromTree);
+        ASSERT_EQ(r, paffs::Result::ok);
+        ASSERT_EQ(memcmp(&test, &fromTree, sizeof(paffs::Inode)), 0);
+    }
+}
+
+/**
+ * Runs insert, lookup and delete mixes against the tree and prints the cache telemetry.
+ * treeNodeCacheSize is a compile time constant, so sweeping it means rebuilding with
+ * another configuration and comparing the printed lines. The printed cache footprint
+ * allows comparing configurations at the same memory budget.
+ */
+TEST_F(TreeTest, cacheSizeBenchmark)
+{
+    static constexpr unsigned int numberOfInodes = paffs::leafOrder * paffs::branchOrder;
+    static constexpr unsigned int operations = 5000;
+    static const struct
+    {
+        const char* name;
+        unsigned int insertPercent;
+        unsigned int deletePercent;
+        unsigned int hotPercent;  // operations going to the first eighth of the inodes
+    } mixes[] = {{"lookup", 0, 0, 0},
+                 {"skewed lookup", 0, 0, 80},
+                 {"insert/lookup", 30, 0, 0},
+                 {"insert/lookup/delete", 25, 25, 0},
+                 {"skewed insert/lookup/delete", 25, 25, 80}};
+    paffs::Device* d = fs.getDevice(0);
+    paffs::Result r;
+    bool present[numberOfInodes + 1] = {false};
+
+    srand(1);
+    for (const auto& mix : mixes)
+    {
+        d->tree.mCache.resetStatistics();
+        for (unsigned int i = 0; i < operations; i++)
+        {
+            unsigned int op = rand() % 100;
+            paffs::InodeNo no = 1 + rand() % numberOfInodes;
+            if (static_cast<unsigned int>(rand() % 100) < mix.hotPercent)
+            {
+                no = 1 + rand() % (numberOfInodes / 8);
+            }
+            paffs::Inode test;
+            if (!present[no] && (op < mix.insertPercent || i < numberOfInodes / 2))
+            {
+                memset(&test, 0, sizeof(paffs::Inode));
+                test.no = no;
+                r = d->tree.insertInode(test);
+                ASSERT_EQ(r, paffs::Result::ok);
+                present[no] = true;
+            }
+            else if (present[no] && op >= 100 - mix.deletePercent)
+            {
+                r = d->tree.deleteInode(no);
+                ASSERT_EQ(r, paffs::Result::ok);
+                present[no] = false;
+            }
+            else
+            {
+                r = d->tree.getInodeFromTree(no, test);
+                ASSERT_EQ(r, present[no] ? paffs::Result::ok : paffs::Result::notFound);
+            }
+            d->journal.clear();
+        }
+        ASSERT_TRUE(d->tree.mCache.isTreeCacheValid());
+        const paffs::TreeCacheStatistics& stats = d->tree.mCache.getStatistics();
+        printf("treeNodeCacheSize %u (%u byte), %s: %u hits, %u misses, %u evictions, "
+               "%u forced commits\n",
+               paffs::treeNodeCacheSize,
+               static_cast<unsigned int>(paffs::treeNodeCacheSize * sizeof(paffs::TreeCacheNode)),
+               mix.name, stats.hits, stats.misses, stats.evictions, stats.forcedCommits);
+        EXPECT_GT(stats.hits, stats.misses);
+    }
+}
+
+TEST_F(TreeTest, nextFreeInodeNumber)
+{
+    paffs::Device* d = fs.getDevice(0);
+    paffs::Result r;
+    paffs::InodeNo no;
+    const unsigned int numberOfInodes = paffs::leafOrder * 3;
+
+    d->journal.clear();
+    for (unsigned int i = 1; i <= numberOfInodes; i++)
+    {
+        paffs::Inode test;
+        memset(&test, 0, sizeof(paffs::Inode));
+        test.no = i;
+        r = d->tree.insertInode(test);
+        ASSERT_EQ(r, paffs::Result::ok);
+        d->journal.clear();
+        r = d->tree.findFirstFreeNo(&no);
+        ASSERT_EQ(r, paffs::Result::ok);
+        ASSERT_EQ(no, i + 1);
+    }
+
+    // Repeated allocations do not touch the tree
+    d->tree.mCache.resetStatistics();
+    for (unsigned int i = 0; i < 100; i++)
+    {
+        r = d->tree.findFirstFreeNo(&no);
+        ASSERT_EQ(r, paffs::Result::ok);
+        ASSERT_EQ(no, numberOfInodes + 1);
+    }
+    EXPECT_EQ(d->tree.mCache.getStatistics().hits, 0u);
+    EXPECT_EQ(d->tree.mCache.getStatistics().misses, 0u);
+
+    // Removing a number below the highest keeps it
+    r = d->tree.deleteInode(3);
+    ASSERT_EQ(r, paffs::Result::ok);
+    d->journal.clear();
+    ASSERT_EQ(d->tree.findFirstFreeNo(&no), paffs::Result::ok);
+    EXPECT_EQ(no, numberOfInodes + 1);
+
+    // Removing the highest one hands it out again
+    r = d->tree.deleteInode(numberOfInodes);
+    ASSERT_EQ(r, paffs::Result::ok);
+    d->journal.clear();
+    ASSERT_EQ(d->tree.findFirstFreeNo(&no), paffs::Result::ok);
+    EXPECT_EQ(no, numberOfInodes);
+
+    paffs::Inode test;
+    memset(&test, 0, sizeof(paffs::Inode));
+    test.no = numberOfInodes + 5;
+    r = d->tree.insertInode(test);
+    ASSERT_EQ(r, paffs::Result::ok);
+    d->journal.clear();
+    ASSERT_EQ(d->tree.findFirstFreeNo(&no), paffs::Result::ok);
+    EXPECT_EQ(no, numberOfInodes + 6);
+}
+
+TEST_F(TreeTest, commitWritesSequentialRun)
+{
+    paffs::Device* d = fs.getDevice(0);
+    paffs::Result r;
+    // Root inode is already in the tree. Splits leave half full leaves behind, so this fills
+    // a root with treeNodeCacheSize - 1 leaves, the last one full.
+    const unsigned int numberOfInodes =
+            (paffs::treeNodeCacheSize - 2) * ((paffs::leafOrder + 1) / 2) + paffs::leafOrder - 1;
+
+    for (unsigned int i = 1; i <= numberOfInodes; i++)
+    {
+        paffs::Inode test;
+        memset(&test, 0, sizeof(paffs::Inode));
+        test.no = i;
+        r = d->tree.insertInode(test);
+        ASSERT_EQ(r, paffs::Result::ok);
+        d->journal.clear();
+    }
+    ASSERT_EQ(d->tree.commitCache(), paffs::Result::ok);
+
+    // Dirty every leaf (and thereby the root) again
+    for (unsigned int i = 1; i <= numberOfInodes; i++)
+    {
+        paffs::Inode test;
+        ASSERT_EQ(d->tree.getInode(i, test), paffs::Result::ok);
+        test.size = i;
+        ASSERT_EQ(d->tree.updateExistingInode(test), paffs::Result::ok);
+        d->journal.clear();
+    }
+    ASSERT_EQ(d->tree.commitCache(), paffs::Result::ok);
+
+    paffs::TreeCacheNode* root;
+    ASSERT_EQ(d->tree.mCache.getRootNodeFromCache(root), paffs::Result::ok);
+    ASSERT_FALSE(root->raw.isLeaf);
+    ASSERT_EQ(root->raw.keys + 1u, paffs::treeNodeCacheSize - 1u);
+
+    // Children are written in order followed by the root, at most interrupted by an area change
+    unsigned int breaks = 0;
+    for (uint16_t i = 0; i <= root->raw.keys; i++)
+    {
+        paffs::Addr prev = root->raw.as.branch.pointers[i];
+        paffs::Addr next =
+                i < root->raw.keys ? root->raw.as.branch.pointers[i + 1] : root->raw.self;
+        if (paffs::extractLogicalArea(prev) != paffs::extractLogicalArea(next)
+            || paffs::extractPageOffs(prev) + 1 != paffs::extractPageOffs(next))
+        {
+            breaks++;
+        }
+    }
+    EXPECT_LE(breaks, 1u);
+    ASSERT_TRUE(d->tree.mCache.isTreeCacheValid());
+}
+
+TEST_F(TreeTest, inodeCursorWalksInOrder)
+{
+    paffs::Device* d = fs.getDevice(0);
+    paffs::Result r;
+    // Every third number, enough for several leaves
+    const unsigned int numberOfInodes = paffs::leafOrder * 4;
+    paffs::InodeCursor cursor;
+    paffs::Inode inode;
+
+    d->journal.clear();
+    for (unsigned int i = 1; i <= numberOfInodes; i++)
+    {
+        memset(&inode, 0, sizeof(paffs::Inode));
+        inode.no = i * 3;
+        r = d->tree.insertInode(inode);
+        ASSERT_EQ(r, paffs::Result::ok);
+        d->journal.clear();
+    }
+
+    // Root inode first, then all others
+    d->tree.mCache.resetStatistics();
+    unsigned int count = 0;
+    d->tree.openCursor(cursor);
+    while ((r = d->tree.nextInode(cursor, inode)) == paffs::Result::ok)
+    {
+        ASSERT_EQ(inode.no, count * 3);
+        count++;
+    }
+    ASSERT_EQ(r, paffs::Result::notFound);
+    ASSERT_EQ(count, numberOfInodes + 1);
+    // One descent per leaf instead of per inode
+    const paffs::TreeCacheStatistics& stats = d->tree.mCache.getStatistics();
+    EXPECT_LT(stats.hits + stats.misses, count);
+    ASSERT_TRUE(d->tree.mCache.isTreeCacheValid());
+
+    // Starting in between, while the tree changes under the cursor
+    d->tree.openCursor(cursor, 10);
+    ASSERT_EQ(d->tree.nextInode(cursor, inode), paffs::Result::ok);
+    EXPECT_EQ(inode.no, 12u);
+    r = d->tree.deleteInode(15);
+    ASSERT_EQ(r, paffs::Result::ok);
+    memset(&inode, 0, sizeof(paffs::Inode));
+    inode.no = 16;
+    r = d->tree.insertInode(inode);
+    ASSERT_EQ(r, paffs::Result::ok);
+    d->journal.clear();
+    ASSERT_EQ(d->tree.nextInode(cursor, inode), paffs::Result::ok);
+    EXPECT_EQ(inode.no, 16u);
+    ASSERT_EQ(d->tree.nextInode(cursor, inode), paffs::Result::ok);
+    EXPECT_EQ(inode.no, 18u);
+
+    // Filling the cursor leaf until it splits
+    for (unsigned int i = 0; i < paffs::leafOrder; i++)
+    {
+        memset(&inode, 0, sizeof(paffs::Inode));
+        inode.no = numberOfInodes * 3 + 1 + i;
+        r = d->tree.insertInode(inode);
+        ASSERT_EQ(r, paffs::Result::ok);
+        d->journal.clear();
+    }
+    unsigned int last = 18;
+    count = 0;
+    while ((r = d->tree.nextInode(cursor, inode)) == paffs::Result::ok)
+    {
+        ASSERT_GT(inode.no, last);
+        last = inode.no;
+        count++;
+    }
+    ASSERT_EQ(r, paffs::Result::notFound);
+    EXPECT_EQ(last, numberOfInodes * 3 + paffs::leafOrder);
+    EXPECT_EQ(count, numberOfInodes - 6 + paffs::leafOrder);
+    ASSERT_TRUE(d->tree.mCache.isTreeCacheValid());
+
+    // Closing early releases the leaf
+    d->tree.openCursor(cursor);
+    ASSERT_EQ(d->tree.nextInode(cursor, inode), paffs::Result::ok);
+    d->tree.closeCursor(cursor);
+    for (unsigned int i = 1; i <= numberOfInodes; i++)
+    {
+        r = d->tree.deleteInode(i * 3);
+        ASSERT_THAT(r, testing::AnyOf(testing::Eq(paffs::Result::ok),
+                                      testing::Eq(paffs::Result::notFound)));
+        d->journal.clear();
+    }
+    ASSERT_TRUE(d->tree.mCache.isTreeCacheValid());
+}
+
+TEST_F(TreeTest, insertIntoCursorLeaf)
+{
+    paffs::Device* d = fs.getDevice(0);
+    paffs::Result r;
+    // More leaves than the cache can hold
+    const unsigned int numberOfInodes = paffs::leafOrder * paffs::treeNodeCacheSize;
+    paffs::InodeCursor cursor;
+    paffs::Inode inode;
+
+    d->journal.clear();
+    for (unsigned int i = 1; i <= numberOfInodes; i++)
+    {
+        memset(&inode, 0, sizeof(paffs::Inode));
+        inode.no = i * 3;
+        r = d->tree.insertInode(inode);
+        ASSERT_EQ(r, paffs::Result::ok);
+        d->journal.clear();
+    }
+    // Leaves room in the first leaf, so the insertion below does not split it
+    r = d->tree.deleteInode(6);
+    ASSERT_EQ(r, paffs::Result::ok);
+    d->journal.clear();
+
+    d->tree.openCursor(cursor);
+    ASSERT_EQ(d->tree.nextInode(cursor, inode), paffs::Result::ok);
+    EXPECT_EQ(inode.no, 0u);
+    ASSERT_TRUE(cursor.leaf->locked);
+    memset(&inode, 0, sizeof(paffs::Inode));
+    inode.no = 1;
+    r = d->tree.insertInode(inode);
+    ASSERT_EQ(r, paffs::Result::ok);
+    d->journal.clear();
+
+    // The insertion unlocked the leaf, so the cursor may not use it anymore
+    for (unsigned int i = numberOfInodes; i > numberOfInodes / 2; i--)
+    {
+        r = d->tree.getInode(i * 3, inode);
+        ASSERT_EQ(r, paffs::Result::ok);
+    }
+    d->tree.mCache.resetStatistics();
+    ASSERT_EQ(d->tree.nextInode(cursor, inode), paffs::Result::ok);
+    EXPECT_EQ(inode.no, 1u);
+    const paffs::TreeCacheStatistics& stats = d->tree.mCache.getStatistics();
+    EXPECT_GT(stats.hits + stats.misses, 0u);
+    ASSERT_EQ(d->tree.nextInode(cursor, inode), paffs::Result::ok);
+    EXPECT_EQ(inode.no, 3u);
+    ASSERT_EQ(d->tree.nextInode(cursor, inode), paffs::Result::ok);
+    EXPECT_EQ(inode.no, 9u);
+    d->tree.closeCursor(cursor);
+    ASSERT_TRUE(d->tree.mCache.isTreeCacheValid());
+}
+
+TEST_F(TreeTest, encodedNodesRoundTrip)
+{
+    paffs::TreeNode leaf, branch, decoded;
+    uint8_t buf[paffs::dataBytesPerPage];
+
+    memset(&leaf, 0, sizeof(paffs::TreeNode));
+    leaf.self = 1234;
+    leaf.isLeaf = true;
+    leaf.keys = paffs::leafOrder;
+    for (uint16_t i = 0; i < paffs::leafOrder; i++)
+    {
+        paffs::Inode& inode = leaf.as.leaf.pInodes[i];
+        inode.no = 100 + i;
+        inode.type = paffs::InodeType::dir;
+        inode.perm = paffs::R | paffs::X;
+        inode.reservedPages = i;
+        inode.size = 0xDEAD0000 + i;
+        inode.crea = 0x123456789ABCull;
+        inode.mod = inode.crea + i;
+        for (uint16_t j = 0; j < paffs::directAddrCount; j++)
+        {
+            inode.direct[j] = i * 100 + j;
+        }
+        inode.indir = 1;
+        inode.d_indir = 2;
+        inode.t_indir = 3;
+        leaf.as.leaf.keys[i] = inode.no;
+    }
+    uint16_t len = paffs::TreeCache::encodeTreeNode(leaf, buf);
+    EXPECT_EQ(len, paffs::treeNodeHeaderSize + paffs::leafOrder * paffs::packedInodeSize);
+    paffs::TreeCache::decodeTreeNode(buf, decoded);
+    ASSERT_EQ(memcmp(&leaf, &decoded, sizeof(paffs::TreeNode)), 0);
+
+    memset(&branch, 0, sizeof(paffs::TreeNode));
+    branch.self = 4321;
+    branch.isLeaf = false;
+    branch.keys = paffs::branchOrder - 1;
+    for (uint16_t i = 0; i < paffs::branchOrder; i++)
+    {
+        if (i < paffs::branchOrder - 1)
+        {
+            branch.as.branch.keys[i] = i * 7;
+        }
+        branch.as.branch.pointers[i] = i * 11;
+    }
+    len = paffs::TreeCache::encodeTreeNode(branch, buf);
+    EXPECT_LE(len, paffs::dataBytesPerPage);
+    paffs::TreeCache::decodeTreeNode(buf, decoded);
+    ASSERT_EQ(memcmp(&branch, &decoded, sizeof(paffs::TreeNode)), 0);
+}
@@ -26,7 +26,7 @@ const char* areaNames[] = {
         "UNSET", "SBLOCK", "JOURNAL", "INDEX", "DATA", "GC", "RETIRED",
         "YOUSHOULDNOTBESEEINGTHIS"};
 
-const char* areaStatusNames[] = {"CLOSED", "ACTIVE", "EMPTY"};
+const char* areaStatusNames[] = {"CLOSED", "ACTIVE", "EMPTY", "PENDING"};
 
 const char* summaryEntryNames[] = {
         "FREE", "USED", "DIRTY", "ERROR",
@@ -135,6 +135,17 @@ AreaManagement::findWritableArea(AreaType areaType)
         return dev->superblock.getActiveArea(areaType);
     }
 
+    // Queued erases are done on demand if there was no idle time to do them
+    if (dev->superblock.getUsedAreas() >= areasNo - minFreeAreas)
+    {
+        AreaPos queued = findQueuedErase();
+        if (queued != 0 && deleteArea(queued) != Result::ok)
+        {
+            PAFFS_DBG_S(PAFFS_TRACE_AREA,
+                        "Could not erase queued Area %" PTYPE_AREAPOS, queued);
+        }
+    }
+
     AreaPos secondBestArea = 0;
     uint32_t secondBestAreasDeletions = 0;
     if (dev->superblock.getUsedAreas() < areasNo - minFreeAreas)
@@ -178,7 +189,25 @@ AreaManagement::findWritableArea(AreaType areaType)
         PAFFS_DBG_S(PAFFS_TRACE_AREA, "FindWritableArea ignored reserved area");
     }
 
-    Result r = gc.collectGarbage(areaType);
+    // Areas compacted by the incremental garbage collection can be used without moving data
+    Result r = gc.finishPendingCollection();
+    if (r != Result::ok)
+    {
+        dev->lasterr = r;
+        return 0;
+    }
+    AreaPos compacted = gc.findCompactedArea(areaType);
+    if (compacted != 0)
+    {
+        initAreaAs(compacted, areaType);
+        PAFFS_DBG_S(PAFFS_TRACE_AREA,
+                    "Found compacted Area %" PTYPE_AREAPOS " for %s",
+                    compacted,
+                    areaNames[areaType]);
+        return compacted;
+    }
+
+    r = gc.collectGarbage(areaType);
     if (r != Result::ok)
     {
         dev->lasterr = r;
@@ -223,7 +252,11 @@ AreaManagement::findWritableArea(AreaType areaType)
 Result
 AreaManagement::findFirstFreePage(PageOffs& page, AreaPos area)
 {
-    Result r;
+    Result r = dev->sumCache.findFirstFreePage(page, area);
+    if (r != Result::notFound)
+    {
+        return r;
+    }
     for (PageOffs i = 0; i < dataPagesPerArea; i++)
     {
         if (dev->sumCache.getPageStatus(area, i, r) == SummaryEntry::free)
@@ -477,6 +510,191 @@ AreaManagement::deleteArea(AreaPos area)
     return r;
 }
 
+Result
+AreaManagement::queueErase(AreaPos area)
+{
+    if (area >= areasNo)
+    {
+        PAFFS_DBG(PAFFS_TRACE_BUG,
+                  "Invalid area! "
+                  "Was %" PTYPE_AREAPOS ", should < %" PTYPE_AREAPOS,
+                  area,
+                  areasNo);
+        return Result::bug;
+    }
+    if (dev->superblock.getType(area) == AreaType::retired
+        || dev->superblock.getStatus(area) == AreaStatus::active)
+    {
+        PAFFS_DBG(PAFFS_TRACE_BUG,
+                  "Tried queueing %s area %" PTYPE_AREAPOS " for erasure!",
+                  areaStatusNames[dev->superblock.getStatus(area)],
+                  area);
+        return Result::bug;
+    }
+    FAILPOINT;
+    dev->journal.addEvent(journalEntry::areaMgmt::QueueErase(area));
+    FAILPOINT;
+    dev->sumCache.deleteSummary(area);
+    if (dev->superblock.getStatus(area) == AreaStatus::empty)
+    {
+        FAILPOINT;
+        dev->superblock.increaseUsedAreas();
+    }
+    FAILPOINT;
+    dev->superblock.setStatus(area, AreaStatus::erasePending);
+    FAILPOINT;
+    dev->superblock.setType(area, AreaType::unset);
+    FAILPOINT;
+    dev->journal.addEvent(journalEntry::Checkpoint(getTopic()));
+    PAFFS_DBG_S(PAFFS_TRACE_AREA, "Info: Queued Area %" PTYPE_AREAPOS
+                " at pos. %" PTYPE_AREAPOS " for erasure.", area, dev->superblock.getPos(area));
+
+    if (getErasedAreas() < mEraseWatermark)
+    {
+        return deleteArea(area);
+    }
+    return Result::ok;
+}
+
+Result
+AreaManagement::replaceByErasedArea(AreaPos area)
+{
+    AreaPos erased = findErasedArea();
+    if (erased == 0)
+    {
+        return Result::notFound;
+    }
+    // The erased area is queued before it gets the old contents,
+    // so it is never marked as empty while holding them.
+    Result r = queueErase(erased);
+    if (r != Result::ok)
+    {
+        return r;
+    }
+    FAILPOINT;
+    dev->superblock.swapAreaPosition(area, erased);
+    PAFFS_DBG_S(PAFFS_TRACE_AREA, "Info: Area %" PTYPE_AREAPOS " got erased pos. %" PTYPE_AREAPOS
+                ", old contents are queued in Area %" PTYPE_AREAPOS ".",
+                area, dev->superblock.getPos(area), erased);
+    return Result::ok;
+}
+
+AreaPos
+AreaManagement::findErasedArea()
+{
+    if (getErasedAreas() <= mEraseWatermark)
+    {
+        return 0;
+    }
+    AreaPos favouriteArea = 0;
+    uint32_t favErases = ~0;
+    for (AreaPos area = 0; area < areasNo; area++)
+    {
+        if (dev->superblock.getStatus(area) == AreaStatus::empty
+            && dev->superblock.getType(area) != AreaType::retired
+            && dev->superblock.getErasecount(area) < favErases)
+        {
+            favouriteArea = area;
+            favErases = dev->superblock.getErasecount(area);
+        }
+    }
+    return favouriteArea;
+}
+
+Result
+AreaManagement::eraseQueuedAreas(AreaPos maxAreas, bool& idle)
+{
+    idle = false;
+    for (AreaPos erased = 0; erased < maxAreas; erased++)
+    {
+        AreaPos area = findQueuedErase();
+        if (area == 0)
+        {
+            area = findCompletelyDirtyArea();
+        }
+        if (area == 0)
+        {
+            idle = true;
+            return Result::ok;
+        }
+        Result r = deleteArea(area);
+        if (r != Result::ok)
+        {
+            return r;
+        }
+    }
+    return Result::ok;
+}
+
+AreaPos
+AreaManagement::getQueuedErases()
+{
+    AreaPos queued = 0;
+    for (AreaPos area = 0; area < areasNo; area++)
+    {
+        if (dev->superblock.getStatus(area) == AreaStatus::erasePending)
+        {
+            queued++;
+        }
+    }
+    return queued;
+}
+
+void
+AreaManagement::setEraseWatermark(AreaPos erasedAreas)
+{
+    mEraseWatermark = erasedAreas;
+}
+
+AreaPos
+AreaManagement::getErasedAreas()
+{
+    AreaPos erased = 0;
+    for (AreaPos area = 0; area < areasNo; area++)
+    {
+        if (dev->superblock.getStatus(area) == AreaStatus::empty
+            && dev->superblock.getType(area) != AreaType::retired)
+        {
+            erased++;
+        }
+    }
+    return erased;
+}
+
+AreaPos
+AreaManagement::findQueuedErase()
+{
+    AreaPos favouriteArea = 0;
+    uint32_t favErases = ~0;
+    for (AreaPos area = 0; area < areasNo; area++)
+    {
+        if (dev->superblock.getStatus(area) == AreaStatus::erasePending
+            && dev->superblock.getErasecount(area) < favErases)
+        {
+            favouriteArea = area;
+            favErases = dev->superblock.getErasecount(area);
+        }
+    }
+    return favouriteArea;
+}
+
+AreaPos
+AreaManagement::findCompletelyDirtyArea()
+{
+    for (AreaPos area = 0; area < areasNo; area++)
+    {
+        if (dev->superblock.getStatus(area) == AreaStatus::closed
+            && (dev->superblock.getType(area) == AreaType::data
+                || dev->superblock.getType(area) == AreaType::index)
+            && area != gc.getPendingVictim()
+            && dev->sumCache.getDirtyPages(area) == dataPagesPerArea)
+        {
+            return area;
+        }
+    }
+    return 0;
+}
+
 JournalEntry::Topic
 AreaManagement::getTopic()
 {
@@ -686,6 +904,32 @@ AreaManagement::signalEndOfLog()
             break;
         }
         break;
+    case journalEntry::AreaMgmt::Operation::queueErase:
+        switch(mLastExternOp)
+        {
+        case ExternOp::none:
+            dev->sumCache.deleteSummary(mLastOp.queueErase.area);
+            //fall-through
+        case ExternOp::deleteSummary:
+            if (dev->superblock.getStatus(mLastOp.queueErase.area) == AreaStatus::empty)
+            {
+                dev->superblock.increaseUsedAreas();
+            }
+            //fall-through
+        case ExternOp::changeUsedAreas:
+            dev->superblock.setStatus(mLastOp.queueErase.area, AreaStatus::erasePending);
+            //fall-through
+        case ExternOp::setStatus:
+            dev->superblock.setType(mLastOp.queueErase.area, AreaType::unset);
+            //fall-through
+        case ExternOp::setType:
+            dev->journal.addEvent(journalEntry::Checkpoint(getTopic()));
+            break;
+        default:
+            //nothing
+            break;
+        }
+        break;
     default:
         //nothing
         break;
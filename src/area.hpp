@@ -59,6 +59,7 @@ class AreaManagement : public JournalTopic
     Device* dev;
 
     bool mUnfinishedTransaction = false;
+    AreaPos mEraseWatermark = defaultEraseWatermark;
     journalEntry::areaMgmt::Max mLastOp;
 
     enum class ExternOp
@@ -109,6 +110,37 @@ public:
     deleteAreaContents(AreaPos area, AreaPos swappedArea, bool noJournalLogging = false);
     Result
     deleteArea(AreaPos area);
+    /**
+     * Marks an area with obsolete contents for erasure instead of erasing it right away.
+     * The erase is done by eraseQueuedAreas in idle time or by findWritableArea on demand.
+     * If less than the watermark of erased areas is left, the area is erased immediately.
+     * A queued empty area counts as used until it is erased.
+     */
+    Result
+    queueErase(AreaPos area);
+    /**
+     * Exchanges the position of \p area with an erased area and queues the old contents
+     * of \p area for erasure, so \p area can be written again without waiting for an erase.
+     * Returns Result::notFound if no erased area above the erase watermark is left.
+     */
+    Result
+    replaceByErasedArea(AreaPos area);
+    /**
+     * Erased area with the lowest erase count that can be taken without dropping
+     * below the erase watermark, or 0 if there is none
+     */
+    AreaPos
+    findErasedArea();
+    /**
+     * Erases at most \p maxAreas queued or completely dirty areas.
+     * \p idle is set if there was nothing left to erase.
+     */
+    Result
+    eraseQueuedAreas(AreaPos maxAreas, bool& idle);
+    AreaPos
+    getQueuedErases();
+    void
+    setEraseWatermark(AreaPos erasedAreas);
 
     JournalEntry::Topic
     getTopic() override;
@@ -120,6 +152,20 @@ public:
     processEntry(const journalEntry::Max& entry, JournalEntryPosition) override;
     void
     signalEndOfLog() override;
+
+private:
+    AreaPos
+    getErasedAreas();
+    /**
+     * Queued area with the lowest erase count, or 0 if there is none
+     */
+    AreaPos
+    findQueuedErase();
+    /**
+     * Closed area without any valid or free page left, or 0 if there is none
+     */
+    AreaPos
+    findCompletelyDirtyArea();
 };
 
 }  // namespace paffs
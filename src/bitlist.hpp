@@ -18,6 +18,63 @@
 
 namespace paffs
 {
+/**
+ * Word-at-a-time helpers for the bit lists.
+ * Words are assembled little endian from the byte arrays, so the position of an
+ * element inside a word does not depend on the byte order of the target.
+ * The compiler builtins map to popcount/ctz instructions where available.
+ */
+namespace bitword
+{
+static constexpr size_t bytes = sizeof(uint64_t);
+
+static inline uint64_t
+load(const uint8_t* list, size_t count = bytes)
+{
+    uint64_t word = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        word |= static_cast<uint64_t>(list[i]) << (i * 8);
+    }
+    return word;
+}
+
+static inline uint8_t
+popcount(uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(word);
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ULL);
+    word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (word * 0x0101010101010101ULL) >> 56;
+#endif
+}
+
+/**
+ * @param word may not be zero
+ */
+static inline uint8_t
+countTrailingZeros(uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    return popcount((word & -word) - 1);
+#endif
+}
+
+/**
+ * Mask of the lowest \p bits bits, all bits for 64 or more
+ */
+static inline uint64_t
+lowMask(size_t bits)
+{
+    return bits >= 64 ? ~0ULL : (1ULL << bits) - 1;
+}
+}
+
 template <size_t numberOfElements>
 class BitList
 {
@@ -101,17 +158,14 @@ public:
     static inline size_t
     findFirstFree(const uint8_t* list)
     {
-        for (unsigned i = 0; i <= numberOfElements / 8; i++)
+        for (size_t byte = 0; byte < byteUsage; byte += bitword::bytes)
         {
-            if (list[i] != 0xFF)
+            size_t count = byteUsage - byte < bitword::bytes ? byteUsage - byte : bitword::bytes;
+            uint64_t freeBits = ~bitword::load(&list[byte], count)
+                                & bitword::lowMask(numberOfElements - byte * 8);
+            if (freeBits != 0)
             {
-                for (unsigned int j = i * 8; j < (i + 1) * 8 && j < numberOfElements; j++)
-                {
-                    if (!getBit(j, list))
-                    {
-                        return j;
-                    }
-                }
+                return byte * 8 + bitword::countTrailingZeros(freeBits);
             }
         }
         return numberOfElements;
@@ -146,12 +200,11 @@ public:
     countSetBits(const uint8_t* list)
     {
         size_t count = 0;
-        for (size_t i = 0; i < numberOfElements; i++)
+        for (size_t byte = 0; byte < byteUsage; byte += bitword::bytes)
         {
-            if (getBit(i, list))
-            {
-                ++count;
-            }
+            size_t bytes = byteUsage - byte < bitword::bytes ? byteUsage - byte : bitword::bytes;
+            count += bitword::popcount(bitword::load(&list[byte], bytes)
+                                       & bitword::lowMask(numberOfElements - byte * 8));
         }
         return count;
     }
@@ -162,6 +215,21 @@ public:
         return countSetBits(mList);
     }
 
+    /**
+     * Sets all bits from \p from to (excluding) \p to, whole bytes at once
+     */
+    inline void
+    setRange(size_t from, size_t to)
+    {
+        fillRange(from, to, true);
+    }
+
+    inline void
+    resetRange(size_t from, size_t to)
+    {
+        fillRange(from, to, false);
+    }
+
     inline uint8_t*
     expose()
     {
@@ -196,6 +264,31 @@ public:
     {
         return !(*this == rhs);
     }
+
+private:
+    inline void
+    fillRange(size_t from, size_t to, bool value)
+    {
+        if (to > numberOfElements)
+        {
+            PAFFS_DBG(PAFFS_TRACE_BUG, "Tried to fill Bits up to %zu, but size is %zu",
+                      to, numberOfElements);
+            to = numberOfElements;
+        }
+        for (; from < to && from % 8 != 0; from++)
+        {
+            value ? setBit(from) : resetBit(from);
+        }
+        if (from + 8 <= to)
+        {
+            memset(&mList[from / 8], value ? 0xFF : 0, (to - from) / 8);
+            from += (to - from) / 8 * 8;
+        }
+        for (; from < to; from++)
+        {
+            value ? setBit(from) : resetBit(from);
+        }
+    }
 };
 
 template <size_t numberOfElements>
@@ -242,6 +335,74 @@ public:
         return getValue(pos, mList);
     }
 
+    /**
+     * Number of elements equal to \p value, 32 elements per step
+     */
+    static inline size_t
+    countValue(uint8_t value, const uint8_t list[(numberOfElements + 3) / 4])
+    {
+        size_t count = 0;
+        for (size_t byte = 0; byte < byteUsage; byte += bitword::bytes)
+        {
+            count += bitword::popcount(matchingElements(value, list, byte));
+        }
+        return count;
+    }
+    inline size_t
+    countValue(uint8_t value) const
+    {
+        return countValue(value, mList);
+    }
+
+    /**
+     * Position of the first element equal to \p value, numberOfElements if there is none
+     */
+    static inline size_t
+    findFirstValue(uint8_t value, const uint8_t list[(numberOfElements + 3) / 4])
+    {
+        for (size_t byte = 0; byte < byteUsage; byte += bitword::bytes)
+        {
+            uint64_t matches = matchingElements(value, list, byte);
+            if (matches != 0)
+            {
+                return byte * 4 + bitword::countTrailingZeros(matches) / 2;
+            }
+        }
+        return numberOfElements;
+    }
+    inline size_t
+    findFirstValue(uint8_t value) const
+    {
+        return findFirstValue(value, mList);
+    }
+
+    /**
+     * Sets all elements from \p from to (excluding) \p to, whole bytes at once
+     */
+    inline void
+    setRange(size_t from, size_t to, uint8_t value)
+    {
+        if (to > numberOfElements)
+        {
+            PAFFS_DBG(PAFFS_TRACE_BUG, "Tried to fill elements up to %zu, but size is %zu",
+                      to, numberOfElements);
+            to = numberOfElements;
+        }
+        for (; from < to && from % 4 != 0; from++)
+        {
+            setValue(from, value);
+        }
+        if (from + 4 <= to)
+        {
+            memset(&mList[from / 4], (value & 0b11) * 0b01010101, (to - from) / 4);
+            from += (to - from) / 4 * 4;
+        }
+        for (; from < to; from++)
+        {
+            setValue(from, value);
+        }
+    }
+
     inline uint8_t*
     expose()
     {
@@ -266,5 +427,21 @@ public:
     {
         return !(*this == rhs);
     }
+
+private:
+    /**
+     * Returns the word starting at \p byte with the lower bit of every element set
+     * that equals \p value. Elements behind the end of the list never match.
+     */
+    static inline uint64_t
+    matchingElements(uint8_t value, const uint8_t* list, size_t byte)
+    {
+        size_t bytes = byteUsage - byte < bitword::bytes ? byteUsage - byte : bitword::bytes;
+        // An element matches if both of its bits are zero after the xor
+        uint64_t diff = bitword::load(&list[byte], bytes)
+                        ^ ((value & 0b11) * 0x5555555555555555ULL);
+        return ~(diff | diff >> 1) & 0x5555555555555555ULL
+               & bitword::lowMask((numberOfElements - byte * 4) * 2);
+    }
 };
 };
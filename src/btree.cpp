@@ -50,6 +50,9 @@ Btree::insertInode(const Inode& inode)
         }
     }
 
+    // Locks are not counted, so unlocking the leaf below would also unlock it for the cursor.
+    // Splitting moves inodes to other leaves anyway.
+    releaseCursorLeaf();
     mCache.lockTreeCacheNode(*node);  // prevents own node from clear
     FAILPOINT;
     // This prevents the cache from a commit inside invalid state
@@ -68,18 +71,44 @@ Btree::insertInode(const Inode& inode)
      */
     if (node->raw.keys < leafOrder)
     {
-        return insertIntoLeaf(*node, inode);
+        r = insertIntoLeaf(*node, inode);
     }
-
-    /* Case:  leaf must be split.
-     */
-    return insertIntoLeafAfterSplitting(*node, inode);
+    else
+    {
+        /* Case:  leaf must be split.
+         */
+        r = insertIntoLeafAfterSplitting(*node, inode);
+    }
+    if (r == Result::ok)
+    {
+        mInodeCache.put(inode);
+        if (mNextFreeNoValid && inode.no >= mNextFreeNo)
+        {
+            mNextFreeNo = inode.no + 1;
+        }
+    }
+    return r;
 }
 
 Result
 Btree::getInode(InodeNo number, Inode& outInode)
 {
-    return find(number, outInode);
+    if (mInodeCache.get(number, outInode) == Result::ok)
+    {
+        return Result::ok;
+    }
+    return getInodeFromTree(number, outInode);
+}
+
+Result
+Btree::getInodeFromTree(InodeNo number, Inode& outInode)
+{
+    Result r = find(number, outInode);
+    if (r == Result::ok)
+    {
+        mInodeCache.put(outInode);
+    }
+    return r;
 }
 
 Result
@@ -145,6 +174,7 @@ Btree::updateExistingInode(const Inode& inode)
         return Result::bug;  // This Key did not exist
     }
 
+    mInodeCache.put(inode);
     if(memcmp(&node->raw.as.leaf.pInodes[pos], &inode, sizeof(Inode)) == 0)
     {   //There is no change of the inode
         return Result::ok;
@@ -165,6 +195,8 @@ Btree::deleteInode(InodeNo number)
     Inode key;
     TreeCacheNode* keyLeaf;
 
+    mInodeCache.invalidate(number);
+    releaseCursorLeaf();
     Result r = findLeaf(number, keyLeaf);
     if (r != Result::ok)
     {
@@ -193,6 +225,11 @@ Btree::deleteInode(InodeNo number)
         }
     }
 
+    if (r == Result::ok && mNextFreeNoValid && number + 1 == mNextFreeNo)
+    {
+        // The next lower number is unknown without walking the tree
+        mNextFreeNoValid = false;
+    }
     mCache.commitIfNodesWereRemoved();
     dev->journal.addEvent(journalEntry::btree::Remove(number));
     return r;
@@ -201,6 +238,11 @@ Btree::deleteInode(InodeNo number)
 Result
 Btree::findFirstFreeNo(InodeNo* outNumber)
 {
+    if (mNextFreeNoValid)
+    {
+        *outNumber = mNextFreeNo;
+        return Result::ok;
+    }
     TreeCacheNode* c = nullptr;
     *outNumber = 0;
     Result r = mCache.getRootNodeFromCache(c);
@@ -220,9 +262,88 @@ Btree::findFirstFreeNo(InodeNo* outNumber)
     {
         *outNumber = c->raw.as.leaf.pInodes[c->raw.keys - 1].no + 1;
     }
+    mNextFreeNo = *outNumber;
+    mNextFreeNoValid = true;
     return Result::ok;
 }
 
+void
+Btree::openCursor(InodeCursor& cursor, InodeNo from)
+{
+    cursor.next = from;
+    cursor.upperBound = 0;
+    cursor.bounded = false;
+    cursor.end = false;
+    cursor.leaf = nullptr;
+    cursor.generation = 0;
+}
+
+Result
+Btree::nextInode(InodeCursor& cursor, Inode& outInode)
+{
+    while (!cursor.end)
+    {
+        if (cursor.leaf == nullptr || mCursorLeaf == nullptr
+            || cursor.generation != mCursorGeneration)
+        {
+            releaseCursorLeaf();
+            TreeCacheNode* leaf = nullptr;
+            Result r = findLeaf(cursor.next, leaf, &cursor.upperBound, &cursor.bounded);
+            if (r != Result::ok)
+            {
+                return r;
+            }
+            mCache.lockTreeCacheNode(*leaf);
+            mCursorLeaf = leaf;
+            cursor.leaf = leaf;
+            cursor.generation = ++mCursorGeneration;
+        }
+        for (uint16_t i = 0; i < cursor.leaf->raw.keys; i++)
+        {
+            if (cursor.leaf->raw.as.leaf.keys[i] >= cursor.next)
+            {
+                outInode = cursor.leaf->raw.as.leaf.pInodes[i];
+                cursor.next = outInode.no + 1;
+                if (cursor.next == 0)
+                {   // Wrapped around, this was the highest possible number
+                    cursor.end = true;
+                }
+                return Result::ok;
+            }
+        }
+        // Leaf is exhausted, continue at its right neighbour
+        if (!cursor.bounded)
+        {
+            cursor.end = true;
+        }
+        cursor.next = cursor.upperBound;
+        cursor.leaf = nullptr;
+    }
+    closeCursor(cursor);
+    return Result::notFound;
+}
+
+void
+Btree::closeCursor(InodeCursor& cursor)
+{
+    if (cursor.leaf != nullptr && cursor.generation == mCursorGeneration)
+    {
+        releaseCursorLeaf();
+    }
+    cursor.leaf = nullptr;
+    cursor.end = true;
+}
+
+void
+Btree::releaseCursorLeaf()
+{
+    if (mCursorLeaf != nullptr)
+    {
+        mCache.unlockTreeCacheNode(*mCursorLeaf);
+        mCursorLeaf = nullptr;
+    }
+}
+
 uint16_t
 Btree::calculateMaxNeededNewNodesForInsertion(const TreeCacheNode& insertTarget)
 {
@@ -231,9 +352,9 @@ Btree::calculateMaxNeededNewNodesForInsertion(const TreeCacheNode& insertTarget)
     {   //we are a leaf
         if(insertTarget.raw.keys == leafOrder)
         {   //leaf is full, would split
-            if(insertTarget.parent != &insertTarget)
+            if(mCache.getParent(insertTarget) != &insertTarget)
             {   //we are a normal leaf
-                return 1 + calculateMaxNeededNewNodesForInsertion(*insertTarget.parent);
+                return 1 + calculateMaxNeededNewNodesForInsertion(*mCache.getParent(insertTarget));
             }
             else
             {   //Rootnode splits into brother and parent is new rootnode
@@ -248,9 +369,9 @@ Btree::calculateMaxNeededNewNodesForInsertion(const TreeCacheNode& insertTarget)
     {   //we are a branch
         if(insertTarget.raw.keys == branchOrder - 1)
         {
-            if(insertTarget.parent != &insertTarget)
+            if(mCache.getParent(insertTarget) != &insertTarget)
             {   //we are a normal branch
-                return 1 + calculateMaxNeededNewNodesForInsertion(*insertTarget.parent);
+                return 1 + calculateMaxNeededNewNodesForInsertion(*mCache.getParent(insertTarget));
             }
             else
             {   //Rootnode splits into brother and parent is new rootnode
@@ -274,6 +395,9 @@ void
 Btree::wipeCache()
 {
     mCache.clear();
+    mInodeCache.clear();
+    mNextFreeNoValid = false;
+    mCursorLeaf = nullptr;
 }
 
 JournalEntry::Topic
@@ -285,6 +409,9 @@ void
 Btree::resetState()
 {
     mCache.resetState();
+    mInodeCache.clear();
+    mNextFreeNoValid = false;
+    mCursorLeaf = nullptr;
     mJournalLastSuccess = 0;
     mJournalIsEndOfLog = false;
 }
@@ -448,10 +575,10 @@ Btree::lengthToRoot(TreeCacheNode& child)
 {
     uint16_t length = 0;
     TreeCacheNode* node = &child;
-    while (node->parent != node)
+    while (mCache.getParent(*node) != node)
     {
         length++;
-        node = node->parent;
+        node = mCache.getParent(*node);
     }
     return length;
 }
@@ -497,7 +624,10 @@ Btree::findBranch(TreeCacheNode& target, TreeCacheNode*& outtreeCacheNode)
  * Returns the leaf containing the given key.
  */
 Result
-Btree::findLeaf(InodeNo key, TreeCacheNode*& outtreeCacheNode)
+Btree::findLeaf(InodeNo key,
+                TreeCacheNode*& outtreeCacheNode,
+                InodeNo* outUpperBound,
+                bool* outBounded)
 {
     uint16_t i = 0;
     TreeCacheNode* c = nullptr;
@@ -508,6 +638,10 @@ Btree::findLeaf(InodeNo key, TreeCacheNode*& outtreeCacheNode)
         return r;
     }
 
+    if (outBounded != nullptr)
+    {
+        *outBounded = false;
+    }
     uint8_t depth = 0;
     while (!c->raw.isLeaf)
     {
@@ -533,6 +667,11 @@ Btree::findLeaf(InodeNo key, TreeCacheNode*& outtreeCacheNode)
                 break;
             }
         }
+        if (i < c->raw.keys && outUpperBound != nullptr && outBounded != nullptr)
+        {   // Deeper separators are never looser than the ones above
+            *outUpperBound = c->raw.as.branch.keys[i];
+            *outBounded = true;
+        }
 
         r = mCache.getTreeNodeAtIndexFrom(i, *c, c);
         if (r != Result::ok)
@@ -610,9 +749,9 @@ Btree::getLeftIndex(TreeCacheNode& parent, TreeCacheNode& left)
                 break;
             }
         }
-        if (parent.pointers[leftIndex] != 0)
+        if (parent.pointers[leftIndex] != noCacheLink)
         {
-            if (parent.pointers[leftIndex] == &left)
+            if (mCache.getChild(parent, leftIndex) == &left)
             {
                 break;
             }
@@ -755,12 +894,12 @@ Btree::insertIntoNode(TreeCacheNode& node, uint16_t leftIndex, InodeNo key, Tree
         node.raw.as.branch.keys[i] = node.raw.as.branch.keys[i - 1];
     }
     node.raw.as.branch.pointers[leftIndex + 1] = right.raw.self;
-    node.pointers[leftIndex + 1] = &right;
+    mCache.setChild(node, leftIndex + 1, &right);
 
     node.raw.as.branch.keys[leftIndex] = key;
     node.raw.keys++;
     node.dirty = true;
-    right.parent = &node;
+    mCache.setParent(right, &node);
     right.dirty = true;
 
     return Result::ok;
@@ -785,7 +924,7 @@ Btree::insertIntoNodeAfterSplitting(TreeCacheNode& oldNode,
     TreeCacheNode* newNode;
     //FIXME: High stack usage
     InodeNo tempKeys[branchOrder + 1];
-    TreeCacheNode* tempRAMaddresses[branchOrder + 1];
+    TreeCacheLink tempLinks[branchOrder + 1];
     Addr tempAddresses[branchOrder + 1];
 
     mCache.lockTreeCacheNode(oldNode);
@@ -811,7 +950,7 @@ Btree::insertIntoNodeAfterSplitting(TreeCacheNode& oldNode,
             j++;
         }
         tempAddresses[j] = oldNode.raw.as.branch.pointers[i];
-        tempRAMaddresses[j] = oldNode.pointers[i];
+        tempLinks[j] = oldNode.pointers[i];
     }
 
     for (i = 0, j = 0; i < oldNode.raw.keys; i++, j++)
@@ -822,7 +961,7 @@ Btree::insertIntoNodeAfterSplitting(TreeCacheNode& oldNode,
     }
 
     tempAddresses[leftIndex + 1] = right.raw.self;
-    tempRAMaddresses[leftIndex + 1] = &right;
+    tempLinks[leftIndex + 1] = mCache.getLink(right);
     tempKeys[leftIndex] = key;
 
     /* Create the new TreeCacheNode and copy
@@ -835,25 +974,25 @@ Btree::insertIntoNodeAfterSplitting(TreeCacheNode& oldNode,
     for (i = 0; i < split - 1; i++)
     {
         oldNode.raw.as.branch.pointers[i] = tempAddresses[i];
-        oldNode.pointers[i] = tempRAMaddresses[i];
+        oldNode.pointers[i] = tempLinks[i];
         oldNode.raw.as.branch.keys[i] = tempKeys[i];
         oldNode.raw.keys++;
     }
     oldNode.raw.as.branch.pointers[i] = tempAddresses[i];
-    oldNode.pointers[i] = tempRAMaddresses[i];
+    oldNode.pointers[i] = tempLinks[i];
     kPrime = tempKeys[split - 1];
     for (++i, j = 0; i < branchOrder; i++, j++)
     {
-        newNode->pointers[j] = tempRAMaddresses[i];
+        newNode->pointers[j] = tempLinks[i];
         newNode->raw.as.branch.pointers[j] = tempAddresses[i];
         newNode->raw.as.branch.keys[j] = tempKeys[i];
         newNode->raw.keys++;
-        if (newNode->pointers[j] != nullptr)
+        if (newNode->pointers[j] != noCacheLink)
         {
-            newNode->pointers[j]->parent = newNode;
+            mCache.setParent(*mCache.getChild(*newNode, j), newNode);
         }
         // cleanup
-        oldNode.pointers[i] = 0;
+        oldNode.pointers[i] = noCacheLink;
         oldNode.raw.as.branch.pointers[i] = 0;
         if (i < branchOrder - 1)
         {
@@ -861,11 +1000,11 @@ Btree::insertIntoNodeAfterSplitting(TreeCacheNode& oldNode,
         }
     }
 
-    newNode->pointers[j] = tempRAMaddresses[i];
+    newNode->pointers[j] = tempLinks[i];
     newNode->raw.as.branch.pointers[j] = tempAddresses[i];
-    if (newNode->pointers[j] != nullptr)
+    if (newNode->pointers[j] != noCacheLink)
     {
-        newNode->pointers[j]->parent = newNode;
+        mCache.setParent(*mCache.getChild(*newNode, j), newNode);
     }
     newNode->parent = oldNode.parent;
 
@@ -886,7 +1025,7 @@ Result
 Btree::insertIntoParent(TreeCacheNode& left, InodeNo key, TreeCacheNode& right)
 {
     uint16_t leftIndex;
-    TreeCacheNode* parent = left.parent;
+    TreeCacheNode* parent = mCache.getParent(left);
 
     if (&left == parent)
     {
@@ -926,15 +1065,15 @@ Btree::insertIntoNewRoot(TreeCacheNode& left, InodeNo key, TreeCacheNode& right)
     new_root->raw.isLeaf = false;
     new_root->raw.as.branch.keys[0] = key;
     new_root->raw.as.branch.pointers[0] = left.raw.self;
-    new_root->pointers[0] = &left;
-    left.parent = new_root;
+    mCache.setChild(*new_root, 0, &left);
+    mCache.setParent(left, new_root);
     new_root->raw.as.branch.pointers[1] = right.raw.self;
-    new_root->pointers[1] = &right;
-    right.parent = new_root;
+    mCache.setChild(*new_root, 1, &right);
+    mCache.setParent(right, new_root);
 
     new_root->raw.keys = 1;
     new_root->dirty = true;
-    new_root->parent = new_root;
+    mCache.setParent(*new_root, new_root);
 
     return mCache.setRoot(*new_root);
 }
@@ -946,13 +1085,16 @@ Result
 Btree::startNewTree()
 {
     mCache.clear();
+    mInodeCache.clear();
+    mNextFreeNoValid = false;
+    mCursorLeaf = nullptr;
     TreeCacheNode* new_root = nullptr;
     Result r = mCache.addNewCacheNode(new_root);
     if (r != Result::ok)
         return r;
     new_root->raw.isLeaf = true;
     new_root->dirty = true;
-    new_root->parent = new_root;
+    mCache.setParent(*new_root, new_root);
     return mCache.setRoot(*new_root);
 }
 
@@ -968,10 +1110,11 @@ int
 Btree::getNeighborIndex(TreeCacheNode& n)
 {
     uint16_t i;
-    TreeCacheNode* parent = n.parent;
+    TreeCacheNode* parent = mCache.getParent(n);
 
     for (i = 0; i <= parent->raw.keys; i++)
-        if (parent->pointers[i] == &n)  // It is allowed for all other pointers to be invalid
+        // It is allowed for all other pointers to be invalid
+        if (mCache.getChild(*parent, i) == &n)
             return i - 1;
 
     // Error state.
@@ -1031,7 +1174,7 @@ Btree::removeEntryFromNode(TreeCacheNode& n, InodeNo key)
         for (i = n.raw.keys + 1; i < branchOrder; i++)
         {
             n.raw.as.branch.pointers[i] = 0;
-            n.pointers[i] = nullptr;
+            n.pointers[i] = noCacheLink;
             n.raw.as.branch.keys[i - 1] = 0;
         }
 
@@ -1060,8 +1203,8 @@ Btree::adjustRoot(TreeCacheNode& root)
 
     if (!root.raw.isLeaf)
     {
-        root.pointers[0]->parent = root.pointers[0];
-        Result r = mCache.setRoot(*root.pointers[0]);
+        mCache.setParent(*mCache.getChild(root, 0), mCache.getChild(root, 0));
+        Result r = mCache.setRoot(*mCache.getChild(root, 0));
         if (r != Result::ok)
         {
             return r;
@@ -1156,10 +1299,10 @@ Btree::coalesceNodes(TreeCacheNode& n,
          */
         for (i = 0; i < to->raw.keys + 1; i++)
         {
-            tmp = to->pointers[i];
+            tmp = mCache.getChild(*to, i);
             if(tmp != nullptr)
             {
-                tmp->parent = to;
+                mCache.setParent(*tmp, to);
             }
         }
     }
@@ -1184,7 +1327,7 @@ Btree::coalesceNodes(TreeCacheNode& n,
     if (r != Result::ok)
         return r;
 
-    return deleteEntry(*from->parent, kPrime);
+    return deleteEntry(*mCache.getParent(*from), kPrime);
 }
 
 /* Redistributes entries between two nodes when
@@ -1236,14 +1379,14 @@ Btree::redistributeNodes(TreeCacheNode& n,
                                                                        // needed, nullptr is also
                                                                        // allowed
             n.raw.as.branch.pointers[0] = neighbor.raw.as.branch.pointers[neighbor.raw.keys];
-            if(n.pointers[0] != nullptr)
+            if(n.pointers[0] != noCacheLink)
             {
-                n.pointers[0]->parent = &n;
+                mCache.setParent(*mCache.getChild(n, 0), &n);
             }
-            neighbor.pointers[neighbor.raw.keys] = nullptr;
+            neighbor.pointers[neighbor.raw.keys] = noCacheLink;
             neighbor.raw.as.branch.pointers[neighbor.raw.keys] = 0;
             n.raw.as.branch.keys[0] = kPrime;
-            n.parent->raw.as.branch.keys[kPrimeIndex] =
+            mCache.getParent(n)->raw.as.branch.keys[kPrimeIndex] =
                     neighbor.raw.as.branch.keys[neighbor.raw.keys - 1];
         }
         else
@@ -1251,7 +1394,7 @@ Btree::redistributeNodes(TreeCacheNode& n,
             n.raw.as.leaf.pInodes[0] = neighbor.raw.as.leaf.pInodes[neighbor.raw.keys - 1];
             memset(&neighbor.raw.as.leaf.pInodes[neighbor.raw.keys - 1], 0, sizeof(Inode));
             n.raw.as.leaf.keys[0] = neighbor.raw.as.leaf.keys[neighbor.raw.keys - 1];
-            n.parent->raw.as.leaf.keys[kPrimeIndex] = n.raw.as.leaf.keys[0];
+            mCache.getParent(n)->raw.as.leaf.keys[kPrimeIndex] = n.raw.as.leaf.keys[0];
         }
     }
 
@@ -1267,7 +1410,7 @@ Btree::redistributeNodes(TreeCacheNode& n,
         {
             n.raw.as.leaf.keys[n.raw.keys] = neighbor.raw.as.leaf.keys[0];
             n.raw.as.leaf.pInodes[n.raw.keys] = neighbor.raw.as.leaf.pInodes[0];
-            n.parent->raw.as.leaf.keys[kPrimeIndex] = neighbor.raw.as.leaf.keys[1];
+            mCache.getParent(n)->raw.as.leaf.keys[kPrimeIndex] = neighbor.raw.as.leaf.keys[1];
             for (i = 0; i < neighbor.raw.keys - 1; i++)
             {
                 neighbor.raw.as.leaf.keys[i] = neighbor.raw.as.leaf.keys[i + 1];
@@ -1279,11 +1422,11 @@ Btree::redistributeNodes(TreeCacheNode& n,
             n.raw.as.branch.keys[n.raw.keys] = kPrime;
             n.pointers[n.raw.keys + 1] = neighbor.pointers[0];
             n.raw.as.branch.pointers[n.raw.keys + 1] = neighbor.raw.as.branch.pointers[0];
-            if(n.pointers[n.raw.keys + 1] != nullptr)
+            if(n.pointers[n.raw.keys + 1] != noCacheLink)
             {
-                n.pointers[n.raw.keys + 1]->parent = &n;
+                mCache.setParent(*mCache.getChild(n, n.raw.keys + 1), &n);
             }
-            n.parent->raw.as.branch.keys[kPrimeIndex] = neighbor.raw.as.branch.keys[0];
+            mCache.getParent(n)->raw.as.branch.keys[kPrimeIndex] = neighbor.raw.as.branch.keys[0];
             for (i = 0; i < neighbor.raw.keys - 1; i++)
             {
                 neighbor.raw.as.branch.keys[i] = neighbor.raw.as.branch.keys[i + 1];
@@ -1308,7 +1451,7 @@ Btree::redistributeNodes(TreeCacheNode& n,
 
     n.dirty = true;
     neighbor.dirty = true;
-    n.parent->dirty = true;
+    mCache.getParent(n)->dirty = true;
 
     return Result::ok;
 }
@@ -1338,7 +1481,7 @@ Btree::deleteEntry(TreeCacheNode& n, InodeNo key)
     /* Case:  deletion from root.
      */
 
-    if (n.parent == &n)
+    if (mCache.getParent(n) == &n)
     {
         return adjustRoot(n);
     }
@@ -1376,10 +1519,11 @@ Btree::deleteEntry(TreeCacheNode& n, InodeNo key)
 
     neighborIndex = getNeighborIndex(n);
     kPrimeIndex = neighborIndex == -1 ? 0 : neighborIndex;
-    kPrime = n.parent->raw.as.branch.keys[kPrimeIndex];
+    TreeCacheNode* parent = mCache.getParent(n);
+    kPrime = parent->raw.as.branch.keys[kPrimeIndex];
     mCache.lockTreeCacheNode(n);
-    r = neighborIndex == -1 ? mCache.getTreeNodeAtIndexFrom(1, *n.parent, neighbor)
-                             : mCache.getTreeNodeAtIndexFrom(neighborIndex, *n.parent, neighbor);
+    r = neighborIndex == -1 ? mCache.getTreeNodeAtIndexFrom(1, *parent, neighbor)
+                             : mCache.getTreeNodeAtIndexFrom(neighborIndex, *parent, neighbor);
     mCache.unlockTreeCacheNode(n);
     if (r != Result::ok)
     {
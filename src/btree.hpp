@@ -19,6 +19,7 @@
 #include <stddef.h>
 
 #include "commonTypes.hpp"
+#include "inodeCache.hpp"
 #include "journalTopic.hpp"
 #include "paffs_trace.hpp"
 #include "treeCache.hpp"
@@ -27,14 +28,37 @@
 
 namespace paffs
 {
+/**
+ * Position of an ordered walk over all inodes, see Btree::openCursor.
+ * Only the Btree touches the members.
+ */
+struct InodeCursor
+{
+    InodeNo next;         // smallest number not returned yet
+    InodeNo upperBound;   // leaf holds numbers below this if bounded
+    bool bounded;
+    bool end;
+    TreeCacheNode* leaf;  // only valid while generation matches the Btree's cursor leaf
+    uint32_t generation;
+};
+
 class Btree : public JournalTopic
 {
     Device* dev;
     JournalEntryPosition mJournalLastSuccess;
     bool mJournalIsEndOfLog;
+    // Highest inode number in the tree plus one, so creating an inode needs no tree walk.
+    // It follows from the tree contents and is rebuilt from the rightmost leaf when invalid.
+    InodeNo mNextFreeNo;
+    bool mNextFreeNoValid;
+    // Leaf of the last cursor step, locked in the TreeCache so that stepping through it
+    // needs no descent. Released before every insertion or deletion.
+    TreeCacheNode* mCursorLeaf;
+    uint32_t mCursorGeneration = 0;
 
 public:
     TreeCache mCache;
+    InodeCache mInodeCache;
     inline
     Btree(Device* mdev) : dev(mdev), mCache(TreeCache(mdev))
     {
@@ -45,13 +69,36 @@ public:
     insertInode(const Inode& inode);
     Result
     getInode(InodeNo number, Inode& outInode);
+    /**
+     * Like getInode, but always walks the tree so that the leaf is in the TreeCache afterwards
+     */
+    Result
+    getInodeFromTree(InodeNo number, Inode& outInode);
     Result
     updateExistingInode(const Inode& inode);
     Result
     deleteInode(InodeNo number);
+    /**
+     * Returns the highest inode number in the tree plus one.
+     * Only walks the tree if the cached value was invalidated.
+     */
     Result
     findFirstFreeNo(InodeNo* outNumber);
 
+    /**
+     * Starts a walk over the inodes in ascending order, beginning at number from.
+     * Each leaf costs one descent, not each inode. The tree may be modified in between.
+     */
+    void
+    openCursor(InodeCursor& cursor, InodeNo from = 0);
+    /**
+     * \return notFound if there are no more inodes
+     */
+    Result
+    nextInode(InodeCursor& cursor, Inode& outInode);
+    void
+    closeCursor(InodeCursor& cursor);
+
     uint16_t
     calculateMaxNeededNewNodesForInsertion(const TreeCacheNode& insertTarget);
 
@@ -99,8 +146,14 @@ private:
     pathFromRoot(TreeCacheNode& child, Addr* path, unsigned int& lengthOut);
     Result
     findBranch(TreeCacheNode& target, TreeCacheNode*& outtreeCacheNode);
+    /**
+     * \param outUpperBound if outBounded is set, the leaf only takes keys below it
+     */
     Result
-    findLeaf(InodeNo key, TreeCacheNode*& outtreeCacheNode);
+    findLeaf(InodeNo key,
+             TreeCacheNode*& outtreeCacheNode,
+             InodeNo* outUpperBound = nullptr,
+             bool* outBounded = nullptr);
     Result
     findInLeaf(TreeCacheNode& leaf, InodeNo key, Inode& outInode);
     Result
@@ -110,6 +163,8 @@ private:
 
     // Insertion.
 
+    void
+    releaseCursorLeaf();
     uint16_t
     getLeftIndex(TreeCacheNode& parent, TreeCacheNode& left);
     Result
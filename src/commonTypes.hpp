@@ -22,7 +22,7 @@
 
 namespace paffs
 {
-static const uint8_t version = 1;
+static const uint8_t version = 2;
 
 // TODO: Elaborate certain order of badness
 enum class Result : uint8_t
@@ -53,6 +53,7 @@ enum class Result : uint8_t
 extern const char* areaNames[];          // Initialized in area.cpp
 extern const char* areaStatusNames[];    // Initialized in area.cpp
 extern const char* summaryEntryNames[];  // Initialized in area.cpp
+extern const char* gcPolicyNames[];      // Initialized in garbage_collection.cpp
 extern const char* resultMsg[];          // Initialized in paffs.cpp
 
 typedef uint8_t Permission;
@@ -69,6 +70,7 @@ static constexpr Fileopenmask FEX= 0x04;   // file execute
 static constexpr Fileopenmask FA = 0x08;   // file append
 static constexpr Fileopenmask FE = 0x10;   // file open only existing
 static constexpr Fileopenmask FC = 0x20;   // file create
+static constexpr Fileopenmask FB = 0x40;   // file buffer writes smaller than a page
 
 enum class Seekmode
 {
@@ -202,15 +204,6 @@ struct Dirent
     char* name;
 };
 
-// An object is a file
-struct Obj
-{
-    bool rdnly;
-    Dirent dirent;
-    FileSize fp;  // Current filepointer
-    Fileopenmask fo;  // TODO actually use this for read/write
-};
-
 struct Dir
 {
     Dirent* self;
@@ -244,7 +237,8 @@ enum AreaStatus : uint8_t
 {
     closed = 0,
     active,
-    empty
+    empty,
+    erasePending,  // Contents are obsolete, but the area was not erased yet
 };
 
 enum class SummaryEntry : uint8_t
@@ -255,6 +249,17 @@ enum class SummaryEntry : uint8_t
     error
 };
 
+/**
+ * Victim selection of the garbage collection
+ */
+enum class GcPolicy : uint8_t
+{
+    greedy = 0,   // most dirty pages first
+    costBenefit,  // age * free / (1 + used), like log-structured filesystems
+    wearAware,    // dirty pages, weighted towards less erased areas
+    num_policies
+};
+
 struct Area
 {  // TODO: Maybe packed? Slow, but less RAM
     // AreaType type:4;
@@ -285,3 +290,29 @@ class Driver;
 #include <paffs/config.hpp>
 #include "config/auto.hpp"
 // clang-format on
+
+namespace paffs
+{
+// An object is a file. Defined after the configuration, as it holds a page buffer.
+/**
+ * Collects writes of an object opened with FB up to the end of a page
+ */
+struct WriteBuffer
+{
+    FileSize start;   // File offset of the first buffered byte
+    uint16_t bytes;   // 0 if nothing is buffered
+    uint8_t data[dataBytesPerPage];
+};
+
+struct Obj
+{
+    bool rdnly;
+    Dirent dirent;
+    FileSize fp;  // Current filepointer
+    Fileopenmask fo;  // TODO actually use this for read/write, only FB is checked yet
+    // Only set if opened with FB while one of the maxWriteBufferedFiles buffers was free.
+    // Bytes written up to the end of a page are collected there and written to flash
+    // when the page is full, or on flush, close, seek or read.
+    WriteBuffer* writeBuffer;
+};
+}  // namespace paffs
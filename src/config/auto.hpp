@@ -32,22 +32,31 @@ static_assert(maxNumberOfFiles >= 1, "At least one file may be open simultaneous
 static constexpr uint16_t totalBytesPerPage = dataBytesPerPage + oobBytesPerPage;
 static constexpr uint16_t areasNo = blocksTotal / blocksPerArea;
 static constexpr uint16_t totalPagesPerArea = blocksPerArea * pagesPerBlock;
-//An Area Summary consists of one 'zero byte' and following one bit per data page
-//Calculate the maximum number of pages needed to fit an area summary
-static constexpr uint16_t oobPagesPerArea = ceil((totalPagesPerArea / 8.) / dataBytesPerPage);
+//An Area Summary consists of one 'zero byte' and following two bits per data page
+//Calculate the maximum number of pages needed to fit an area summary.
+//It is never packed to one bit per page, because telling free from used pages
+//would then need every data page to be read.
+static constexpr uint16_t oobPagesPerArea = ceil((1 + totalPagesPerArea / 4.) / dataBytesPerPage);
 static constexpr uint16_t dataPagesPerArea = totalPagesPerArea - oobPagesPerArea;
 //The actual summary size is calculated with _data_PagesPerArea
-static constexpr uint16_t areaSummarySizePacked = 1 + ceil(dataPagesPerArea / 8.);
-static_assert(areaSummarySizePacked <= dataBytesPerPage, "areaSummary may never exeed one page");
-static constexpr bool     areaSummaryIsPacked = areaSummarySizePacked * 2 > dataBytesPerPage;
-static constexpr uint16_t areaSummarySizeUnpacked = 1 + ceil(dataPagesPerArea / 4.);
-static_assert(!(areaSummaryIsPacked && areaSummarySizePacked > 2048),
-              "High stack usage if used with packed areasummary and big areas!");
+static constexpr uint16_t areaSummarySize = 1 + ceil(dataPagesPerArea / 4.);
+static_assert(areaSummarySize <= oobPagesPerArea * dataBytesPerPage,
+              "areaSummary has to fit into the reserved pages");
 
 static constexpr uint16_t superChainElems = jumpPadNo + 2;
 
 static constexpr uint16_t addrsPerPage = dataBytesPerPage / sizeof(Addr);
 static constexpr uint16_t minFreeAreas = 1;
+// Free areas the incremental garbage collection tries to keep in reserve
+static constexpr uint16_t defaultGcReserve = minFreeAreas + 1;
+// Erased areas below which queued erases are done immediately
+static constexpr uint16_t defaultEraseWatermark = minFreeAreas;
+// Erase count spread above which static wear leveling moves cold areas
+static constexpr uint32_t defaultWearThreshold = 32;
+
+static_assert(inodeCacheSize > 0, "The Inode cache needs at least one entry");
+static_assert(pageAddressCacheSets > 0, "The PageAddressCache needs at least one set");
+static_assert(readCacheSize > 0, "The read cache needs at least one page");
 
 static constexpr uint16_t journalTopicLogSize = 500;
 }
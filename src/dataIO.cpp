@@ -29,6 +29,7 @@ namespace paffs
 DataIO::DataIO(Device *mdev) : dev(mdev), pac(*mdev), statemachine(mdev->journal, mdev->sumCache, &pac)
 {
     resetState();
+    resetStatistics();
 };
 
 // modifies inode->size and inode->reserved size as well
@@ -37,7 +38,8 @@ DataIO::writeInodeData(Inode& inode,
                        FileSize offs,
                        FileSize bytes,
                        FileSize* bytesWritten,
-                       const uint8_t* data)
+                       const uint8_t* data,
+                       bool keepModTime)
 {
     if (dev->readOnly)
     {
@@ -57,74 +59,112 @@ DataIO::writeInodeData(Inode& inode,
         toPage--;
     }
 
-    if(toPage - pageFrom > maxPagesPerWrite)
+    // The page state machines only hold maxPagesPerWrite pages, so larger writes are split into
+    // segments that are committed one after another. The file size is updated with the last one.
+    FileSize newSize = inode.size < offs + bytes ? offs + bytes : inode.size;
+    *bytesWritten = 0;
+    Result res = Result::ok;
+    for (FileSize segFrom = pageFrom; segFrom <= toPage; segFrom += maxPagesPerWrite)
     {
-        PAFFS_DBG(PAFFS_TRACE_ERROR, "Due to the journal, only %" PRIu16 " pages "
-                "are allowed per single write", maxPagesPerWrite);
-        return Result::tooBig;
-    }
+        bool lastSegment = toPage - segFrom < maxPagesPerWrite;
+        FileSize segTo = lastSegment ? toPage : segFrom + maxPagesPerWrite - 1;
+        FileSize segBytes = lastSegment ? bytes - *bytesWritten
+                                        : (segTo + 1) * dataBytesPerPage - (offs + *bytesWritten);
 
-    Result res = pac.setTargetInode(inode);
-    if (res != Result::ok)
-    {
-        PAFFS_DBG(PAFFS_TRACE_ERROR, "could not set new Inode!");
-        return res;
-    }
+        // A flush of all caches between segments may have switched the target
+        res = pac.setTargetInode(inode);
+        if (res != Result::ok)
+        {
+            PAFFS_DBG(PAFFS_TRACE_ERROR, "could not set new Inode!");
+            return res;
+        }
 
-    if (pageFrom > inode.size / dataBytesPerPage)
-    {
-        // We are skipping unused pages
-        PageOffs lastUsedPage = inode.size / dataBytesPerPage;
-        if (inode.size % dataBytesPerPage > 0)
+        FAILPOINT;
+        if (segFrom == pageFrom && inode.size < newSize)
+        {   //this will only be applied if write succeeds
+            //Only the last segment applies it, after a power loss pages of earlier segments
+            //behind the old size are released again
+            dev->journal.addEvent(
+                    journalEntry::dataIO::NewInodeSize(inode.no, newSize, lastSegment));
+        }
+        FAILPOINT;
+        FileSize segWritten = 0;
+        res = writePageData(segFrom,
+                            segTo,
+                            (offs + *bytesWritten) % dataBytesPerPage,
+                            segBytes,
+                            &data[*bytesWritten],
+                            pac,
+                            &segWritten,
+                            inode.size,
+                            inode.reservedPages);
+        *bytesWritten += segWritten;
+        FAILPOINT;
+        if(res != Result::ok)
         {
-            lastUsedPage++;
+            //TODO: revert Statemachine
+            return res;
+        }
+        if (lastSegment && inode.size < *bytesWritten + offs)
+        {
+            inode.size = *bytesWritten + offs;
+        }
+        if (!keepModTime)
+        {
+            inode.mod = systemClock.now().convertTo<outpost::time::GpsTime>()
+                    .timeSinceEpoch().milliseconds();
         }
-    }
 
-    FAILPOINT;
-    if (inode.size < bytes + offs)
-    {   //this will only be applied if write succeeds
-        dev->journal.addEvent(journalEntry::dataIO::NewInodeSize(inode.no, bytes + offs));
-    }
-    FAILPOINT;
-    res = writePageData(pageFrom,
-                        toPage,
-                        offs % dataBytesPerPage,
-                        bytes,
-                        data,
-                        pac,
-                        bytesWritten,
-                        inode.size,
-                        inode.reservedPages);
-    FAILPOINT;
-    if(res != Result::ok)
-    {
-        //TODO: revert Statemachine
-        return res;
-    }
-    if (inode.size < *bytesWritten + offs)
-    {
-        inode.size = *bytesWritten + offs;
-    }
-    inode.mod = systemClock.now().convertTo<outpost::time::GpsTime>().timeSinceEpoch().milliseconds();
-
-	//This is the success message for dataIO and pageAddressCache
-	res = dev->tree.updateExistingInode(inode);
-	if(res != Result::ok)
-	{
-		//TODO: revert Statemachine
-		return res;
-	}
-	FAILPOINT;
-    res = statemachine.invalidateOldPages();
-    if (res != Result::ok)
-    {
-        PAFFS_DBG(PAFFS_TRACE_ERROR,
-                  "Could not set Pagestatus bc. %s. This is not handled. Expect Errors!",
-                  resultMsg[static_cast<int>(res)]);
+        //This is the success message for dataIO and pageAddressCache
+        res = dev->tree.updateExistingInode(inode);
+        if(res != Result::ok)
+        {
+            //TODO: revert Statemachine
+            return res;
+        }
+        FAILPOINT;
+        res = statemachine.invalidateOldPages();
+        if (res != Result::ok)
+        {
+            PAFFS_DBG(PAFFS_TRACE_ERROR,
+                      "Could not set Pagestatus bc. %s. This is not handled. Expect Errors!",
+                      resultMsg[static_cast<int>(res)]);
+        }
+
+        pac.setValid();
+        if (lastSegment)
+        {
+            break;
+        }
+
+        FAILPOINT;
+        if (inode.size < newSize)
+        {
+            //The next segment is announced instead of a checkpoint, so pages of this one behind
+            //the old size stay in the journal. A flush keeps the announcement in the cleared log.
+            journalEntry::dataIO::NewInodeSize next(
+                    inode.no, newSize, toPage - segTo <= maxPagesPerWrite);
+            if (dev->journal.addEvent(next) == Result::lowMem)
+            {
+                PAFFS_DBG_S(PAFFS_TRACE_WRITE, "Journal nearly full, flushing caches");
+                res = dev->flushAllCaches(&next);
+                if (res != Result::ok)
+                {
+                    return res;
+                }
+            }
+        }
+        else if (dev->journal.addEvent(journalEntry::Checkpoint(getTopic())) == Result::lowMem)
+        {
+            // Overwritten pages inside the file are kept after a power loss
+            PAFFS_DBG_S(PAFFS_TRACE_WRITE, "Journal nearly full, flushing caches");
+            res = dev->flushAllCaches();
+            if (res != Result::ok)
+            {
+                return res;
+            }
+        }
     }
-	
-    pac.setValid();
 
     //Checkpoint is done by device functions, because a write-truncate pair has to be kept together
     return res;
@@ -259,14 +299,43 @@ DataIO::deleteInodeData(Inode& inode, unsigned int offs, bool journalMode)
             }
             FAILPOINT;
             // Mark old pages dirty
-            statemachine.replacePage(0, pageAddr, inode.no, page + pageFrom);
-
+            r = statemachine.replacePage(0, pageAddr, inode.no, page + pageFrom);
+            if (r == Result::lowMem)
+            {
+                //The page state machine only holds maxPagesPerWrite pages, so the pages behind
+                //this one are deleted first. After a power loss, deletion continues from here.
+                inode.size = (page + pageFrom + 1) * dataBytesPerPage;
+                dev->tree.updateExistingInode(inode);
+                FAILPOINT;
+                statemachine.invalidateOldPages();
+                pac.setValid();
+                FAILPOINT;
+                if (dev->journal.addEvent(journalEntry::Checkpoint(getTopic())) == Result::lowMem
+                    && !journalMode)
+                {
+                    PAFFS_DBG_S(PAFFS_TRACE_WRITE, "Journal nearly full, flushing caches");
+                    r = dev->flushAllCaches();
+                    if (r != Result::ok)
+                    {
+                        return r;
+                    }
+                    r = pac.setTargetInode(inode);
+                    if (r != Result::ok)
+                    {
+                        PAFFS_DBG(PAFFS_TRACE_ERROR, "could not set new Inode!");
+                        return r;
+                    }
+                }
+                FAILPOINT;
+                dev->journal.addEvent(journalEntry::dataIO::NewInodeSize(inode.no, offs));
+                FAILPOINT;
+                r = statemachine.replacePage(0, pageAddr, inode.no, page + pageFrom);
+            }
             if (r != Result::ok)
             {
                 PAFFS_DBG(PAFFS_TRACE_ERROR,
-                          "Could not write AreaSummary for area %" PRId16 ","
-                          " so no invalidation of data!",
-                          area);
+                          "Could not mark page %" PRIu32 " of Inode %" PTYPE_INODENO " as old!",
+                          page + pageFrom, inode.no);
                 return r;
             }
             FAILPOINT;
@@ -292,6 +361,18 @@ DataIO::deleteInodeData(Inode& inode, unsigned int offs, bool journalMode)
     return Result::ok;
 }
 
+const DataIOStatistics&
+DataIO::getStatistics()
+{
+    return mStats;
+}
+
+void
+DataIO::resetStatistics()
+{
+    memset(&mStats, 0, sizeof(DataIOStatistics));
+}
+
 JournalEntry::Topic
 DataIO::getTopic()
 {
@@ -304,6 +385,7 @@ DataIO::resetState()
     statemachine.clear();
     memset(&journalLastModifiedInode, 0, sizeof(Inode));
     journalLastSize = 0;
+    journalLastSizeIsFinal = false;
     journalInodeValid = false;
     modifiedInode = false;
     processedForeignSuccessElement = false;
@@ -326,6 +408,21 @@ DataIO::processEntry(const journalEntry::Max& entry, JournalEntryPosition)
         switch(entry.dataIO.operation)
         {
         case journalEntry::DataIO::Operation::newInodeSize:
+            if(journalInodeValid &&
+               journalLastModifiedInode.no == entry.dataIO_.newInodeSize.inodeNo &&
+               journalLastSize == entry.dataIO_.newInodeSize.filesize &&
+               !journalLastSizeIsFinal)
+            {
+                //Next segment of a write, so the one before succeeded
+                if(statemachine.getState() == JournalState::recover)
+                {
+                    statemachine.signalEndOfLog();
+                }
+                journalLastSizeIsFinal = entry.dataIO_.newInodeSize.lastSegment;
+                modifiedInode = false;
+                processedForeignSuccessElement = false;
+                return Result::ok;
+            }
             if(journalInodeValid &&
                journalLastModifiedInode.no == entry.dataIO_.newInodeSize.inodeNo &&
                journalLastSize == entry.dataIO_.newInodeSize.filesize)
@@ -338,6 +435,7 @@ DataIO::processEntry(const journalEntry::Max& entry, JournalEntryPosition)
 
             journalLastModifiedInode.no = entry.dataIO_.newInodeSize.inodeNo;
             journalLastSize = entry.dataIO_.newInodeSize.filesize;
+            journalLastSizeIsFinal = entry.dataIO_.newInodeSize.lastSegment;
             journalInodeValid = true;
             modifiedInode = false;
         }
@@ -369,6 +467,8 @@ void
 DataIO::signalEndOfLog()
 {
     JournalState state = statemachine.signalEndOfLog();
+    //Pages of the Inode may still be in replayed address lists
+    pac.finishReplay();
     if(journalInodeValid &&
             (state == JournalState::recover || //we continued action
             (state == JournalState::invalid && journalIsWriteTruncatePair) ||
@@ -388,7 +488,8 @@ DataIO::signalEndOfLog()
                       journalLastModifiedInode.no, journalLastModifiedInode.size, journalLastSize);
             if(journalLastModifiedInode.size < journalLastSize)
             {   //write
-                if(modifiedInode)
+                //Success of an earlier segment does not apply the size of the whole write
+                if(modifiedInode && journalLastSizeIsFinal)
                 {
                     journalLastModifiedInode.size = journalLastSize;
                     dev->tree.updateExistingInode(journalLastModifiedInode);
@@ -402,6 +503,19 @@ DataIO::signalEndOfLog()
         }
 
     }
+    if(journalInodeValid && !journalIsWriteTruncatePair &&
+       dev->tree.getInode(journalLastModifiedInode.no, journalLastModifiedInode) == Result::ok &&
+       journalLastModifiedInode.size < journalLastSize)
+    {
+        //An interrupted write of several segments may have left pages of finished segments
+        //behind the old size. Size stays, so release them by truncating from the intended size.
+        FileSize size = journalLastModifiedInode.size;
+        PAFFS_DBG_S(PAFFS_TRACE_DEVICE | PAFFS_TRACE_JOURNAL,
+                    "Releasing pages of Inode %" PTYPE_INODENO " behind %" PTYPE_FILSIZE,
+                    journalLastModifiedInode.no, size);
+        journalLastModifiedInode.size = journalLastSize;
+        deleteInodeData(journalLastModifiedInode, size, true);
+    }
     //If an area was filled
     dev->areaMgmt.manageActiveAreaFull(AreaType::data);
     dev->areaMgmt.manageActiveAreaFull(AreaType::index);
@@ -527,6 +641,7 @@ DataIO::writePageData(PageAbs  pageFrom,
             if (oldAddr != 0)  // not an empty page TODO: doubled code)
             {  // not a skipped page (thus containing no information)
                 // We are overriding real data, not just empty space
+                mStats.readModifyWrites++;
                 FileSize bytesRead = 0;
                 Result r = readPageData(
                         pageFrom + page, pageFrom + page, 0, btr, buf, ac, &bytesRead);
@@ -559,6 +674,7 @@ DataIO::writePageData(PageAbs  pageFrom,
             *bytesWritten += btw;
         }
         FAILPOINT;
+        readCache.invalidate(newAddress);
         res = dev->driver.writePage(getPageNumber(newAddress, *dev), buf, btw);
         if (res != Result::ok)
         {
@@ -568,6 +684,7 @@ DataIO::writePageData(PageAbs  pageFrom,
             //TODO: Revert all new Pages
             return res;
         }
+        mStats.pagesWritten++;
         FAILPOINT;
         ac.setPage(page + pageFrom, newAddress);
 
@@ -639,18 +756,11 @@ DataIO::readPageData(PageAbs  pageFrom,
             return Result::bug;
         }
 
-        PageAbs physPage = getPageNumber(pageAddr, *dev);
-        uint8_t* buf = dev->driver.getPageBuffer();
-        r = dev->driver.readPage(physPage, buf, btr);
-        if (r != Result::ok)
+        const uint8_t* buf = readCache.get(pageAddr, btr);
+        if (buf == nullptr)
         {
-            if (r == Result::biterrorCorrected)
-            {
-                // TODO rewrite page
-                PAFFS_DBG(PAFFS_TRACE_ALWAYS, "Corrected biterror, but we do not yet write "
-                                              "corrected version back to flash.");
-            }
-            else
+            r = readCachedPage(pageAddr, btr, buf);
+            if (r != Result::ok)
             {
                 PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not read page at "
                         "%" PTYPE_AREAPOS "(on %" PTYPE_AREAPOS "):%" PTYPE_PAGEOFFS
@@ -668,6 +778,32 @@ DataIO::readPageData(PageAbs  pageFrom,
     return Result::ok;
 }
 
+Result
+DataIO::readCachedPage(Addr pageAddr, uint16_t bytes, const uint8_t*& buf)
+{
+    if (readCache.contains(pageAddr))
+    {
+        // Only the beginning was read before, following reads of this page get the rest
+        bytes = dataBytesPerPage;
+    }
+    uint8_t* slot = readCache.put(pageAddr, bytes);
+    Result r = dev->driver.readPage(getPageNumber(pageAddr, *dev), slot, bytes);
+    if (r == Result::biterrorCorrected)
+    {
+        // TODO rewrite page
+        PAFFS_DBG(PAFFS_TRACE_ALWAYS, "Corrected biterror, but we do not yet write "
+                                      "corrected version back to flash.");
+        r = Result::ok;
+    }
+    if (r != Result::ok)
+    {
+        readCache.invalidate(pageAddr);
+        return r;
+    }
+    buf = slot;
+    return Result::ok;
+}
+
 
 bool DataIO::checkIfSaneReadAddress(Addr pageAddr)
 {
@@ -18,25 +18,35 @@
 #include "btree.hpp"
 #include "commonTypes.hpp"
 #include "pageAddressCache.hpp"
+#include "readCache.hpp"
 #include "superblock.hpp"
 #include "journalPageStatemachine.hpp"
 
 namespace paffs
 {
 
+struct DataIOStatistics
+{
+    uint32_t pagesWritten;      // data pages programmed to flash
+    uint32_t readModifyWrites;  // pages that had to be merged with their old content
+};
+
 class DataIO : public JournalTopic
 {
     Device* dev;
 public:
     PageAddressCache pac;
+    ReadCache readCache;
 private:
     PageStateMachine<maxPagesPerWrite, maxPagesPerWrite, JournalEntry::Topic::dataIO> statemachine;
     Inode journalLastModifiedInode;
     FileSize journalLastSize = 0;
+    bool journalLastSizeIsFinal = false;
     bool journalInodeValid = false;
     bool modifiedInode = false;
     bool processedForeignSuccessElement = false;
     bool journalIsWriteTruncatePair = false;
+    DataIOStatistics mStats;
 public:
 
     DataIO(Device* mdev);
@@ -44,13 +54,15 @@ public:
     /**
      *  requires a checkpoint to be done from the outside because
      *  it may be combined to a write-truncate pair
+     *  @param keepModTime leaves the modification time as is, for moving unchanged data
      */
     Result
     writeInodeData(Inode& inode,
                    FileSize offs,
                    FileSize bytes,
                    FileSize* bytesWritten,
-                   const uint8_t* data);
+                   const uint8_t* data,
+                   bool keepModTime = false);
     Result
     readInodeData(Inode& inode,
                   FileSize offs,
@@ -60,6 +72,11 @@ public:
     Result
     deleteInodeData(Inode& inode, unsigned int offs, bool journalMode = false);
 
+    const DataIOStatistics&
+    getStatistics();
+    void
+    resetStatistics();
+
     JournalEntry::Topic
     getTopic() override;
     void
@@ -93,6 +110,12 @@ private:
                  uint8_t* data,
                  PageAddressCache& ac,
                  FileSize* bytes_read);
+    /**
+     * Reads the first \p bytes of a data page from flash into the read cache.
+     * A page that is read again is read completely.
+     */
+    Result
+    readCachedPage(Addr pageAddr, uint16_t bytes, const uint8_t*& buf);
 
     bool checkIfSaneReadAddress(Addr pageAddr);
 };
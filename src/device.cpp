@@ -46,7 +46,8 @@ Device::Device(Driver& _driver) :
       journalPersistence(this),
       journal(journalPersistence, superblock, areaMgmt,
               areaMgmt.gc, sumCache, tree,
-              dataIO, dataIO.pac, *this){};
+              dataIO, dataIO.pac, *this),
+      staging(this){};
 
 Device::~Device()
 {
@@ -270,6 +271,7 @@ Device::format(const BadBlockList& badBlockList, bool complete)
         return r;
     }
     journal.clear();
+    staging.clear();
     PAFFS_DBG_S(PAFFS_TRACE_INFO, "Done");
 
     destroyDevice();
@@ -379,44 +381,52 @@ Device::mnt(bool readOnlyMode)
 
     // TODO: Supress decrease or increase reference to node 0 manually
     mounted = true;
+
+    if (!readOnly)
+    {
+        r = replayStagedWrites();
+        if (r != Result::ok)
+        {
+            PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not write staged data to flash");
+            mounted = false;
+            return r;
+        }
+        // Recovery may have used up the space reserved for the next operation
+        if (journal.addEvent(journalEntry::Checkpoint(getTopic())) == Result::lowMem)
+        {
+            PAFFS_DBG_S(PAFFS_TRACE_DEVICE, "Journal nearly full after replay, flushing caches");
+            r = flushAllCaches();
+            if (r != Result::ok)
+            {
+                PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not flush caches after replay");
+                mounted = false;
+                return r;
+            }
+        }
+    }
     PAFFS_DBG_S(PAFFS_TRACE_VERBOSE, "Mount successful");
     return r;
 }
 
 Result
-Device::flushAllCaches()
+Device::flushAllCaches(const JournalEntry* keep)
 {
     if (!mounted)
      {
          return Result::notMounted;
      }
-     Result r;
+     Result r = areaMgmt.gc.finishPendingCollection();
+     if (r != Result::ok)
+     {
+         PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not finish pending garbage collection!");
+         return r;
+     }
 
-     InodePool<maxNumberOfInodes>::InodeMap::iterator it = inodePool.map.begin();
-     if (it != inodePool.map.end())
+     r = dataIO.pac.commitAll();
+     if (r != Result::ok)
      {
-         while (it != inodePool.map.end())
-         {
-             PAFFS_DBG_S(PAFFS_TRACE_DEVICE,
-                         "Commit Inode %" PTYPE_INODENO " with %" PRIu8 " references",
-                         it->first,
-                         it->second.second);
-             // TODO: Later, we would choose the actual pac instance (or the PAC will choose the
-             // actual Inode...
-             r = dataIO.pac.setTargetInode(*it->second.first);
-             if (r != Result::ok)
-             {
-                 // we ignore Result, because we unmount.
-                 PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not load pac of an open file");
-             }
-             r = dataIO.pac.commit();
-             if (r != Result::ok)
-             {
-                 // we ignore Result, because we unmount.
-                 PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not commit pac of an open file");
-             }
-             it++;
-         }
+         // we ignore Result, because we unmount.
+         PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not commit address lists of open files");
      }
 
      r = tree.commitCache();
@@ -438,15 +448,212 @@ Device::flushAllCaches()
          debugPrintStatus();
      }
 
-     journal.clear();
+     journal.clear(keep);
 
      return Result::ok;
 }
 
+Result
+Device::collectGarbage(PageOffs budget, bool& idle)
+{
+    idle = true;
+    if (!mounted)
+    {
+        return Result::notMounted;
+    }
+    if (readOnly)
+    {
+        return Result::readOnly;
+    }
+    return areaMgmt.gc.collectGarbage(budget, idle);
+}
+
+Result
+Device::levelWear(PageOffs budget, bool& idle)
+{
+    idle = true;
+    if (!mounted)
+    {
+        return Result::notMounted;
+    }
+    if (readOnly)
+    {
+        return Result::readOnly;
+    }
+    return areaMgmt.gc.levelWear(budget, idle);
+}
+
+Result
+Device::eraseQueuedAreas(AreaPos maxAreas, bool& idle)
+{
+    idle = true;
+    if (!mounted)
+    {
+        return Result::notMounted;
+    }
+    if (readOnly)
+    {
+        return Result::readOnly;
+    }
+    return areaMgmt.eraseQueuedAreas(maxAreas, idle);
+}
+
+Result
+Device::compactGarbage(bool& idle)
+{
+    idle = true;
+    if (!mounted)
+    {
+        return Result::notMounted;
+    }
+    if (readOnly)
+    {
+        return Result::readOnly;
+    }
+    AreaPos victims[areasNo];
+    AreaPos victimCount = areaMgmt.gc.findCompactionVictims(victims, areasNo);
+    if (victimCount == 0)
+    {
+        return Result::ok;
+    }
+    idle = false;
+    BitList<areasNo> victimAreas;
+    for (AreaPos i = 0; i < victimCount; i++)
+    {
+        victimAreas.setBit(victims[i]);
+    }
+
+    // There is no reverse mapping from pages to inodes, so every inode is checked
+    uint32_t rewrittenPages = 0;
+    InodeCursor cursor;
+    Inode next;
+    Result r;
+    tree.openCursor(cursor);
+    while ((r = tree.nextInode(cursor, next)) == Result::ok)
+    {
+        SmartInodePtr inode;
+        r = findOrLoadInode(next.no, inode);
+        if (r != Result::ok)
+        {
+            PAFFS_DBG(PAFFS_TRACE_ERROR,
+                      "Could not load Inode %" PTYPE_INODENO " for compaction", next.no);
+            tree.closeCursor(cursor);
+            return r;
+        }
+        r = rewritePagesInAreas(*inode, victimAreas, rewrittenPages);
+        if (r != Result::ok)
+        {
+            tree.closeCursor(cursor);
+            return r;
+        }
+    }
+    if (r != Result::notFound)
+    {
+        return r;
+    }
+
+    AreaPos freedAreas = 0;
+    for (AreaPos i = 0; i < victimCount; i++)
+    {
+        // Address lists are in index areas, so only pages no inode references are left
+        if (sumCache.getUsedPages(victims[i]) == 0
+            && superblock.getStatus(victims[i]) == AreaStatus::closed)
+        {
+            r = areaMgmt.queueErase(victims[i]);
+            if (r != Result::ok)
+            {
+                return r;
+            }
+            freedAreas++;
+        }
+    }
+    areaMgmt.gc.recordCompaction(rewrittenPages, freedAreas);
+    PAFFS_DBG_S(PAFFS_TRACE_GC,
+                "Compaction rewrote %" PRIu32 " pages and freed %" PTYPE_AREAPOS " areas",
+                rewrittenPages, freedAreas);
+    return Result::ok;
+}
+
+Result
+Device::rewritePagesInAreas(Inode& inode, BitList<areasNo>& areas, uint32_t& rewrittenPages)
+{
+    if (inode.type == InodeType::lnk)
+    {
+        return Result::ok;
+    }
+    Result r = dataIO.pac.setTargetInode(inode);
+    if (r != Result::ok)
+    {
+        return r;
+    }
+    uint8_t buf[dataBytesPerPage];
+    PageNo pages = (inode.size + dataBytesPerPage - 1) / dataBytesPerPage;
+    for (PageNo page = 0; page < pages; page++)
+    {
+        Addr addr;
+        r = dataIO.pac.getPage(page, &addr);
+        if (r != Result::ok)
+        {
+            return r;
+        }
+        if (extractLogicalArea(addr) == 0 || !areas.getBit(extractLogicalArea(addr)))
+        {
+            continue;
+        }
+        FileSize offs = page * dataBytesPerPage;
+        FileSize bytes = inode.size - offs;
+        if (bytes > dataBytesPerPage)
+        {
+            bytes = dataBytesPerPage;
+        }
+        FileSize bytesDone;
+        r = dataIO.readInodeData(inode, offs, bytes, &bytesDone, buf);
+        if (r != Result::ok && r != Result::biterrorCorrected)
+        {
+            PAFFS_DBG(PAFFS_TRACE_ERROR,
+                      "Could not read page %" PRIu32 " of Inode %" PTYPE_INODENO,
+                      page, inode.no);
+            return r;
+        }
+        FAILPOINT;
+        // The file content does not change
+        r = dataIO.writeInodeData(inode, offs, bytes, &bytesDone, buf, true);
+        FAILPOINT;
+        journal.addEvent(journalEntry::Checkpoint(JournalEntry::Topic::dataIO));
+        if (r != Result::ok)
+        {
+            PAFFS_DBG(PAFFS_TRACE_ERROR,
+                      "Could not rewrite page %" PRIu32 " of Inode %" PTYPE_INODENO,
+                      page, inode.no);
+            return r;
+        }
+        rewrittenPages++;
+    }
+    r = dataIO.pac.commit();
+    if (r != Result::ok)
+    {
+        PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not commit PAC");
+        return r;
+    }
+    r = journal.addEvent(journalEntry::Checkpoint(getTopic()));
+    if (r == Result::lowMem)
+    {
+        PAFFS_DBG_S(PAFFS_TRACE_DEVICE, "Journal nearly full, flushing caches");
+        return flushAllCaches();
+    }
+    return Result::ok;
+}
+
 Result
 Device::unmnt()
 {
-    Result r = flushAllCaches();
+    Result r = flushWriteBuffers(nullptr);
+    if (r != Result::ok)
+    {
+        PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not flush write buffers for unmount");
+        return r;
+    }
+    r = flushAllCaches();
     if(r != Result::ok)
     {
         PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not flush caches for unmount");
@@ -468,21 +675,10 @@ Device::debugPrintStatus()
     printf("Info: \n\t%" PTYPE_AREAPOS " used Areas\n", superblock.getUsedAreas());
     for (AreaPos i = 0; i < areasNo; i++)
     {
-        SummaryEntry summary[dataPagesPerArea];
+        TwoBitList<dataPagesPerArea> summary;
         sumCache.getSummaryStatus(i, summary);
-        PageOffs dirtyPages = 0;
-        PageOffs freePages = 0;
-        for(PageOffs p = 0; p < dataPagesPerArea; p++)
-        {
-            if(summary[p] == SummaryEntry::dirty)
-            {
-                dirtyPages++;
-            }
-            if(summary[p] == SummaryEntry::free)
-            {
-                freePages++;
-            }
-        }
+        PageOffs dirtyPages = summary.countValue(static_cast<uint8_t>(SummaryEntry::dirty));
+        PageOffs freePages = summary.countValue(static_cast<uint8_t>(SummaryEntry::free));
         printf("\tArea %03" PTYPE_AREAPOS " on %03" PTYPE_AREAPOS " as %6s "
                 "(%3" PTYPE_PAGEOFFS "/%3" PTYPE_PAGEOFFS " dirty/free) %s\n",
                i,
@@ -503,7 +699,6 @@ Device::debugPrintStatus()
 Result
 Device::createInode(SmartInodePtr& outInode, Permission mask)
 {
-    // FIXME: is this the best way to find a new number?
     InodeNo no;
     Result r = tree.findFirstFreeNo(&no);
     if (r != Result::ok)
@@ -1180,7 +1375,7 @@ Device::mkDir(const char* fullPath, Permission mask)
     {
         return Result::readOnly;
     }
-    if (superblock.getUsedAreas() > areasNo - minFreeAreas)
+    if (superblock.getUsedAreas() - areaMgmt.getQueuedErases() > areasNo - minFreeAreas)
     {
         return Result::noSpace;
     }
@@ -1429,7 +1624,7 @@ Device::createFile(SmartInodePtr& outFile, const char* fullPath, Permission mask
     {
         return Result::readOnly;
     }
-    if (superblock.getUsedAreas() > areasNo - minFreeAreas)
+    if (superblock.getUsedAreas() - areaMgmt.getQueuedErases() > areasNo - minFreeAreas)
     {
         return Result::noSpace;
     }
@@ -1562,6 +1757,20 @@ Device::open(const char* path, Fileopenmask mask)
     }
 
     obj->rdnly = !(mask & FW);
+    obj->fo = mask;
+    obj->writeBuffer = nullptr;
+    if (mask & FB)
+    {
+        if (writeBufferPool.getNewObject(obj->writeBuffer) == Result::ok)
+        {
+            obj->writeBuffer->bytes = 0;
+        }
+        else
+        {
+            PAFFS_DBG_S(PAFFS_TRACE_DEVICE, "No write buffer left, obj %" PTYPE_INODENO
+                        " writes to flash directly", obj->dirent.no);
+        }
+    }
     return obj;
 }
 
@@ -1572,12 +1781,22 @@ Device::close(Obj& obj)
     {
         return Result::notMounted;
     }
-    Result r = flush(obj);
+    // The object stays open while buffered data can not be written, so closing may be retried
+    Result r = flushWriteBuffer(obj);
+    if (r != Result::ok)
+    {
+        return r;
+    }
+    r = flush(obj);
     if (r != Result::ok)
     {
         PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not flush obj %" PRIu32, obj.dirent.no);
     }
 
+    if (obj.writeBuffer != nullptr)
+    {
+        writeBufferPool.freeObject(*obj.writeBuffer);
+    }
     delete[] obj.dirent.name;
     filesPool.freeObject(obj);
     return r;
@@ -1594,7 +1813,7 @@ Device::touch(const char* path)
     {
         return Result::readOnly;
     }
-    if (superblock.getUsedAreas() > areasNo - minFreeAreas)
+    if (superblock.getUsedAreas() - areaMgmt.getQueuedErases() > areasNo - minFreeAreas)
     {   // If we use reserved Areas, extensive touching may fill flash
         return Result::noSpace;
     }
@@ -1665,14 +1884,21 @@ Device::read(Obj& obj, void* buf, FileSize bytesToRead, FileSize* bytesRead)
     if ((obj.dirent.node->perm & R) == 0)
         return Result::noPerm;
 
+    // Other objects of the same file may hold newer data in their buffers
+    Result r = flushWriteBuffers(obj.dirent.node);
+    if (r != Result::ok)
+    {
+        return r;
+    }
+
     if (obj.dirent.node->size == 0)
     {
         *bytesRead = 0;
         return Result::ok;
     }
 
-    Result r = dataIO.readInodeData(*obj.dirent.node, obj.fp, bytesToRead,
-                                    bytesRead, static_cast<uint8_t*>(buf));
+    r = dataIO.readInodeData(*obj.dirent.node, obj.fp, bytesToRead,
+                             bytesRead, static_cast<uint8_t*>(buf));
     if (r != Result::ok)
     {
         return r;
@@ -1696,10 +1922,6 @@ Device::write(Obj& obj, const void* buf, FileSize bytesToWrite,
     {
         return Result::readOnly;
     }
-    if (superblock.getUsedAreas() > areasNo - minFreeAreas)
-    {
-        return Result::noSpace;
-    }
     if (obj.dirent.node == nullptr)
     {
         PAFFS_DBG(PAFFS_TRACE_BUG, "Objects dirent.node is invalid!");
@@ -1719,11 +1941,34 @@ Device::write(Obj& obj, const void* buf, FileSize bytesToWrite,
         return Result::noPerm;
     }
 
+    // Older data buffered by other objects of the same file must not overwrite this write later
+    Result r = flushWriteBuffers(obj.dirent.node, &obj);
+    if (r != Result::ok)
+    {
+        return r;
+    }
+    if (obj.writeBuffer != nullptr)
+    {
+        return bufferObjData(obj, static_cast<const uint8_t*>(buf), bytesToWrite, bytesWritten);
+    }
+    return writeObjData(obj, static_cast<const uint8_t*>(buf), bytesToWrite, bytesWritten);
+}
+
+Result
+Device::writeObjData(Obj& obj, const uint8_t* data, FileSize bytesToWrite,
+                     FileSize* bytesWritten)
+{
+    // Queued areas are erased on demand, so they do not count as used here
+    if (superblock.getUsedAreas() - areaMgmt.getQueuedErases() > areasNo - minFreeAreas)
+    {
+        return Result::noSpace;
+    }
+
     //TODO: Is inconsistent between write and update filsize.
     //TODO: Maybe include in dataIO!
     FAILPOINT;
     Result r = dataIO.writeInodeData(*obj.dirent.node, obj.fp,
-                                     bytesToWrite, bytesWritten, static_cast<const uint8_t*>(buf));
+                                     bytesToWrite, bytesWritten, data);
     FAILPOINT;
     journal.addEvent(journalEntry::Checkpoint(JournalEntry::Topic::dataIO));
     if (r != Result::ok)
@@ -1744,6 +1989,7 @@ Device::write(Obj& obj, const void* buf, FileSize bytesToWrite,
         // TODO: Handle error, maybe rewrite
         return Result::fail;
     }
+    obj.fp += *bytesWritten;
     r = journal.addEvent(journalEntry::Checkpoint(getTopic()));
     if(r == Result::lowMem)
     {
@@ -1751,7 +1997,6 @@ Device::write(Obj& obj, const void* buf, FileSize bytesToWrite,
         return flushAllCaches();
     }
 
-    obj.fp += *bytesWritten;
     if (obj.fp > obj.dirent.node->size)
     {
         // size was increased
@@ -1765,6 +2010,154 @@ Device::write(Obj& obj, const void* buf, FileSize bytesToWrite,
     return Result::ok;
 }
 
+Result
+Device::bufferObjData(Obj& obj, const uint8_t* data, FileSize bytes, FileSize* bytesWritten)
+{
+    WriteBuffer& buffer = *obj.writeBuffer;
+    Result r;
+    if (buffer.bytes > 0 && obj.fp != buffer.start + buffer.bytes)
+    {
+        r = flushWriteBuffer(obj);
+        if (r != Result::ok)
+        {
+            return r;
+        }
+    }
+
+    while (*bytesWritten < bytes)
+    {
+        FileSize rest = bytes - *bytesWritten;
+        FileSize pageRest = dataBytesPerPage - obj.fp % dataBytesPerPage;
+        if (buffer.bytes == 0 && pageRest == dataBytesPerPage && rest >= dataBytesPerPage)
+        {
+            // Whole pages need no read-modify-write, so they do not have to be buffered
+            FileSize bw = 0;
+            r = writeObjData(obj, &data[*bytesWritten], rest - rest % dataBytesPerPage, &bw);
+            *bytesWritten += bw;
+            if (r != Result::ok)
+            {
+                return r;
+            }
+            continue;
+        }
+
+        FileSize chunk = rest < pageRest ? rest : pageRest;
+        if (buffer.bytes == 0)
+        {
+            buffer.start = obj.fp;
+        }
+        memcpy(&buffer.data[buffer.bytes], &data[*bytesWritten], chunk);
+        staging.stage(writeBufferPool.getIndex(buffer), obj.dirent.no, buffer.start,
+                      buffer.data, buffer.bytes, chunk);
+        buffer.bytes += chunk;
+        obj.fp += chunk;
+        *bytesWritten += chunk;
+        if (obj.fp % dataBytesPerPage == 0)
+        {
+            r = flushWriteBuffer(obj);
+            if (r != Result::ok)
+            {
+                return r;
+            }
+        }
+    }
+    return Result::ok;
+}
+
+Result
+Device::flushWriteBuffer(Obj& obj)
+{
+    if (obj.writeBuffer == nullptr || obj.writeBuffer->bytes == 0)
+    {
+        return Result::ok;
+    }
+    WriteBuffer& buffer = *obj.writeBuffer;
+    PAFFS_DBG_S(PAFFS_TRACE_WRITE, "Flushing %" PRIu16 " buffered bytes at %" PTYPE_FILSIZE
+                " of obj %" PTYPE_INODENO, buffer.bytes, buffer.start, obj.dirent.no);
+    FileSize fp = obj.fp;
+    obj.fp = buffer.start;
+    FileSize bw = 0;
+    Result r = writeObjData(obj, buffer.data, buffer.bytes, &bw);
+    obj.fp = fp;
+    if (r != Result::ok)
+    {
+        // Keep the data, so the flush may be retried
+        PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not flush write buffer of obj %" PTYPE_INODENO,
+                  obj.dirent.no);
+        return r;
+    }
+    buffer.bytes = 0;
+    staging.unstage(writeBufferPool.getIndex(buffer));
+    return Result::ok;
+}
+
+Result
+Device::flushWriteBuffers(const Inode* inode, const Obj* except)
+{
+    for (uint16_t i = 0; i < maxNumberOfFiles; i++)
+    {
+        if (!filesPool.activeObjects.getBit(i))
+        {
+            continue;
+        }
+        Obj& obj = filesPool.objects[i];
+        if ((inode != nullptr && obj.dirent.no != inode->no) || &obj == except)
+        {
+            continue;
+        }
+        Result r = flushWriteBuffer(obj);
+        if (r != Result::ok)
+        {
+            return r;
+        }
+    }
+    return Result::ok;
+}
+
+Result
+Device::replayStagedWrites()
+{
+    std::unique_ptr<uint8_t[]> data(new uint8_t[dataBytesPerPage]);
+    for (uint8_t slot = 0; slot < maxWriteBufferedFiles; slot++)
+    {
+        StagedWrite staged;
+        if (!staging.read(slot, staged, data.get()))
+        {
+            continue;
+        }
+        PAFFS_DBG_S(PAFFS_TRACE_DEVICE, "Writing %" PRIu16 " staged bytes at %" PTYPE_FILSIZE
+                    " of Inode %" PTYPE_INODENO, staged.bytes, staged.offs, staged.inode);
+        SmartInodePtr inode;
+        Result r = findOrLoadInode(staged.inode, inode);
+        if (r == Result::notFound)
+        {
+            // File was removed after the data was staged
+            staging.unstage(slot);
+            continue;
+        }
+        if (r != Result::ok)
+        {
+            return r;
+        }
+        // Rewriting data that already reached flash before the power loss does no harm
+        FileSize bw = 0;
+        r = dataIO.writeInodeData(*inode, staged.offs, staged.bytes, &bw, data.get());
+        journal.addEvent(journalEntry::Checkpoint(JournalEntry::Topic::dataIO));
+        if (r != Result::ok)
+        {
+            return r;
+        }
+        r = dataIO.pac.commit();
+        if (r != Result::ok)
+        {
+            return r;
+        }
+        journal.addEvent(journalEntry::Checkpoint(getTopic()));
+        staging.unstage(slot);
+    }
+    return Result::ok;
+}
+
 Result
 Device::seek(Obj& obj, FileSizeDiff m, Seekmode mode)
 {
@@ -1772,6 +2165,12 @@ Device::seek(Obj& obj, FileSizeDiff m, Seekmode mode)
     {
         return Result::notMounted;
     }
+    // The size of the file may change with the buffers of other objects
+    Result r = flushWriteBuffers(obj.dirent.node);
+    if (r != Result::ok)
+    {
+        return r;
+    }
     switch (mode)
     {
     case Seekmode::set:
@@ -1806,8 +2205,14 @@ Device::flush(Obj& obj)
         return Result::ok;
     }
 
+    Result r = flushWriteBuffer(obj);
+    if (r != Result::ok)
+    {
+        return r;
+    }
+
     // TODO: When Inodes get Link to its PAC, this would be more elegant
-    Result r = dataIO.pac.setTargetInode(*obj.dirent.node);
+    r = dataIO.pac.setTargetInode(*obj.dirent.node);
     if (r != Result::ok)
     {
         PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not set Target Inode!");
@@ -1860,6 +2265,11 @@ Device::truncate(const char* path, FileSize newLength, bool fromUserspace)
             return Result::dirNotEmpty;
         }
     }
+    // Buffered data behind the new length must not be written afterwards
+    if ((r = flushWriteBuffers(object)) != Result::ok)
+    {
+        return r;
+    }
     FAILPOINT;
     r = dataIO.deleteInodeData(*object, newLength);
     if (r != Result::ok)
@@ -1995,6 +2405,17 @@ Device::getNumberOfOpenInodes()
     return inodePool.getUsage();
 }
 
+Result
+Device::referenceInode(Inode& inode, SmartInodePtr& target)
+{
+    InodePool<maxNumberOfInodes>::InodeMap::iterator it = inodePool.map.find(inode.no);
+    if (it == inodePool.map.end() || it->second.first != &inode)
+    {
+        return Result::notFound;
+    }
+    return inodePool.getExistingInode(inode.no, target);
+}
+
 JournalEntry::Topic
 Device::getTopic()
 {
@@ -2158,9 +2579,12 @@ Device::destroyDevice()
 {
     journalState = JournalState::ok;
     superblock.clear();
+    // Address lists may still reference pooled Inodes
+    dataIO.pac.clear();
     inodePool.clear();
     filesPool.clear();
-    dataIO.pac.clear();
+    writeBufferPool.clear();
+    dataIO.readCache.clear();
     sumCache.clear();
     return Result::ok;
 }
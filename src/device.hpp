@@ -20,6 +20,7 @@
 #include "journal.hpp"
 #include "summaryCache.hpp"
 #include "superblock.hpp"
+#include "writeStaging.hpp"
 #include <outpost/rtos/clock.h>
 #include <outpost/time/clock.h>
 
@@ -36,6 +37,7 @@ class Device : public JournalTopic
 {
     InodePool<maxNumberOfInodes> inodePool;
     ObjectPool<Obj, maxNumberOfFiles> filesPool;
+    ObjectPool<WriteBuffer, maxWriteBufferedFiles> writeBufferPool;
     bool useJournal = false;
 
     InodeNo targetInodeNo = 0;
@@ -61,6 +63,7 @@ public:
     Superblock superblock;
     MramPersistence journalPersistence;
     Journal journal;
+    WriteStaging staging;
 
     Device(Driver& driver);
     ~Device();
@@ -77,11 +80,37 @@ public:
 
     Result
     mnt(bool readOnlyMode = false);
+    /**
+     * \param[in] keep if not null, is logged into the cleared journal together with clearing it
+     */
     Result
-    flushAllCaches();
+    flushAllCaches(const JournalEntry* keep = nullptr);
     Result
     unmnt();
 
+    /**
+     * Incremental garbage collection, see GarbageCollection::collectGarbage(PageOffs, bool&)
+     */
+    Result
+    collectGarbage(PageOffs budget, bool& idle);
+    /**
+     * Compacting garbage collection. Rewrites the valid pages of sparsely used
+     * data areas densely into the active data area and deletes the victims.
+     * \p idle is set if no area was worth compacting.
+     */
+    Result
+    compactGarbage(bool& idle);
+    /**
+     * Static wear leveling, see GarbageCollection::levelWear
+     */
+    Result
+    levelWear(PageOffs budget, bool& idle);
+    /**
+     * Erases areas queued for erasure, see AreaManagement::eraseQueuedAreas
+     */
+    Result
+    eraseQueuedAreas(AreaPos maxAreas, bool& idle);
+
     void
     debugPrintStatus();
 
@@ -126,6 +155,12 @@ public:
     getNumberOfOpenFiles();
     uint8_t
     getNumberOfOpenInodes();
+    /**
+     * References \p inode if it is the instance in the Inode pool, so it stays loaded
+     * \return Result::notFound if \p inode is a copy
+     */
+    Result
+    referenceInode(Inode& inode, SmartInodePtr& target);
     Result
     checkFolderSanity(InodeNo folderNo);
 
@@ -170,6 +205,9 @@ private:
     Result
     findOrLoadInode(InodeNo no, SmartInodePtr& target);
 
+    Result
+    rewritePagesInAreas(Inode& inode, BitList<areasNo>& areas, uint32_t& rewrittenPages);
+
     // newElem should be already inserted in Tree
     Result
     insertInodeInDir(const char* name, Inode& contDir, Inode& newElem);
@@ -177,6 +215,31 @@ private:
     removeInodeFromDir(Inode& contDir, InodeNo elem);
     Result
     createFile(SmartInodePtr& outFile, const char* fullPath, Permission mask);
+
+    /**
+     * Writes at the objects filepointer and advances it
+     */
+    Result
+    writeObjData(Obj& obj, const uint8_t* data, FileSize bytes, FileSize* bytesWritten);
+    /**
+     * Collects writes into the write buffer of the object.
+     * Whole pages at a page boundary are written directly.
+     */
+    Result
+    bufferObjData(Obj& obj, const uint8_t* data, FileSize bytes, FileSize* bytesWritten);
+    Result
+    flushWriteBuffer(Obj& obj);
+    /**
+     * @param inode if nullptr, the buffers of all open objects are flushed
+     * @param except the buffer of this object is kept
+     */
+    Result
+    flushWriteBuffers(const Inode* inode, const Obj* except = nullptr);
+    /**
+     * Writes data that was staged in MRAM but not written to flash before the last power loss
+     */
+    Result
+    replayStagedWrites();
 };
 
 }  // namespace paffs
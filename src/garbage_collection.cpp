@@ -22,36 +22,123 @@
 
 namespace paffs
 {
+const char* gcPolicyNames[] = {"GREEDY", "COSTBENEFIT", "WEARAWARE", "YOUSHOULDNOTBESEEINGTHIS"};
 
 void
-GarbageCollection::countDirtyAndUsedPages(PageOffs& dirty, PageOffs &used, SummaryEntry* summary)
+GarbageCollection::setPolicy(GcPolicy policy)
 {
-    dirty = 0;
-    used = 0;
-    for (PageOffs i = 0; i < dataPagesPerArea; i++)
+    if (policy >= GcPolicy::num_policies)
     {
-        if (summary[i] == SummaryEntry::dirty)
+        PAFFS_DBG(PAFFS_TRACE_BUG, "Tried setting invalid GC policy %" PRIu8,
+                  static_cast<uint8_t>(policy));
+        return;
+    }
+    PAFFS_DBG_S(PAFFS_TRACE_GC, "Using GC policy %s", gcPolicyNames[static_cast<uint8_t>(policy)]);
+    mPolicy = policy;
+}
+
+GcPolicy
+GarbageCollection::getPolicy()
+{
+    return mPolicy;
+}
+
+const GcStatistics&
+GarbageCollection::getStatistics()
+{
+    return mStatistics;
+}
+
+void
+GarbageCollection::resetStatistics()
+{
+    mStatistics = {};
+}
+
+uint64_t
+GarbageCollection::getScore(AreaPos area, uint32_t maxErasecount)
+{
+    PageOffs dirtyPages = dev->sumCache.getDirtyPages(area);
+    PageOffs usedPages = dev->sumCache.getUsedPages(area);
+    switch (mPolicy)
+    {
+    case GcPolicy::costBenefit:
+        // age * free / (1 + used), with used and free as fractions of the area.
+        // Scaled by dataPagesPerArea to stay in integers.
+        return (static_cast<uint64_t>(dev->sumCache.getAge(area)) + 1)
+               * (dataPagesPerArea - usedPages) * dataPagesPerArea
+               / (dataPagesPerArea + usedPages);
+    case GcPolicy::wearAware:
+        return static_cast<uint64_t>(dirtyPages)
+               * (maxErasecount - dev->superblock.getErasecount(area) + 1);
+    default:
+        return dirtyPages;
+    }
+}
+
+AreaPos
+GarbageCollection::findBestScoredArea(AreaType target, bool& srcAreaContainsValidData)
+{
+    AreaPos favouriteArea = 0;
+    uint64_t favScore = 0;
+    uint32_t favErases = ~0;
+    uint32_t maxErasecount = 0;
+    srcAreaContainsValidData = false;
+
+    for (AreaPos i = 0; i < areasNo; i++)
+    {
+        if (dev->superblock.getErasecount(i) > maxErasecount)
+        {
+            maxErasecount = dev->superblock.getErasecount(i);
+        }
+    }
+
+    for (AreaPos i = 0; i < areasNo; i++)
+    {
+        if (dev->superblock.getStatus(i) == AreaStatus::active
+            || (dev->superblock.getType(i) != AreaType::data
+                && dev->superblock.getType(i) != AreaType::index))
+        {
+            continue;
+        }
+        PageOffs usedPages = dev->sumCache.getUsedPages(i);
+        if (usedPages == dataPagesPerArea)
+        {
+            continue;  // Nothing to gain
+        }
+        if (dev->superblock.getType(i) != target && usedPages != 0)
         {
-            dirty++;
+            continue;  // We cant change types if area is not completely empty
         }
-        if (summary[i] == SummaryEntry::used)
+        uint64_t score = getScore(i, maxErasecount);
+        if (score > favScore || (score == favScore && score != 0
+                                 && dev->superblock.getErasecount(i) < favErases))
         {
-            used++;
+            favouriteArea = i;
+            favScore = score;
+            favErases = dev->superblock.getErasecount(i);
+            srcAreaContainsValidData = usedPages > 0;
         }
     }
+    PAFFS_DBG_S(PAFFS_TRACE_GC_DETAIL,
+                "%s GC chose area %" PTYPE_AREAPOS " with score %" PRIu64,
+                gcPolicyNames[static_cast<uint8_t>(mPolicy)], favouriteArea, favScore);
+    return favouriteArea;
 }
 
 // Special Case 'unset': Find any Type and also extremely favour Areas with committed AS
 AreaPos
-GarbageCollection::findNextBestArea(AreaType target,
-                                    SummaryEntry* summaryOut,
-                                    bool& srcAreaContainsValidData)
+GarbageCollection::findNextBestArea(AreaType target, bool& srcAreaContainsValidData)
 {
+    if (target != AreaType::unset && mPolicy != GcPolicy::greedy)
+    {
+        return findBestScoredArea(target, srcAreaContainsValidData);
+    }
+
     AreaPos favourite_area = 0;
     PageOffs favDirtyPages = 0;
     uint32_t favErases = ~0;
     srcAreaContainsValidData = false;
-    SummaryEntry curr[dataPagesPerArea];
 
     // Look for the most dirty area.
     // This ignores unset (free) areas, if we look for data or index areas.
@@ -61,16 +148,8 @@ GarbageCollection::findNextBestArea(AreaType target,
             && (dev->superblock.getType(i) == AreaType::data
                 || dev->superblock.getType(i) == AreaType::index))
         {
-            Result r = dev->sumCache.getSummaryStatus(i, curr);
-            if (r != Result::ok)
-            {
-                PAFFS_DBG(PAFFS_TRACE_BUG,
-                          "Could not load Summary of Area %" PRId16 " for Garbage collection!",
-                          i);
-                return 0;
-            }
-            PageOffs dirtyPages, usedPages;
-            countDirtyAndUsedPages(dirtyPages, usedPages, curr);
+            PageOffs dirtyPages = dev->sumCache.getDirtyPages(i);
+            PageOffs usedPages = dev->sumCache.getUsedPages(i);
             if (target != AreaType::unset)
             {
                 // normal case
@@ -80,7 +159,6 @@ GarbageCollection::findNextBestArea(AreaType target,
                 {
                     // We can't find a block with more dirty pages in it
                     srcAreaContainsValidData = false;
-                    memcpy(summaryOut, curr, dataPagesPerArea);
                     return i;
                 }
 
@@ -99,7 +177,6 @@ GarbageCollection::findNextBestArea(AreaType target,
                     favDirtyPages = dirtyPages;
                     srcAreaContainsValidData = usedPages > 0;
                     favErases = dev->superblock.getErasecount(i);
-                    memcpy(summaryOut, curr, dataPagesPerArea);
                 }
             }
             else
@@ -113,7 +190,6 @@ GarbageCollection::findNextBestArea(AreaType target,
                     favourite_area = i;
                     favDirtyPages = dirtyPages;
                     srcAreaContainsValidData = usedPages > 0;
-                    memcpy(summaryOut, curr, dataPagesPerArea);
                 }
             }
         }
@@ -122,12 +198,40 @@ GarbageCollection::findNextBestArea(AreaType target,
     return favourite_area;
 }
 
+Result
+GarbageCollection::moveValidPage(AreaPos srcArea, AreaPos dstArea, PageOffs page)
+{
+    Result ret = Result::ok;
+    mStatistics.movedPages++;
+    PageAbs src = dev->superblock.getPos(srcArea) * totalPagesPerArea + page;
+    PageAbs dst = dev->superblock.getPos(dstArea) * totalPagesPerArea + page;
+    uint8_t* buf = dev->driver.getPageBuffer();
+    Result r = dev->driver.readPage(src, buf, totalBytesPerPage);
+    // Any Biterror gets corrected here by being moved
+    if (r != Result::ok && r != Result::biterrorCorrected)
+    {
+         PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not read page Area %" PTYPE_AREAPOS "(%" PTYPE_AREAPOS "):%" PTYPE_PAGEOFFS,
+         srcArea, dev->superblock.getPos(srcArea), page);
+         ret = r;
+    }
+    r = dev->driver.writePage(dst, buf, totalBytesPerPage);
+    if (r != Result::ok)
+    {
+        PAFFS_DBG(PAFFS_TRACE_ERROR,
+                    "Could not write page n° %lu!",
+                    static_cast<long unsigned>(dst));
+        ret = Result::badFlash > ret ? Result::badFlash : ret;
+    }
+    return ret;
+}
+
 /**
  * @param summary is input and output (with changed SummaryEntry::dirty to SummaryEntry::free)
  */
 Result
 GarbageCollection::moveValidDataToNewArea(AreaPos srcArea, AreaPos dstArea,
-                                          bool& validDataLeft, SummaryEntry* summary)
+                                          bool& validDataLeft,
+                                          TwoBitList<dataPagesPerArea>& summary)
 {
     PAFFS_DBG_S(PAFFS_TRACE_GC_DETAIL,
                 "Moving valid data from Area %" PRIu16 " (on %" PRIu16 ") to Area %" PRIu16 " (on %" PRIu16 ")",
@@ -142,33 +246,16 @@ GarbageCollection::moveValidDataToNewArea(AreaPos srcArea, AreaPos dstArea,
     Result ret = Result::ok;
     for (PageOffs page = 0; page < dataPagesPerArea; page++)
     {
-        if (summary[page] == SummaryEntry::used)
+        if (AreaSummaryElem::getStatus(page, summary) == SummaryEntry::used)
         {
-            PageAbs src = dev->superblock.getPos(srcArea) * totalPagesPerArea + page;
-            PageAbs dst = dev->superblock.getPos(dstArea) * totalPagesPerArea + page;
             validDataLeft = true;
-            uint8_t* buf = dev->driver.getPageBuffer();
-            Result r = dev->driver.readPage(src, buf, totalBytesPerPage);
-            // Any Biterror gets corrected here by being moved
-            if (r != Result::ok && r != Result::biterrorCorrected)
-            {
-                 PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not read page Area %" PTYPE_AREAPOS "(%" PTYPE_AREAPOS "):%" PTYPE_PAGEOFFS,
-                 srcArea, dev->superblock.getPos(srcArea), page);
-                 ret = r > ret ? r : ret;
-            }
-            r = dev->driver.writePage(dst, buf, totalBytesPerPage);
-            if (r != Result::ok)
-            {
-                PAFFS_DBG(PAFFS_TRACE_ERROR,
-                            "Could not write page n° %lu!",
-                            static_cast<long unsigned>(dst));
-                ret = Result::badFlash > ret ? Result::badFlash : ret;
-            }
+            Result r = moveValidPage(srcArea, dstArea, page);
+            ret = r > ret ? r : ret;
             FAILPOINT;
         }
         else
         {
-            summary[page] = SummaryEntry::free;
+            AreaSummaryElem::setStatus(page, SummaryEntry::free, summary);
         }
     }
     return ret;
@@ -182,12 +269,18 @@ GarbageCollection::moveValidDataToNewArea(AreaPos srcArea, AreaPos dstArea,
 Result
 GarbageCollection::collectGarbage(AreaType targetType)
 {
-    SummaryEntry summary[dataPagesPerArea];
-    memset(summary, 0xFF, dataPagesPerArea);
+    TwoBitList<dataPagesPerArea> summary;
     bool srcAreaContainsValidData = false;
     AreaPos deletionTarget = 0;
     Result r;
 
+    // The garbage buffer may still be filled by an incremental collection
+    r = finishPendingCollection();
+    if (r != Result::ok)
+    {
+        return r;
+    }
+
     if (traceMask & PAFFS_TRACE_VERIFY_AS)
     {
         unsigned char buf[totalBytesPerPage];
@@ -210,13 +303,26 @@ GarbageCollection::collectGarbage(AreaType targetType)
         }
     }
 
-    deletionTarget = findNextBestArea(targetType, summary, srcAreaContainsValidData);
+    deletionTarget = findNextBestArea(targetType, srcAreaContainsValidData);
     if (deletionTarget == 0 ||
             (srcAreaContainsValidData && dev->superblock.getActiveArea(AreaType::garbageBuffer) == 0))
     {
         return Result::noSpace;
     }
 
+    if (srcAreaContainsValidData)
+    {
+        // Only the summary of the chosen victim is loaded
+        r = dev->sumCache.getSummaryStatus(deletionTarget, summary);
+        if (r != Result::ok && r != Result::biterrorCorrected)
+        {
+            PAFFS_DBG(PAFFS_TRACE_BUG,
+                      "Could not load Summary of Area %" PRId16 " for Garbage collection!",
+                      deletionTarget);
+            return r;
+        }
+    }
+
     // TODO: more Safety switches like comparison of lastDeletion targetType
 
     if (srcAreaContainsValidData)
@@ -252,6 +358,32 @@ GarbageCollection::collectGarbage(AreaType targetType)
     }
     else
     {
+        // The victim is queued for erasure if an already erased area can take its place
+        AreaPos erased = 0;
+        if (targetType != AreaType::unset)
+        {
+            erased = dev->areaMgmt.findErasedArea();
+        }
+        if (erased != 0)
+        {
+            FAILPOINT;
+            r = dev->areaMgmt.queueErase(deletionTarget);
+            if (r != Result::ok)
+            {
+                return r;
+            }
+            FAILPOINT;
+            dev->areaMgmt.initAreaAs(erased, targetType);
+            FAILPOINT;
+            dev->journal.addEvent(journalEntry::Checkpoint(getTopic()));
+            mStatistics.collections++;
+            mStatistics.queuedErases++;
+            PAFFS_DBG_S(PAFFS_TRACE_GC_DETAIL,
+                        "Garbagecollection queued area %" PTYPE_AREAPOS " and gave erased area %"
+                        PTYPE_AREAPOS " pos %" PTYPE_AREAPOS ".",
+                        deletionTarget, erased, dev->superblock.getPos(erased));
+            return Result::ok;
+        }
         FAILPOINT;
          r = dev->areaMgmt.deleteArea(deletionTarget);
          if(r != Result::ok)
@@ -269,14 +401,10 @@ GarbageCollection::collectGarbage(AreaType targetType)
 
     if(srcAreaContainsValidData)
     {
-        FAILPOINT;
-        r = dev->areaMgmt.deleteAreaContents(deletionTarget,
-                         dev->superblock.getActiveArea(AreaType::garbageBuffer));
-        if(r != Result::ok)
+        r = clearGarbageBuffer(deletionTarget);
+        if (r != Result::ok)
         {
-            PAFFS_DBG_S(PAFFS_TRACE_ALWAYS, "Could not delete Area! Giving up Garbage buffer to continue...");
-            //TODO Find new place for GC in desperate mode
-            dev->superblock.setActiveArea(AreaType::garbageBuffer, 0);
+            return r;
         }
         // Copy the updated (no SummaryEntry::dirty pages) summary to the deletion_target
         // (it will be the fresh area!)
@@ -297,6 +425,7 @@ GarbageCollection::collectGarbage(AreaType targetType)
     }
     FAILPOINT;
     dev->journal.addEvent(journalEntry::Checkpoint(getTopic()));
+    mStatistics.collections++;
 
     PAFFS_DBG_S(PAFFS_TRACE_GC_DETAIL,
                 "Garbagecollection erased pos %" PRIu16 " and gave area %" PRIu16 " pos %" PRIu16 ".",
@@ -307,6 +436,505 @@ GarbageCollection::collectGarbage(AreaType targetType)
     return Result::ok;
 }
 
+Result
+GarbageCollection::collectGarbage(PageOffs budget, bool& idle)
+{
+    idle = false;
+    if (mIncrementalVictim == 0)
+    {
+        Result r = startIncrementalCollection(idle);
+        if (r != Result::ok || mIncrementalVictim == 0)
+        {
+            return r;
+        }
+    }
+    return continuePendingCollection(budget);
+}
+
+Result
+GarbageCollection::continuePendingCollection(PageOffs budget)
+{
+    Result ret = Result::ok;
+    while (mIncrementalNextPage < dataPagesPerArea && budget > 0)
+    {
+        if (mIncrementalValidPages.getBit(mIncrementalNextPage))
+        {
+            Result r = moveValidPage(mIncrementalVictim,
+                                     dev->superblock.getActiveArea(AreaType::garbageBuffer),
+                                     mIncrementalNextPage);
+            ret = r > ret ? r : ret;
+            budget--;
+            FAILPOINT;
+        }
+        mIncrementalNextPage++;
+    }
+    if (ret != Result::ok)
+    {
+        PAFFS_DBG_S(PAFFS_TRACE_ERROR,
+                    "Could not copy valid pages from area %" PTYPE_AREAPOS
+                    " to %" PTYPE_AREAPOS "!",
+                    mIncrementalVictim,
+                    dev->superblock.getActiveArea(AreaType::garbageBuffer));
+        return ret;
+    }
+    if (mIncrementalNextPage == dataPagesPerArea)
+    {
+        return finishPendingCollection();
+    }
+    return Result::ok;
+}
+
+Result
+GarbageCollection::startIncrementalCollection(bool& idle)
+{
+    if (getFreePages() >= static_cast<uint32_t>(mReserve) * dataPagesPerArea)
+    {
+        idle = true;
+        return Result::ok;
+    }
+
+    bool srcAreaContainsValidData = false;
+    AreaPos victim = findNextBestArea(AreaType::data, srcAreaContainsValidData);
+    if (victim == 0 || dev->sumCache.getDirtyPages(victim) == 0)
+    {
+        victim = findNextBestArea(AreaType::index, srcAreaContainsValidData);
+    }
+    if (victim == 0 || dev->sumCache.getDirtyPages(victim) == 0)
+    {
+        // Only valid data left, nothing to gain
+        idle = true;
+        return Result::ok;
+    }
+
+    if (!srcAreaContainsValidData)
+    {
+        FAILPOINT;
+        Result r = dev->areaMgmt.queueErase(victim);
+        if (r == Result::ok)
+        {
+            mStatistics.collections++;
+        }
+        return r;
+    }
+    if (dev->superblock.getActiveArea(AreaType::garbageBuffer) == 0)
+    {
+        return Result::noSpace;
+    }
+    return beginPendingCollection(victim);
+}
+
+Result
+GarbageCollection::beginPendingCollection(AreaPos victim)
+{
+    TwoBitList<dataPagesPerArea> summary;
+    Result r = dev->sumCache.getSummaryStatus(victim, summary);
+    if (r != Result::ok && r != Result::biterrorCorrected)
+    {
+        PAFFS_DBG(PAFFS_TRACE_BUG,
+                  "Could not load Summary of Area %" PTYPE_AREAPOS " for Garbage collection!",
+                  victim);
+        return r;
+    }
+    mIncrementalValidPages.clear();
+    for (PageOffs page = 0; page < dataPagesPerArea; page++)
+    {
+        if (AreaSummaryElem::getStatus(page, summary) == SummaryEntry::used)
+        {
+            mIncrementalValidPages.setBit(page);
+        }
+    }
+
+    PAFFS_DBG_S(PAFFS_TRACE_GC_DETAIL,
+                "Incremental GC starts moving valid data from Area %" PTYPE_AREAPOS
+                " (on %" PTYPE_AREAPOS ")",
+                victim,
+                dev->superblock.getPos(victim));
+    FAILPOINT;
+    // If we crash before the collection is finished, replay deletes the garbage buffer
+    dev->journal.addEvent(journalEntry::garbageCollection::MoveValidData(victim));
+    FAILPOINT;
+    mIncrementalVictim = victim;
+    mIncrementalNextPage = 0;
+    return Result::ok;
+}
+
+Result
+GarbageCollection::finishPendingCollection()
+{
+    if (mIncrementalVictim == 0)
+    {
+        return Result::ok;
+    }
+    AreaPos victim = mIncrementalVictim;
+    AreaPos gcBuffer = dev->superblock.getActiveArea(AreaType::garbageBuffer);
+    Result r;
+    for (; mIncrementalNextPage < dataPagesPerArea; mIncrementalNextPage++)
+    {
+        if (mIncrementalValidPages.getBit(mIncrementalNextPage))
+        {
+            r = moveValidPage(victim, gcBuffer, mIncrementalNextPage);
+            if (r != Result::ok)
+            {
+                PAFFS_DBG_S(PAFFS_TRACE_ERROR,
+                            "Could not copy valid pages from area %" PTYPE_AREAPOS
+                            " to %" PTYPE_AREAPOS "!",
+                            victim, gcBuffer);
+                return r;
+            }
+            FAILPOINT;
+        }
+    }
+
+    // Copied pages may have been overwritten since, so they keep their current state.
+    // All others are free in the new area.
+    TwoBitList<dataPagesPerArea> summary;
+    r = dev->sumCache.getSummaryStatus(victim, summary);
+    if (r != Result::ok && r != Result::biterrorCorrected)
+    {
+        PAFFS_DBG(PAFFS_TRACE_BUG,
+                  "Could not load Summary of Area %" PTYPE_AREAPOS " for Garbage collection!",
+                  victim);
+        return r;
+    }
+    for (PageOffs page = 0; page < dataPagesPerArea; page++)
+    {
+        if (!mIncrementalValidPages.getBit(page))
+        {
+            AreaSummaryElem::setStatus(page, SummaryEntry::free, summary);
+        }
+    }
+    mIncrementalVictim = 0;
+
+    FAILPOINT;
+    dev->superblock.swapAreaPosition(victim, gcBuffer);
+    r = clearGarbageBuffer(victim);
+    if (r != Result::ok)
+    {
+        return r;
+    }
+    r = dev->sumCache.setSummaryStatus(victim, summary);
+    if (r != Result::ok)
+    {
+        PAFFS_DBG_S(PAFFS_TRACE_ERROR,
+                    "Could not remove dirty entries in AS of area %" PTYPE_AREAPOS,
+                    victim);
+        return r;
+    }
+    FAILPOINT;
+    dev->journal.addEvent(journalEntry::Checkpoint(getTopic()));
+    mStatistics.collections++;
+
+    PAFFS_DBG_S(PAFFS_TRACE_GC_DETAIL,
+                "Incremental GC compacted area %" PTYPE_AREAPOS " to pos %" PTYPE_AREAPOS ".",
+                victim,
+                dev->superblock.getPos(victim));
+    return Result::ok;
+}
+
+Result
+GarbageCollection::clearGarbageBuffer(AreaPos victim)
+{
+    AreaPos gcBuffer = dev->superblock.getActiveArea(AreaType::garbageBuffer);
+    FAILPOINT;
+    Result r = dev->areaMgmt.replaceByErasedArea(gcBuffer);
+    if (r == Result::ok)
+    {
+        // The summary of the victim belonged to the old contents, same as in deleteAreaContents
+        FAILPOINT;
+        dev->sumCache.resetASWritten(victim);
+        FAILPOINT;
+        dev->sumCache.deleteSummary(victim);
+        mStatistics.queuedErases++;
+        return Result::ok;
+    }
+    if (r != Result::notFound)
+    {
+        return r;
+    }
+    FAILPOINT;
+    r = dev->areaMgmt.deleteAreaContents(victim, gcBuffer);
+    if (r != Result::ok)
+    {
+        PAFFS_DBG_S(PAFFS_TRACE_ALWAYS,
+                    "Could not delete Area! Giving up Garbage buffer to continue...");
+        //TODO Find new place for GC in desperate mode
+        dev->superblock.setActiveArea(AreaType::garbageBuffer, 0);
+    }
+    return Result::ok;
+}
+
+AreaPos
+GarbageCollection::getPendingVictim()
+{
+    return mIncrementalVictim;
+}
+
+void
+GarbageCollection::pageInvalidated(AreaPos area, PageOffs page)
+{
+    if (area == mIncrementalVictim && page >= mIncrementalNextPage)
+    {
+        mIncrementalValidPages.resetBit(page);
+    }
+}
+
+Result
+GarbageCollection::levelWear(PageOffs budget, bool& idle)
+{
+    idle = false;
+    if (mIncrementalVictim == 0)
+    {
+        Result r = startWearLeveling(idle);
+        if (r != Result::ok || mIncrementalVictim == 0)
+        {
+            return r;
+        }
+    }
+    return continuePendingCollection(budget);
+}
+
+Result
+GarbageCollection::startWearLeveling(bool& idle)
+{
+    AreaPos gcBuffer = dev->superblock.getActiveArea(AreaType::garbageBuffer);
+    if (gcBuffer == 0)
+    {
+        return Result::noSpace;
+    }
+
+    AreaPos coldArea = 0;
+    AreaPos wornArea = 0;
+    uint32_t coldErases = ~0;
+    uint32_t wornErases = 0;
+    uint32_t maxErases = 0;
+    for (AreaPos area = 0; area < areasNo; area++)
+    {
+        if (dev->superblock.getType(area) == AreaType::superblock
+            || dev->superblock.getType(area) == AreaType::retired)
+        {
+            continue;
+        }
+        uint32_t erases = dev->superblock.getErasecount(area);
+        maxErases = erases > maxErases ? erases : maxErases;
+        if (dev->superblock.getStatus(area) == AreaStatus::closed
+            && (dev->superblock.getType(area) == AreaType::data
+                || dev->superblock.getType(area) == AreaType::index)
+            && dev->sumCache.getUsedPages(area) > 0 && erases < coldErases)
+        {
+            coldArea = area;
+            coldErases = erases;
+        }
+        if ((area == gcBuffer || dev->superblock.getStatus(area) == AreaStatus::empty)
+            && erases > wornErases)
+        {
+            wornArea = area;
+            wornErases = erases;
+        }
+    }
+    if (coldArea == 0 || maxErases - coldErases <= mWearThreshold || wornErases <= coldErases)
+    {
+        idle = true;
+        return Result::ok;
+    }
+
+    PAFFS_DBG_S(PAFFS_TRACE_GC,
+                "Wear leveling moves cold area %" PTYPE_AREAPOS " (%" PRIu32 " erases) "
+                "to pos %" PTYPE_AREAPOS " (%" PRIu32 " erases)",
+                coldArea, coldErases, dev->superblock.getPos(wornArea), wornErases);
+    if (wornArea != gcBuffer)
+    {
+        // Both are erased, so the garbage buffer can take over the worn position
+        FAILPOINT;
+        dev->superblock.swapAreaPosition(gcBuffer, wornArea);
+    }
+    mStatistics.leveledAreas++;
+    return beginPendingCollection(coldArea);
+}
+
+void
+GarbageCollection::setWearThreshold(uint32_t eraseSpread)
+{
+    mWearThreshold = eraseSpread;
+}
+
+uint32_t
+GarbageCollection::getWearThreshold()
+{
+    return mWearThreshold;
+}
+
+void
+GarbageCollection::getEraseHistogram(EraseHistogram& histogram)
+{
+    uint32_t maxErases = 0;
+    histogram.minErases = ~0;
+    memset(histogram.areas, 0, sizeof(histogram.areas));
+    for (AreaPos area = 0; area < areasNo; area++)
+    {
+        if (dev->superblock.getType(area) == AreaType::superblock
+            || dev->superblock.getType(area) == AreaType::retired)
+        {
+            continue;
+        }
+        uint32_t erases = dev->superblock.getErasecount(area);
+        histogram.minErases = erases < histogram.minErases ? erases : histogram.minErases;
+        maxErases = erases > maxErases ? erases : maxErases;
+    }
+    if (histogram.minErases > maxErases)
+    {
+        histogram.minErases = 0;
+    }
+    histogram.bucketWidth = (maxErases - histogram.minErases) / eraseHistogramBuckets + 1;
+    for (AreaPos area = 0; area < areasNo; area++)
+    {
+        if (dev->superblock.getType(area) == AreaType::superblock
+            || dev->superblock.getType(area) == AreaType::retired)
+        {
+            continue;
+        }
+        histogram.areas[(dev->superblock.getErasecount(area) - histogram.minErases)
+                        / histogram.bucketWidth]++;
+    }
+}
+
+void
+GarbageCollection::printEraseHistogram()
+{
+    EraseHistogram histogram;
+    getEraseHistogram(histogram);
+    printf("Erase count histogram:\n");
+    for (uint8_t bucket = 0; bucket < eraseHistogramBuckets; bucket++)
+    {
+        uint32_t from = histogram.minErases + bucket * histogram.bucketWidth;
+        printf("\t%6" PRIu32 " - %6" PRIu32 ": %4" PTYPE_AREAPOS " areas\n",
+               from, from + histogram.bucketWidth - 1, histogram.areas[bucket]);
+    }
+}
+
+AreaPos
+GarbageCollection::findCompactionVictims(AreaPos* victims, AreaPos maxVictims)
+{
+    AreaPos count = 0;
+    uint32_t usedPagesSum = 0;
+    // Sparsest areas first, as long as all their valid pages fit into one area
+    while (count < maxVictims)
+    {
+        AreaPos favouriteArea = 0;
+        PageOffs favUsedPages = dataPagesPerArea / 2 + 1;
+        for (AreaPos area = 0; area < areasNo; area++)
+        {
+            if (dev->superblock.getStatus(area) != AreaStatus::closed
+                || dev->superblock.getType(area) != AreaType::data
+                || area == mIncrementalVictim)
+            {
+                continue;
+            }
+            PageOffs usedPages = dev->sumCache.getUsedPages(area);
+            if (usedPages == 0 || usedPages >= favUsedPages
+                || usedPages + dev->sumCache.getDirtyPages(area) != dataPagesPerArea)
+            {
+                // Empty areas are deleted by the GC, areas with free pages get reused
+                continue;
+            }
+            bool alreadyChosen = false;
+            for (AreaPos i = 0; i < count; i++)
+            {
+                alreadyChosen |= victims[i] == area;
+            }
+            if (!alreadyChosen)
+            {
+                favouriteArea = area;
+                favUsedPages = usedPages;
+            }
+        }
+        if (favouriteArea == 0 || usedPagesSum + favUsedPages > dataPagesPerArea)
+        {
+            break;
+        }
+        victims[count++] = favouriteArea;
+        usedPagesSum += favUsedPages;
+    }
+    PAFFS_DBG_S(PAFFS_TRACE_GC_DETAIL,
+                "Compaction chose %" PTYPE_AREAPOS " areas with %" PRIu32 " valid pages",
+                count, usedPagesSum);
+    return count;
+}
+
+void
+GarbageCollection::recordCompaction(uint32_t rewrittenPages, AreaPos freedAreas)
+{
+    mStatistics.compactedPages += rewrittenPages;
+    mStatistics.compactedAreas += freedAreas;
+}
+
+void
+GarbageCollection::setReserve(AreaPos freeAreas)
+{
+    mReserve = freeAreas;
+}
+
+AreaPos
+GarbageCollection::getReserve()
+{
+    return mReserve;
+}
+
+PageOffs
+GarbageCollection::getReusablePages(AreaPos area)
+{
+    if (dev->superblock.getStatus(area) != AreaStatus::closed
+        || area == mIncrementalVictim
+        || (dev->superblock.getType(area) != AreaType::data
+            && dev->superblock.getType(area) != AreaType::index)
+        || dev->sumCache.wasAreaSummaryWritten(area))
+    {
+        return 0;
+    }
+    return dataPagesPerArea - dev->sumCache.getDirtyPages(area)
+           - dev->sumCache.getUsedPages(area);
+}
+
+AreaPos
+GarbageCollection::findCompactedArea(AreaType target)
+{
+    AreaPos favouriteArea = 0;
+    PageOffs favFreePages = 0;
+    for (AreaPos area = 0; area < areasNo; area++)
+    {
+        if (dev->superblock.getType(area) != target)
+        {
+            continue;
+        }
+        PageOffs freePages = getReusablePages(area);
+        if (freePages > favFreePages)
+        {
+            favouriteArea = area;
+            favFreePages = freePages;
+        }
+    }
+    return favouriteArea;
+}
+
+uint32_t
+GarbageCollection::getFreePages()
+{
+    uint32_t freePages = 0;
+    for (AreaPos area = 0; area < areasNo; area++)
+    {
+        if (dev->superblock.getStatus(area) == AreaStatus::empty
+            || dev->superblock.getStatus(area) == AreaStatus::erasePending)
+        {
+            if (dev->superblock.getType(area) != AreaType::retired)
+            {
+                freePages += dataPagesPerArea;
+            }
+            continue;
+        }
+        freePages += getReusablePages(area);
+    }
+    return freePages;
+}
+
 JournalEntry::Topic
 GarbageCollection::getTopic()
 {
@@ -317,6 +945,7 @@ GarbageCollection::resetState()
 {
     state = Statemachine::ok;
     journalTargetArea = 0;
+    mIncrementalVictim = 0;
 }
 bool
 GarbageCollection::isInterestedIn(const journalEntry::Max& entry)
@@ -340,6 +969,11 @@ GarbageCollection::processEntry(const journalEntry::Max& entry, JournalEntryPosi
         }
         break;
     case JournalEntry::Topic::areaMgmt:
+        //Other areas may be erased while an incremental collection is pending
+        if(entry.areaMgmt.area != journalTargetArea)
+        {
+            break;
+        }
         switch(entry.areaMgmt.operation)
         {
         case journalEntry::AreaMgmt::Operation::deleteArea:
@@ -352,7 +986,8 @@ GarbageCollection::processEntry(const journalEntry::Max& entry, JournalEntryPosi
         }
         break;
     case JournalEntry::Topic::superblock:
-        if(entry.superblock.type != journalEntry::Superblock::Type::areaMap)
+        if(entry.superblock.type != journalEntry::Superblock::Type::areaMap ||
+           entry.superblock_.areaMap.offs != journalTargetArea)
         {
             break;
         }
@@ -367,7 +1002,8 @@ GarbageCollection::processEntry(const journalEntry::Max& entry, JournalEntryPosi
         }
         break;
     case JournalEntry::Topic::summaryCache:
-        if(entry.summaryCache.subtype == journalEntry::SummaryCache::Subtype::setStatusBlock)
+        if(entry.summaryCache.subtype == journalEntry::SummaryCache::Subtype::setStatusBlock &&
+           entry.summaryCache.area == journalTargetArea)
         {
             state = Statemachine::setNewSummary;
         }
@@ -381,7 +1017,7 @@ GarbageCollection::processEntry(const journalEntry::Max& entry, JournalEntryPosi
 void
 GarbageCollection::signalEndOfLog()
 {
-    SummaryEntry summary[dataPagesPerArea];
+    TwoBitList<dataPagesPerArea> summary;
     switch(state)
     {
     case Statemachine::ok:
@@ -400,15 +1036,9 @@ GarbageCollection::signalEndOfLog()
     case Statemachine::deletedOldArea:
         dev->sumCache.scanAreaForSummaryStatus(journalTargetArea, summary);
         {
-            bool containsData = false;
-            for(PageOffs i = 0; i < dataPagesPerArea; i++)
-            {
-                if(summary[i] != SummaryEntry::free)
-                {
-                    containsData = true;
-                    break;
-                }
-            }
+            PageOffs freePages =
+                    summary.countValue(static_cast<uint8_t>(SummaryEntry::free));
+            bool containsData = freePages != dataPagesPerArea;
             if(containsData)
             {
                 dev->sumCache.setSummaryStatus(journalTargetArea, summary);
@@ -16,12 +16,40 @@
 
 #include "commonTypes.hpp"
 #include "journal.hpp"
+#include "bitlist.hpp"
 
 namespace paffs
 {
+struct GcStatistics
+{
+    uint32_t collections;     // successful runs of collectGarbage
+    uint32_t movedPages;      // valid pages copied to another area
+    uint32_t compactedAreas;  // areas freed by compaction
+    uint32_t compactedPages;  // valid pages rewritten by compaction
+    uint32_t leveledAreas;    // cold areas moved to worn positions by wear leveling
+    uint32_t queuedErases;    // victims queued for erasure instead of erased by a collection
+};
+
+static constexpr uint8_t eraseHistogramBuckets = 8;
+struct EraseHistogram
+{
+    uint32_t minErases;
+    uint32_t bucketWidth;
+    AreaPos areas[eraseHistogramBuckets];  // Number of areas per erase count range
+};
+
 class GarbageCollection : public JournalTopic
 {
     Device* dev;
+    GcPolicy mPolicy = GcPolicy::greedy;
+    GcStatistics mStatistics = {};
+    AreaPos mReserve = defaultGcReserve;
+    uint32_t mWearThreshold = defaultWearThreshold;
+
+    // State of a collection spread over several collectGarbage(budget) calls
+    AreaPos mIncrementalVictim = 0;
+    PageOffs mIncrementalNextPage = 0;
+    BitList<dataPagesPerArea> mIncrementalValidPages;
 
     enum class Statemachine
     {
@@ -46,11 +74,93 @@ public:
     Result
     collectGarbage(AreaType target);
 
+    /**
+     * Incremental collection for idle tasks. Copies at most \p budget valid pages
+     * and returns, the victim is finished by one of the next calls.
+     * New collections are only started while less than the reserved number
+     * of areas is free. \p idle is set if there was nothing to do.
+     */
+    Result
+    collectGarbage(PageOffs budget, bool& idle);
+    /**
+     * Copies the rest of a pending incremental collection, if any.
+     * The compacted area stays closed and is reused by findWritableArea.
+     */
+    Result
+    finishPendingCollection();
+    AreaPos
+    getPendingVictim();
+    /**
+     * Called by the SummaryCache if a page got dirty.
+     * Pages of a pending victim that were not copied yet do not need to be moved anymore.
+     */
+    void
+    pageInvalidated(AreaPos area, PageOffs page);
+
+    /**
+     * Compaction mode: Chooses full, but sparsely used data areas whose valid pages
+     * fit into a single area together. These pages are rewritten by the caller into
+     * the active area, so the victims can be deleted without using the garbage buffer.
+     * Returns the number of victims written to \p victims.
+     */
+    AreaPos
+    findCompactionVictims(AreaPos* victims, AreaPos maxVictims);
+    void
+    recordCompaction(uint32_t rewrittenPages, AreaPos freedAreas);
+
+    /**
+     * Static wear leveling for idle tasks. If the erase count spread exceeds the
+     * threshold, the coldest area holding data is moved to the most worn free position.
+     * The garbage buffer first takes over the worn position, then the cold area is
+     * collected into it like an incremental collection, at most \p budget pages per call.
+     * \p idle is set if the spread is within the threshold.
+     */
+    Result
+    levelWear(PageOffs budget, bool& idle);
+    void
+    setWearThreshold(uint32_t eraseSpread);
+    uint32_t
+    getWearThreshold();
+    /**
+     * Erase counts of all usable areas, in eraseHistogramBuckets ranges
+     */
+    void
+    getEraseHistogram(EraseHistogram& histogram);
+    void
+    printEraseHistogram();
+
+    void
+    setReserve(AreaPos freeAreas);
+    AreaPos
+    getReserve();
+    /**
+     * Pages of empty or queued areas plus free pages of closed, compacted areas
+     */
+    uint32_t
+    getFreePages();
+    /**
+     * Closed area of type \p target with the most free pages left by a collection.
+     * Returns 0 if there is none.
+     */
+    AreaPos
+    findCompactedArea(AreaType target);
+
+    void
+    setPolicy(GcPolicy policy);
+    GcPolicy
+    getPolicy();
+
+    const GcStatistics&
+    getStatistics();
+    void
+    resetStatistics();
+
     /**
      *	Moves all valid Pages to new Area.
      */
     Result
-    moveValidDataToNewArea(AreaPos srcArea, AreaPos dstArea, bool& validDataLeft, SummaryEntry* summary);
+    moveValidDataToNewArea(AreaPos srcArea, AreaPos dstArea, bool& validDataLeft,
+                           TwoBitList<dataPagesPerArea>& summary);
 
     JournalEntry::Topic
     getTopic() override;
@@ -64,9 +174,35 @@ public:
     signalEndOfLog() override;
 
 private:
-    void
-    countDirtyAndUsedPages(PageOffs& dirty, PageOffs &used, SummaryEntry* summary);
+    /**
+     * Decides on the page counters of the SummaryCache, so no AS has to be loaded.
+     */
     AreaPos
-    findNextBestArea(AreaType target, SummaryEntry* summaryOut, bool& srcAreaContainsValidData);
+    findNextBestArea(AreaType target, bool& srcAreaContainsValidData);
+    /**
+     * Victim selection of the non-greedy policies. Higher scores are collected first.
+     */
+    AreaPos
+    findBestScoredArea(AreaType target, bool& srcAreaContainsValidData);
+    uint64_t
+    getScore(AreaPos area, uint32_t maxErasecount);
+    Result
+    moveValidPage(AreaPos srcArea, AreaPos dstArea, PageOffs page);
+    Result
+    startIncrementalCollection(bool& idle);
+    Result
+    startWearLeveling(bool& idle);
+    Result
+    beginPendingCollection(AreaPos victim);
+    Result
+    continuePendingCollection(PageOffs budget);
+    /**
+     * Gets rid of the old contents of \p victim that were swapped into the garbage buffer.
+     * They are queued for erasure if an erased area can become the new garbage buffer.
+     */
+    Result
+    clearGarbageBuffer(AreaPos victim);
+    PageOffs
+    getReusablePages(AreaPos area);
 };
 }
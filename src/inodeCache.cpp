@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2017, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Authors:
+ * - 2017, Pascal Pieper (DLR RY-AVS)
+ */
+// ----------------------------------------------------------------------------
+
+#include "inodeCache.hpp"
+#include "paffs_trace.hpp"
+#include <inttypes.h>
+#include <string.h>
+
+namespace paffs
+{
+InodeCache::InodeCache()
+{
+    clear();
+    resetStatistics();
+}
+
+Result
+InodeCache::get(InodeNo no, Inode& outInode)
+{
+    uint16_t pos = findPos(no);
+    if (pos == inodeCacheSize)
+    {
+        mStats.misses++;
+        return Result::notFound;
+    }
+    mStats.hits++;
+    mLastUse[pos] = ++mClock;
+    outInode = mInodes[pos];
+    return Result::ok;
+}
+
+void
+InodeCache::put(const Inode& inode)
+{
+    uint16_t pos = findPos(inode.no);
+    if (pos == inodeCacheSize)
+    {
+        pos = mUsed.findFirstFree();
+    }
+    if (pos >= inodeCacheSize)
+    {
+        pos = 0;
+        for (uint16_t i = 1; i < inodeCacheSize; i++)
+        {
+            if (mLastUse[i] < mLastUse[pos])
+            {
+                pos = i;
+            }
+        }
+        PAFFS_DBG_S(PAFFS_TRACE_TREE,
+                    "Evicting cached Inode %" PTYPE_INODENO " for %" PTYPE_INODENO,
+                    mInodes[pos].no,
+                    inode.no);
+        mStats.evictions++;
+    }
+    mInodes[pos] = inode;
+    mLastUse[pos] = ++mClock;
+    mUsed.setBit(pos);
+}
+
+void
+InodeCache::invalidate(InodeNo no)
+{
+    uint16_t pos = findPos(no);
+    if (pos != inodeCacheSize)
+    {
+        mUsed.resetBit(pos);
+    }
+}
+
+void
+InodeCache::clear()
+{
+    mUsed.clear();
+    memset(mLastUse, 0, sizeof(mLastUse));
+    mClock = 0;
+}
+
+const InodeCacheStatistics&
+InodeCache::getStatistics()
+{
+    return mStats;
+}
+
+void
+InodeCache::resetStatistics()
+{
+    memset(&mStats, 0, sizeof(InodeCacheStatistics));
+}
+
+uint16_t
+InodeCache::findPos(InodeNo no)
+{
+    for (uint16_t i = 0; i < inodeCacheSize; i++)
+    {
+        if (mUsed.getBit(i) && mInodes[i].no == no)
+        {
+            return i;
+        }
+    }
+    return inodeCacheSize;
+}
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2017, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Authors:
+ * - 2017, Pascal Pieper (DLR RY-AVS)
+ */
+// ----------------------------------------------------------------------------
+
+#pragma once
+#include "bitlist.hpp"
+#include "commonTypes.hpp"
+
+namespace paffs
+{
+struct InodeCacheStatistics
+{
+    uint32_t hits;       // lookups answered without walking the tree
+    uint32_t misses;     // lookups that had to walk the tree
+    uint32_t evictions;  // least recently used inodes dropped for a new one
+};
+
+/**
+ * Copies of recently used inodes in front of the Btree.
+ * Only the Btree fills and invalidates it, so every insert, update and remove
+ * (including the ones replayed from the journal) keeps it coherent.
+ */
+class InodeCache
+{
+    Inode mInodes[inodeCacheSize];
+    // Value of mClock at the last use of each slot, smallest is evicted first
+    uint32_t mLastUse[inodeCacheSize];
+    BitList<inodeCacheSize> mUsed;
+    uint32_t mClock;
+
+    InodeCacheStatistics mStats;
+
+public:
+    InodeCache();
+
+    /**
+     * @return notFound if the inode is not cached, outInode is untouched then
+     */
+    Result
+    get(InodeNo no, Inode& outInode);
+
+    /**
+     * Inserts or refreshes the copy of the inode, may evict the least recently used one
+     */
+    void
+    put(const Inode& inode);
+
+    void
+    invalidate(InodeNo no);
+
+    void
+    clear();
+
+    const InodeCacheStatistics&
+    getStatistics();
+
+    void
+    resetStatistics();
+
+private:
+    /**
+     * @return inodeCacheSize if not found
+     */
+    uint16_t
+    findPos(InodeNo no);
+};
+}
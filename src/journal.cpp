@@ -86,7 +86,7 @@ Journal::addEvent(const JournalEntry& entry)
 }
 
 Result
-Journal::clear()
+Journal::clear(const JournalEntry* first)
 {
     disabled = false;
     for(JournalTopic* topic : topics)
@@ -100,7 +100,7 @@ Journal::clear()
     {
         return Result::ok;
     }
-    return persistence.clear();
+    return persistence.clear(first);
 }
 
 Result
@@ -492,6 +492,10 @@ Journal::printMeaning(const JournalEntry& entry, bool withNewline)
             fprintf(stderr, "Delete all");
             found = true;
             break;
+        case journalEntry::AreaMgmt::Operation::queueErase:
+            fprintf(stderr, "Queue erase");
+            found = true;
+            break;
         }
         break;
     case JournalEntry::Topic::garbage:
@@ -570,15 +574,22 @@ Journal::printMeaning(const JournalEntry& entry, bool withNewline)
             found = true;
             break;
             }
+        case journalEntry::PAC::Operation::commit:
+            fprintf(stderr, "commit lists of %" PTYPE_INODENO,
+                   static_cast<const journalEntry::pac::Commit*>(&entry)->inodeNo);
+            found = true;
+            break;
         }
         break;
     case JournalEntry::Topic::dataIO:
         switch(static_cast<const journalEntry::DataIO*>(&entry)->operation)
         {
         case journalEntry::DataIO::Operation::newInodeSize:
-            fprintf(stderr, "Change Size of Inode %" PTYPE_INODENO " to %" PTYPE_FILSIZE,
+            fprintf(stderr, "Change Size of Inode %" PTYPE_INODENO " to %" PTYPE_FILSIZE "%s",
                    static_cast<const journalEntry::dataIO::NewInodeSize*>(&entry)->inodeNo,
-                   static_cast<const journalEntry::dataIO::NewInodeSize*>(&entry)->filesize);
+                   static_cast<const journalEntry::dataIO::NewInodeSize*>(&entry)->filesize,
+                   static_cast<const journalEntry::dataIO::NewInodeSize*>(&entry)->lastSegment ?
+                           "" : " (segment)");
             found = true;
             break;
         }
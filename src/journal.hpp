@@ -79,8 +79,11 @@ public:
      */
     Result
     addEvent(const JournalEntry& entry);
+    /**
+     * \param[in] first if not null, is kept as the first entry of the cleared log
+     */
     Result
-    clear();
+    clear(const JournalEntry* first = nullptr);
     Result
     processBuffer();
     void
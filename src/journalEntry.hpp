@@ -231,6 +231,7 @@ namespace journalEntry
             retireArea,
             deleteAreaContents,
             deleteArea,
+            queueErase,
         };
         AreaPos area;
         Operation operation;
@@ -271,6 +272,11 @@ namespace journalEntry
             inline
             DeleteArea(AreaPos target) : AreaMgmt(target, Operation::deleteArea){};
         };
+        struct QueueErase : public AreaMgmt
+        {
+            inline
+            QueueErase(AreaPos target) : AreaMgmt(target, Operation::queueErase){};
+        };
 
         union Max
         {
@@ -281,6 +287,7 @@ namespace journalEntry
             RetireArea retireArea;
             DeleteAreaContents deleteAreaContents;
             DeleteArea deleteArea;
+            QueueErase queueErase;
             inline
             Max()
             {
@@ -437,6 +444,7 @@ namespace journalEntry
     enum class Operation : uint8_t
     {
         setAddress,
+        commit,
     };
     Operation operation;
 
@@ -458,8 +466,17 @@ namespace journalEntry
             inodeNo(_inodeno), page(_page), addr(_addr){};
         };
 
+        //Lists of this inode are committed while lists of other inodes are still dirty
+        struct Commit : public PAC
+        {
+            InodeNo inodeNo;
+            inline
+            Commit(InodeNo _inodeno) : PAC(Operation::commit), inodeNo(_inodeno){};
+        };
+
         union Max {
             SetAddress setAddress;
+            Commit commit;
         };
     }
 
@@ -480,9 +497,12 @@ namespace journalEntry
         {
             InodeNo inodeNo;
             FileSize filesize;
+            //False for all but the last segment of a write larger than maxPagesPerWrite
+            bool lastSegment;
             inline
-            NewInodeSize(InodeNo _inodeNo, FileSize _filesize) : DataIO(Operation::newInodeSize),
-                         inodeNo(_inodeNo), filesize(_filesize){};
+            NewInodeSize(InodeNo _inodeNo, FileSize _filesize, bool _lastSegment = true) :
+                         DataIO(Operation::newInodeSize), inodeNo(_inodeNo),
+                         filesize(_filesize), lastSegment(_lastSegment){};
         };
 
         union Max
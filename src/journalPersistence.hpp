@@ -130,8 +130,12 @@ public:
     virtual bool
     isLowMem() = 0;
 
+    /**
+     * \param[in] first if not null, is the only entry left in the log.
+     * A power loss can not separate it from the clearing.
+     */
     virtual Result
-    clear() = 0;
+    clear(const JournalEntry* first = nullptr) = 0;
 
     virtual Result
     readNextElem(journalEntry::Max& entry) = 0;
@@ -155,7 +159,7 @@ public:
     bool
     isLowMem() override;
     Result
-    clear() override;
+    clear(const JournalEntry* first = nullptr) override;
     Result
     readNextElem(journalEntry::Max& entry) override;
 };
@@ -192,7 +196,7 @@ public:
     bool
     isLowMem() override;
     Result
-    clear() override;
+    clear(const JournalEntry* first = nullptr) override;
     Result
     readNextElem(journalEntry::Max& entry) override;
 
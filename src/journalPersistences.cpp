@@ -79,6 +79,8 @@ JournalPersistence::getSizeFromJE(const JournalEntry& entry)
             return sizeof(journalEntry::areaMgmt::DeleteAreaContents);
         case journalEntry::AreaMgmt::Operation::deleteArea:
             return sizeof(journalEntry::areaMgmt::DeleteArea);
+        case journalEntry::AreaMgmt::Operation::queueErase:
+            return sizeof(journalEntry::areaMgmt::QueueErase);
         }
         break;
     case JournalEntry::Topic::garbage:
@@ -119,6 +121,8 @@ JournalPersistence::getSizeFromJE(const JournalEntry& entry)
         {
         case journalEntry::PAC::Operation::setAddress:
             return sizeof(journalEntry::pac::SetAddress);
+        case journalEntry::PAC::Operation::commit:
+            return sizeof(journalEntry::pac::Commit);
         }
         break;
     case JournalEntry::Topic::dataIO:
@@ -173,7 +177,7 @@ MramPersistence::tell()
 Result
 MramPersistence::appendEntry(const JournalEntry& entry)
 {
-    if (curr + sizeof(journalEntry::Max) > mramSize)
+    if (curr + sizeof(journalEntry::Max) > mramJournalSize)
     {
         return Result::noSpace;
     }
@@ -199,14 +203,25 @@ MramPersistence::isLowMem()
     {
         return false;
     }
-    return mramSize - curr < reservedLogsize;
+    return mramJournalSize - curr < reservedLogsize;
 }
 
 Result
-MramPersistence::clear()
+MramPersistence::clear(const JournalEntry* first)
 {
     curr = sizeof(PageAbs);
-    device->driver.writeMRAM(0, &curr, sizeof(PageAbs));
+    if (first == nullptr)
+    {
+        device->driver.writeMRAM(0, &curr, sizeof(PageAbs));
+        return Result::ok;
+    }
+    //High water mark and first entry are written at once
+    uint8_t buf[sizeof(PageAbs) + sizeof(journalEntry::Max)];
+    uint16_t size = getSizeFromJE(*first);
+    curr += size;
+    memcpy(buf, &curr, sizeof(PageAbs));
+    memcpy(&buf[sizeof(PageAbs)], first, size);
+    device->driver.writeMRAM(0, buf, sizeof(PageAbs) + size);
     return Result::ok;
 }
 
@@ -340,7 +355,7 @@ FlashPersistence::isLowMem()
 }
 
 Result
-FlashPersistence::clear()
+FlashPersistence::clear(const JournalEntry*)
 {
     // TODO: Change Area with garbage collection, gc should notice usage upon mount and delete
     return Result::nimpl;
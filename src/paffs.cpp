@@ -30,7 +30,7 @@ const Param stdParam{
     dataBytesPerPage,
     dataPagesPerArea,
     totalPagesPerArea,
-    areaSummarySizePacked,
+    areaSummarySize,
     blocksPerArea,
     superChainElems,
     areasNo,
@@ -194,11 +194,6 @@ Paffs::printCacheSizes()
                 "Mram size: %" PRIu32 ". Reserved Bytes: %" PRIu16 "\n",
                 mramSize, reservedLogsize);
 
-    if(areaSummaryIsPacked)
-    {
-        PAFFS_DBG_S(PAFFS_TRACE_ALWAYS, "\nWARNING: Using packed AreaSummaries (slower)");
-    }
-
     PAFFS_DBG_S(PAFFS_TRACE_INFO, "--------------------------------\n");
 }
 
@@ -283,7 +278,7 @@ Paffs::format(const BadBlockList badBlockList[maxNumberOfDevices], bool complete
                 areasNo,
                 totalPagesPerArea,
                 dataPagesPerArea,
-                areaSummarySizePacked,
+                areaSummarySize,
                 superChainElems);
 
     PAFFS_DBG_S(PAFFS_TRACE_INFO, "--------------------\n");
@@ -493,6 +488,140 @@ Paffs::getNumberOfOpenInodes()
     return devices[0]->getNumberOfOpenInodes();
 }
 
+void
+Paffs::setGcPolicy(GcPolicy policy)
+{
+    for (uint8_t i = 0; i < maxNumberOfDevices; i++)
+    {
+        if (validDevices[i])
+        {
+            devices[i]->areaMgmt.gc.setPolicy(policy);
+        }
+    }
+}
+
+GcPolicy
+Paffs::getGcPolicy()
+{
+    return devices[0]->areaMgmt.gc.getPolicy();
+}
+
+void
+Paffs::setGcReserve(AreaPos freeAreas)
+{
+    for (uint8_t i = 0; i < maxNumberOfDevices; i++)
+    {
+        if (validDevices[i])
+        {
+            devices[i]->areaMgmt.gc.setReserve(freeAreas);
+        }
+    }
+}
+
+Result
+Paffs::collectGarbage(PageOffs budget, bool& idle)
+{
+    idle = true;
+    for (uint8_t i = 0; i < maxNumberOfDevices; i++)
+    {
+        if (validDevices[i])
+        {
+            bool deviceIdle;
+            Result r = devices[i]->collectGarbage(budget, deviceIdle);
+            if (r != Result::ok)
+            {
+                return r;
+            }
+            idle &= deviceIdle;
+        }
+    }
+    return Result::ok;
+}
+
+Result
+Paffs::compactGarbage(bool& idle)
+{
+    idle = true;
+    for (uint8_t i = 0; i < maxNumberOfDevices; i++)
+    {
+        if (validDevices[i])
+        {
+            bool deviceIdle;
+            Result r = devices[i]->compactGarbage(deviceIdle);
+            if (r != Result::ok)
+            {
+                return r;
+            }
+            idle &= deviceIdle;
+        }
+    }
+    return Result::ok;
+}
+
+void
+Paffs::setWearThreshold(uint32_t eraseSpread)
+{
+    for (uint8_t i = 0; i < maxNumberOfDevices; i++)
+    {
+        if (validDevices[i])
+        {
+            devices[i]->areaMgmt.gc.setWearThreshold(eraseSpread);
+        }
+    }
+}
+
+Result
+Paffs::levelWear(PageOffs budget, bool& idle)
+{
+    idle = true;
+    for (uint8_t i = 0; i < maxNumberOfDevices; i++)
+    {
+        if (validDevices[i])
+        {
+            bool deviceIdle;
+            Result r = devices[i]->levelWear(budget, deviceIdle);
+            if (r != Result::ok)
+            {
+                return r;
+            }
+            idle &= deviceIdle;
+        }
+    }
+    return Result::ok;
+}
+
+void
+Paffs::setEraseWatermark(AreaPos erasedAreas)
+{
+    for (uint8_t i = 0; i < maxNumberOfDevices; i++)
+    {
+        if (validDevices[i])
+        {
+            devices[i]->areaMgmt.setEraseWatermark(erasedAreas);
+        }
+    }
+}
+
+Result
+Paffs::eraseQueuedAreas(AreaPos maxAreas, bool& idle)
+{
+    idle = true;
+    for (uint8_t i = 0; i < maxNumberOfDevices; i++)
+    {
+        if (validDevices[i])
+        {
+            bool deviceIdle;
+            Result r = devices[i]->eraseQueuedAreas(maxAreas, deviceIdle);
+            if (r != Result::ok)
+            {
+                return r;
+            }
+            idle &= deviceIdle;
+        }
+    }
+    return Result::ok;
+}
+
 // ONLY FOR DEBUG
 Device*
 Paffs::getDevice(uint16_t number)
@@ -101,6 +101,52 @@ public:
     uint8_t
     getNumberOfOpenInodes();
 
+    /**
+     * Selects the victim selection of the garbage collection for all devices.
+     * May be changed at any time, even while mounted.
+     */
+    void
+    setGcPolicy(GcPolicy policy);
+    GcPolicy
+    getGcPolicy();
+    /**
+     * Number of free areas the incremental garbage collection keeps in reserve.
+     */
+    void
+    setGcReserve(AreaPos freeAreas);
+    /**
+     * Incremental garbage collection, meant to be called by an idle task.
+     * Moves at most \p budget pages per device and returns.
+     * \p idle is set if no device had anything left to collect.
+     */
+    Result
+    collectGarbage(PageOffs budget, bool& idle);
+    /**
+     * Compacting garbage collection, meant to be called by an idle task.
+     * Merges the valid pages of sparsely used areas into the active area,
+     * so they can be freed without copying page by page.
+     */
+    Result
+    compactGarbage(bool& idle);
+    /**
+     * Static wear leveling, meant to be called by an idle task.
+     * Moves cold areas to worn positions if the erase counts of a device
+     * spread more than \p eraseSpread, copying at most \p budget pages per call.
+     */
+    void
+    setWearThreshold(uint32_t eraseSpread);
+    Result
+    levelWear(PageOffs budget, bool& idle);
+    /**
+     * Areas freed by the idle tasks are only queued for erasure, as long as at least
+     * \p erasedAreas erased areas are left. The erases are done by eraseQueuedAreas,
+     * meant to be called by an idle task, at most \p maxAreas per device and call.
+     */
+    void
+    setEraseWatermark(AreaPos erasedAreas);
+    Result
+    eraseQueuedAreas(AreaPos maxAreas, bool& idle);
+
     // ONLY FOR DEBUG
     Device*
     getDevice(uint16_t number);
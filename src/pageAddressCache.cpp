@@ -56,58 +56,75 @@ PageAddressCache::PageAddressCache(Device& mdev) :
         device(mdev), statemachine(device.journal, device.sumCache)
 {
     clear();
+    resetStatistics();
 };
 
 void
 PageAddressCache::clear()
 {
-    for (AddrListCacheElem& elem : tripl)
+    for (AddrListCacheSet& set : mSets)
     {
-        elem.active = false;
+        dropLists(set);
     }
-    for (AddrListCacheElem& elem : doubl)
-    {
-        elem.active = false;
-    }
-    singl.active = false;
+    mSet = &mSets[0];
+    tripl = mSet->tripl;
+    doubl = mSet->doubl;
+    singl = &mSet->singl;
 
     mInodePtr = nullptr;
-    isInodeDirty = false;
 
     processedForeignSuccessElement = false;
 }
 
+void
+PageAddressCache::dropLists(AddrListCacheSet& set)
+{
+    for (AddrListCacheElem& elem : set.tripl)
+    {
+        elem.active = false;
+        elem.dirty = false;
+    }
+    for (AddrListCacheElem& elem : set.doubl)
+    {
+        elem.active = false;
+        elem.dirty = false;
+    }
+    set.singl.active = false;
+    set.singl.dirty = false;
+    set.reference.reset();
+    set.inode = nullptr;
+    set.used = false;
+    set.inodeDirty = false;
+}
+
 Result
 PageAddressCache::setTargetInode(Inode& node)
 {
     //to force-load Inode into Tree for journal
     Inode dummy;
-    device.tree.getInode(node.no, dummy);
+    device.tree.getInodeFromTree(node.no, dummy);
 
-    if (&node == mInodePtr)
+    if (&node == mInodePtr && node.no == mSet->no)
     {
         return Result::ok;
     }
     PAFFS_DBG_S(PAFFS_TRACE_PACACHE, "Set new target inode %" PTYPE_INODENO, node.no);
-    if (isDirty())
+    Result r;
+    if (mInodePtr != nullptr && mSet->inodeDirty && !isInodeHeld(*mSet))
     {
-        PAFFS_DBG_S(PAFFS_TRACE_PACACHE, "Target Inode differs, committing old Inode");
-        Result r = commit();
+        PAFFS_DBG_S(PAFFS_TRACE_PACACHE, "Old Inode is not pooled, committing it");
+        r = commitSet(*mSet);
         if (r != Result::ok)
         {
             PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not commit old Inode, aborting");
             return r;
         }
     }
-    for (AddrListCacheElem& elem : tripl)
-    {
-        elem.active = false;
-    }
-    for (AddrListCacheElem& elem : doubl)
+    r = activateSet(node);
+    if (r != Result::ok)
     {
-        elem.active = false;
+        return r;
     }
-    singl.active = false;
     mInodePtr = &node;
 
     //journal setInode is delayed until something is really changed
@@ -115,6 +132,96 @@ PageAddressCache::setTargetInode(Inode& node)
     return Result::ok;
 }
 
+AddrListCacheSet&
+PageAddressCache::findSet(InodeNo no)
+{
+    AddrListCacheSet* set = nullptr;
+    for (AddrListCacheSet& candidate : mSets)
+    {
+        if (candidate.used && candidate.no == no)
+        {
+            return candidate;
+        }
+        if (set == nullptr || !candidate.used
+            || (set->used && candidate.lastUse < set->lastUse))
+        {
+            set = &candidate;
+        }
+    }
+    return *set;
+}
+
+Result
+PageAddressCache::activateSet(Inode& node)
+{
+    AddrListCacheSet& set = findSet(node.no);
+    if (set.used && set.inodeDirty && (set.no != node.no || set.inode != &node))
+    {
+        PAFFS_DBG_S(PAFFS_TRACE_PACACHE, "Committing lists of Inode %" PTYPE_INODENO
+                    " to reuse their set", set.no);
+        Result r = commitSet(set);
+        if (r != Result::ok)
+        {
+            PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not commit lists of Inode %" PTYPE_INODENO, set.no);
+            return r;
+        }
+    }
+    if (set.used && set.no == node.no && set.indir == node.indir
+        && set.d_indir == node.d_indir && set.t_indir == node.t_indir)
+    {
+        PAFFS_DBG_S(PAFFS_TRACE_PACACHE, "Lists of Inode %" PTYPE_INODENO " still loaded", node.no);
+        mStats.hits++;
+    }
+    else
+    {
+        if (set.used && set.no != node.no)
+        {
+            mStats.evictions++;
+        }
+        mStats.misses++;
+        dropLists(set);
+        set.no = node.no;
+        set.used = true;
+    }
+    set.lastUse = ++mClock;
+    set.inode = &node;
+    mSet = &set;
+    tripl = set.tripl;
+    doubl = set.doubl;
+    singl = &set.singl;
+    rememberAnchors(set, node);
+    return Result::ok;
+}
+
+void
+PageAddressCache::rememberAnchors(AddrListCacheSet& set, Inode& node)
+{
+    set.indir = node.indir;
+    set.d_indir = node.d_indir;
+    set.t_indir = node.t_indir;
+}
+
+bool
+PageAddressCache::isInodeHeld(AddrListCacheSet& set)
+{
+    return set.inode == &set.journalInode || static_cast<Inode*>(set.reference) == set.inode;
+}
+
+void
+PageAddressCache::markInodeDirty()
+{
+    if (mSet->inodeDirty)
+    {
+        return;
+    }
+    mSet->inodeDirty = true;
+    if (mInodePtr != &mSet->journalInode)
+    {
+        //If the Inode is not pooled, the lists are committed when the target changes
+        device.referenceInode(*mInodePtr, mSet->reference);
+    }
+}
+
 InodeNo
 PageAddressCache::getTargetInode()
 {
@@ -149,16 +256,16 @@ PageAddressCache::getPage(PageNo page, Addr* addr)
     if (page < addrsPerPage)
     {
         PAFFS_DBG_S(PAFFS_TRACE_VERBOSE | PAFFS_TRACE_PACACHE, "Accessing first indirection at %" PRIu32, page);
-        if (!singl.active)
+        if (!singl->active)
         {
-            r = loadCacheElem(mInodePtr->indir, singl);
+            r = loadCacheElem(mInodePtr->indir, *singl);
             if (r != Result::ok)
             {
                 PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not read first indirection!");
                 return r;
             }
         }
-        *addr = singl.getAddr(page);
+        *addr = singl->getAddr(page);
         PAFFS_DBG_S(PAFFS_TRACE_PACACHE, "GetPage at %" PRIu32
                     " (first, %" PTYPE_AREAPOS ":%" PTYPE_PAGEOFFS ")",
                     page, extractLogicalArea(*addr), extractPageOffs(*addr));
@@ -244,7 +351,7 @@ PageAddressCache::setPage(PageNo page, Addr addr)
         device.journal.addEvent(journalEntry::pac::SetAddress(mInodePtr->no, page, addr));
         FAILPOINT;
         mInodePtr->direct[relPage] = addr;
-        isInodeDirty = true;
+        markInodeDirty();
         return Result::ok;
     }
     relPage -= directAddrCount;
@@ -263,22 +370,22 @@ PageAddressCache::setPage(PageNo page, Addr addr)
     if (relPage < addrsPerPage)
     {
         // First Indirection
-        if (!singl.active)
+        if (!singl->active)
         {
-            r = loadCacheElem(mInodePtr->indir, singl);
+            r = loadCacheElem(mInodePtr->indir, *singl);
             if (r != Result::ok)
             {
                 PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not read first indirection!");
                 return r;
             }
         }
-        if(singl.getAddr(relPage) == addr)
+        if(singl->getAddr(relPage) == addr)
         {
             return Result::ok;
         }
         device.journal.addEvent(journalEntry::pac::SetAddress(mInodePtr->no, page, addr));
-        singl.setAddr(relPage, addr);
-        isInodeDirty = true;
+        singl->setAddr(relPage, addr);
+        markInodeDirty();
         return Result::ok;
     }
     relPage -= addrsPerPage;
@@ -298,7 +405,7 @@ PageAddressCache::setPage(PageNo page, Addr addr)
         }
         device.journal.addEvent(journalEntry::pac::SetAddress(mInodePtr->no, page, addr));
         doubl[1].setAddr(addrPos, addr);
-        isInodeDirty = true;
+        markInodeDirty();
         return Result::ok;
     }
     relPage -= std::pow(addrsPerPage, 2);
@@ -317,7 +424,7 @@ PageAddressCache::setPage(PageNo page, Addr addr)
         }
         device.journal.addEvent(journalEntry::pac::SetAddress(mInodePtr->no, page, addr));
         tripl[2].setAddr(addrPos, addr);
-        isInodeDirty = true;
+        markInodeDirty();
         return Result::ok;
     }
 
@@ -344,57 +451,97 @@ PageAddressCache::commit()
         PAFFS_DBG(PAFFS_TRACE_BUG, "Tried to commit null inode");
         return Result::bug;
     }
+    return commitSet(*mSet);
+}
 
-    if(!isInodeDirty)
+Result
+PageAddressCache::commitAll()
+{
+    for (AddrListCacheSet& set : mSets)
+    {
+        if (!set.used || !set.inodeDirty)
+        {
+            continue;
+        }
+        Result r = commitSet(set);
+        if (r != Result::ok)
+        {
+            PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not commit lists of Inode %" PTYPE_INODENO, set.no);
+            return r;
+        }
+    }
+    return Result::ok;
+}
+
+Result
+PageAddressCache::commitSet(AddrListCacheSet& set)
+{
+    if(!set.inodeDirty)
     {
         return Result::ok;
     }
     FAILPOINT;
+    Inode& inode = *set.inode;
     Result r;
-    r = commitPath(mInodePtr->indir, &singl, 0);
+    r = commitPath(inode.indir, &set.singl, 0);
     if (r != Result::ok)
     {
         PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not commit first indirection!");
         return r;
     }
     FAILPOINT;
-    r = commitPath(mInodePtr->d_indir, doubl, 1);
+    r = commitPath(inode.d_indir, set.doubl, 1);
     if (r != Result::ok)
     {
         PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not commit second indirection!");
         return r;
     }
     FAILPOINT;
-    r = commitPath(mInodePtr->t_indir, tripl, 2);
+    r = commitPath(inode.t_indir, set.tripl, 2);
     if (r != Result::ok)
     {
         PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not commit third indirection!");
         return r;
     }
 
-    if (isDirty())
+    if (areListsDirty(set))
     {
         PAFFS_DBG(PAFFS_TRACE_ERROR, "Committed all indirections, but something still dirty!");
         return Result::bug;
     }
     FAILPOINT;
-    r = device.tree.updateExistingInode(*mInodePtr);
+    r = device.tree.updateExistingInode(inode);
 
     if(traceMask & PAFFS_TRACE_PACACHE && traceMask & PAFFS_TRACE_VERBOSE)
     {
-        printf("Resulting Addresslist of Inode %" PTYPE_INODENO "\n", mInodePtr->no);
+        printf("Resulting Addresslist of Inode %" PTYPE_INODENO "\n", inode.no);
         for(uint8_t i = 0; i < 13; i++)
         {
             //intentionally over size of 11, because we print indirects too
             printf("%" PRIu8 "\t%" PTYPE_AREAPOS ":%" PTYPE_PAGEOFFS "\n",
-                   i, extractLogicalArea(mInodePtr->direct[i]), extractPageOffs(mInodePtr->direct[i]));
+                   i, extractLogicalArea(inode.direct[i]), extractPageOffs(inode.direct[i]));
         }
     }
+    rememberAnchors(set, inode);
     FAILPOINT;
     statemachine.invalidateOldPages();
     FAILPOINT;
-    device.journal.addEvent(journalEntry::Checkpoint(getTopic()));
-    isInodeDirty = false;
+    set.inodeDirty = false;
+    bool othersDirty = false;
+    for (AddrListCacheSet& other : mSets)
+    {
+        othersDirty |= other.used && other.inodeDirty;
+    }
+    if (othersDirty)
+    {
+        //A checkpoint would drop the journalled addresses of the other inodes
+        device.journal.addEvent(journalEntry::pac::Commit(inode.no));
+    }
+    else
+    {
+        device.journal.addEvent(journalEntry::Checkpoint(getTopic()));
+    }
+    set.reference.reset();
     return r;
 }
 
@@ -434,22 +581,39 @@ PageAddressCache::processEntry(const journalEntry::Max& entry, JournalEntryPosit
             }
             return setPage(entry.pac_.setAddress.page, entry.pac_.setAddress.addr);
         }
+        case journalEntry::PAC::Operation::commit:
+            for (AddrListCacheSet& set : mSets)
+            {
+                if (!set.used || set.no != entry.pac_.commit.inodeNo)
+                {
+                    continue;
+                }
+                //The lists are in the tree, later changes start from there
+                if (&set == mSet)
+                {
+                    mInodePtr = nullptr;
+                }
+                dropLists(set);
+            }
+            return Result::ok;
         }
         return Result::bug;
     }
     else if(entry.base.topic == JournalEntry::Topic::pagestate &&
             entry.pagestate.target == getTopic())
     {   //statemachine operations
-        return statemachine.processEntry(entry);
+        Result r = statemachine.processEntry(entry);
+        if (statemachine.getState() == JournalState::ok)
+        {
+            //Lists of several inodes may be committed without a checkpoint in between
+            processedForeignSuccessElement = false;
+        }
+        return r;
     }
     else if(entry.base.topic == JournalEntry::Topic::tree)
     {
         if(entry.btree.op == journalEntry::BTree::Operation::update)
         {
-            if(mInodePtr == nullptr || mInodePtr != &mJournalInodeCopy)
-            {
-                return Result::bug;
-            }
             processedForeignSuccessElement = true;
             journalEntry::Max success;
             success.pagestate_.success = journalEntry::pagestate::Success(getTopic());
@@ -466,61 +630,126 @@ PageAddressCache::processEntry(const journalEntry::Max& entry, JournalEntryPosit
 
 void
 PageAddressCache::signalEndOfLog()
+{
+    finishReplay();
+    //DataIO changed Inodes during its own end of log
+    commitAll();
+    mInodePtr = nullptr;
+}
+
+Result
+PageAddressCache::finishReplay()
 {
     if(statemachine.signalEndOfLog() == JournalState::recover)
     {
         //TODO: We may want to find out which cache elements are clean to suppress double versions
     }
-    Result r;
-    if(mInodePtr != nullptr)
+    for (AddrListCacheSet& set : mSets)
     {
-        //This refreshes the Inode we will commit to Index.
-        //During replay, changes to the same node are only done to index, not the PAC version
-        //TODO: Link them somehow
-        Inode tmp;
-        r = device.tree.getInode(mInodePtr->no, tmp);
+        if (!set.used || !set.inodeDirty || set.inode != &set.journalInode)
+        {
+            continue;
+        }
+        Result r = refreshJournalInode(set);
         if(r != Result::ok)
-        {   //nonexisting Inode?
-            PAFFS_DBG(PAFFS_TRACE_BUG, "Could not find Inode %" PTYPE_INODENO
-                      " for PAC commit", mInodePtr->no);
-            return;
-        }
-        //This intentionally reads over the boundaries of direct array into the indirections
-        memcpy(&tmp.direct, &mJournalInodeCopy.direct, (11+3) * sizeof(Addr));
-        mJournalInodeCopy = tmp;
-        commit();
+        {
+            return r;
+        }
+        r = commitSet(set);
+        if (r != Result::ok)
+        {
+            return r;
+        }
+    }
+    if (mInodePtr == &mSet->journalInode)
+    {
         mInodePtr = nullptr;
     }
+    return Result::ok;
 }
 
 Result
 PageAddressCache::setJournallingInode(InodeNo no)
 {
-    Result r = device.tree.getInode(no, mJournalInodeCopy);
+    Result r;
+    AddrListCacheSet& set = findSet(no);
+    if (set.used && set.no == no && set.inode == &set.journalInode)
+    {
+        r = refreshJournalInode(set);
+    }
+    else
+    {
+        if (set.used && set.inodeDirty)
+        {
+            //Its Inode may be the one getting overwritten
+            r = commitSet(set);
+            if (r != Result::ok)
+            {
+                return r;
+            }
+        }
+        r = device.tree.getInode(no, set.journalInode);
+    }
     if(r != Result::ok)
     {
         return r;
     }
-    return setTargetInode(mJournalInodeCopy);
+    return setTargetInode(set.journalInode);
+}
+
+Result
+PageAddressCache::refreshJournalInode(AddrListCacheSet& set)
+{
+    //During replay, changes to the same node are only done to index, not the PAC version
+    //TODO: Link them somehow
+    Inode tmp;
+    Result r = device.tree.getInode(set.no, tmp);
+    if(r != Result::ok)
+    {   //nonexisting Inode?
+        PAFFS_DBG(PAFFS_TRACE_BUG, "Could not find Inode %" PTYPE_INODENO
+                  " for PAC commit", set.no);
+        return r;
+    }
+    //This intentionally reads over the boundaries of direct array into the indirections
+    memcpy(&tmp.direct, &set.journalInode.direct, (11+3) * sizeof(Addr));
+    set.journalInode = tmp;
+    return Result::ok;
 }
 
 bool
 PageAddressCache::isDirty()
 {
-    if (singl.dirty)
+    return areListsDirty(*mSet);
+}
+
+bool
+PageAddressCache::areListsDirty(AddrListCacheSet& set)
+{
+    if (set.singl.dirty)
     {
         return true;
     }
-    if (doubl[0].dirty || doubl[1].dirty)
+    if (set.doubl[0].dirty || set.doubl[1].dirty)
     {
         return true;
     }
-    if (tripl[0].dirty || tripl[1].dirty || tripl[2].dirty)
+    if (set.tripl[0].dirty || set.tripl[1].dirty || set.tripl[2].dirty)
     {
         return true;
     }
     return false;
 }
+const PageAddressCacheStatistics&
+PageAddressCache::getStatistics()
+{
+    return mStats;
+}
+
+void
+PageAddressCache::resetStatistics()
+{
+    memset(&mStats, 0, sizeof(PageAddressCacheStatistics));
+}
 
 uint16_t
 PageAddressCache::getCacheID(AddrListCacheElem* elem)
@@ -545,7 +774,7 @@ PageAddressCache::getCacheID(AddrListCacheElem* elem)
     {
         return 2;
     }
-    if (elem == &singl)
+    if (elem == singl)
     {
         return 1;
     }
@@ -680,13 +909,16 @@ PageAddressCache::commitPath(Addr& anchor, AddrListCacheElem* path, unsigned cha
     if (!validEntries)
     {
         PAFFS_DBG_S(PAFFS_TRACE_PACACHE, "Deleting CacheElem referenced by anchor");
-        // invalidate old page.
-        r = device.sumCache.setPageStatus(
-                extractLogicalArea(anchor), extractPageOffs(anchor), SummaryEntry::dirty);
-        if (r != Result::ok)
+        // invalidate old page. It may never have been written if a write was reverted.
+        if (anchor != 0)
         {
-            PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not commit invalidate old addresspage!");
-            return r;
+            r = device.sumCache.setPageStatus(
+                    extractLogicalArea(anchor), extractPageOffs(anchor), SummaryEntry::dirty);
+            if (r != Result::ok)
+            {
+                PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not commit invalidate old addresspage!");
+                return r;
+            }
         }
         anchor = 0;
     }
@@ -732,15 +964,19 @@ PageAddressCache::commitElem(AddrListCacheElem& parent, AddrListCacheElem& elem)
                     "Deleting CacheElem referenced by "
                     "parent:%" PRIu16,
                     elem.positionInParent);
-        // invalidate old page.
+        // invalidate old page. It may never have been written if a write was reverted.
         FAILPOINT;
-        r = device.sumCache.setPageStatus(extractLogicalArea(parent.cache[elem.positionInParent]),
-                                       extractPageOffs(parent.cache[elem.positionInParent]),
-                                       SummaryEntry::dirty);
-        if (r != Result::ok)
+        if (parent.cache[elem.positionInParent] != 0)
         {
-            PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not commit invalidate old addresspage!");
-            return r;
+            r = device.sumCache.setPageStatus(
+                    extractLogicalArea(parent.cache[elem.positionInParent]),
+                    extractPageOffs(parent.cache[elem.positionInParent]),
+                    SummaryEntry::dirty);
+            if (r != Result::ok)
+            {
+                PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not commit invalidate old addresspage!");
+                return r;
+            }
         }
         parent.cache[elem.positionInParent] = 0;
         elem.dirty = false;
@@ -883,6 +1119,7 @@ PageAddressCache::writeAddrList(Addr& source, Addr list[addrsPerPage])
         // TODO: Revert Changes to PageStatus
         return r;
     }
+    mStats.pagesWritten++;
 
     source = to;
 
@@ -38,18 +38,56 @@ struct AddrListCacheElem
     getAddr(PageNo pos);
 };
 
-class PageAddressCache : public JournalTopic
+/**
+ * The indirection lists of one inode. Lists of inodes other than the target stay dirty
+ * until their set is evicted or committed, the journal records them by inode number.
+ */
+struct AddrListCacheSet
 {
     //The three caches for each indirection layer
     AddrListCacheElem tripl[3];
     AddrListCacheElem doubl[2];  // name clash with double
     AddrListCacheElem singl;
+    InodeNo no;
+    //Anchors the lists belong to. As lists are written out of place, any change
+    //to them also changes an anchor.
+    Addr indir;
+    Addr d_indir;
+    Addr t_indir;
+    //Inode the lists are committed to
+    Inode* inode;
+    //Keeps a pooled Inode loaded while its lists are dirty
+    SmartInodePtr reference;
+    //Inode of the lists during replay
+    Inode journalInode;
+    uint32_t lastUse;
+    bool used;
+    //Addresses differ from the ones in the tree
+    bool inodeDirty;
+};
+
+struct PageAddressCacheStatistics
+{
+    uint32_t hits;       // target inode switches that found the lists of the inode loaded
+    uint32_t misses;     // target inode switches that had to start with empty lists
+    uint32_t evictions;  // lists of another inode that were dropped for this
+    uint32_t pagesWritten;  // address list pages programmed
+};
+
+class PageAddressCache : public JournalTopic
+{
+    AddrListCacheSet mSets[pageAddressCacheSets];
+    uint32_t mClock = 0;
+    //Lists of the target inode, pointing into one of mSets
+    AddrListCacheSet* mSet;
+    AddrListCacheElem* tripl;
+    AddrListCacheElem* doubl;
+    AddrListCacheElem* singl;
+    PageAddressCacheStatistics mStats;
     Device& device;
     Inode* mInodePtr;
-    bool isInodeDirty = false;
 
     PageStateMachine<maxPagesPerWrite, 0, JournalEntry::Topic::pac> statemachine;
-    Inode mJournalInodeCopy;
     bool processedForeignSuccessElement;
 
 public:
@@ -66,10 +104,22 @@ public:
     setPage(PageNo page, Addr addr);
     Result
     setValid();
+    /**
+     * Commits the lists of the target inode
+     */
     Result
     commit();
+    /**
+     * Commits the lists of every inode
+     */
+    Result
+    commitAll();
     bool
     isDirty();
+    const PageAddressCacheStatistics&
+    getStatistics();
+    void
+    resetStatistics();
 
     JournalEntry::Topic
     getTopic() override;
@@ -81,10 +131,46 @@ public:
     processEntry(const journalEntry::Max& entry, JournalEntryPosition position) override;
     void
     signalEndOfLog() override;
+    /**
+     * Commits the address lists replayed from the journal, so the Inodes in the tree
+     * reference all pages. DataIO needs this before it releases pages of a replayed write.
+     */
+    Result
+    finishReplay();
     Result
     setJournallingInode(InodeNo no);
 
 private:
+    /**
+     * @return the set holding the lists of the inode, or the least recently used set
+     */
+    AddrListCacheSet&
+    findSet(InodeNo no);
+    /**
+     * Selects the set of the inode. Dirty lists of an evicted inode are committed.
+     */
+    Result
+    activateSet(Inode& node);
+    void
+    dropLists(AddrListCacheSet& set);
+    void
+    rememberAnchors(AddrListCacheSet& set, Inode& node);
+    Result
+    commitSet(AddrListCacheSet& set);
+    bool
+    areListsDirty(AddrListCacheSet& set);
+    /**
+     * Lists may only stay dirty without being the target if their Inode can not vanish
+     */
+    bool
+    isInodeHeld(AddrListCacheSet& set);
+    void
+    markInodeDirty();
+    /**
+     * Takes everything but the addresses of a replayed Inode from the tree
+     */
+    Result
+    refreshJournalInode(AddrListCacheSet& set);
     uint16_t
     getCacheID(AddrListCacheElem* elem);
     void
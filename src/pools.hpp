@@ -65,6 +65,11 @@ struct ObjectPool
         return (&obj - objects >= 0 && static_cast<unsigned int>(&obj - objects) < size);
     }
     inline size_t
+    getIndex(T& obj)
+    {
+        return &obj - objects;
+    }
+    inline size_t
     getUsage()
     {
         uint8_t usedObjects = 0;
@@ -94,6 +99,44 @@ struct ObjectPool
     }
 };
 
+/**
+ * Pool of a feature that is configured to zero objects
+ */
+template <typename T>
+struct ObjectPool<T, 0>
+{
+    inline Result
+    getNewObject(T*&)
+    {
+        return Result::noSpace;
+    }
+    inline Result
+    freeObject(T&)
+    {
+        PAFFS_DBG(PAFFS_TRACE_BUG, "Tried freeing an Object of an empty pool!");
+        return Result::bug;
+    }
+    inline bool
+    isFromPool(T&)
+    {
+        return false;
+    }
+    inline size_t
+    getIndex(T&)
+    {
+        return 0;
+    }
+    inline size_t
+    getUsage()
+    {
+        return 0;
+    }
+    inline void
+    clear()
+    {
+    }
+};
+
 struct InodePoolBase
 {
     typedef std::pair<Inode*, uint8_t> InodeWithRefcount;
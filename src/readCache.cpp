@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2017, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Authors:
+ * - 2017, Pascal Pieper (DLR RY-AVS)
+ */
+// ----------------------------------------------------------------------------
+
+#include "readCache.hpp"
+#include <string.h>
+
+namespace paffs
+{
+ReadCache::ReadCache()
+{
+    clear();
+    resetStatistics();
+}
+
+const uint8_t*
+ReadCache::get(Addr addr, uint16_t bytes)
+{
+    uint16_t pos = findPos(addr);
+    if (pos == readCacheSize || mBytes[pos] < bytes)
+    {
+        mStats.misses++;
+        return nullptr;
+    }
+    mStats.hits++;
+    mLastUse[pos] = ++mClock;
+    return mPages[pos];
+}
+
+bool
+ReadCache::contains(Addr addr)
+{
+    return findPos(addr) != readCacheSize;
+}
+
+uint8_t*
+ReadCache::put(Addr addr, uint16_t bytes)
+{
+    uint16_t pos = findPos(addr);
+    if (pos == readCacheSize)
+    {
+        pos = mUsed.findFirstFree();
+    }
+    if (pos >= readCacheSize)
+    {
+        pos = 0;
+        for (uint16_t i = 1; i < readCacheSize; i++)
+        {
+            if (mLastUse[i] < mLastUse[pos])
+            {
+                pos = i;
+            }
+        }
+    }
+    mStats.readBytes += bytes;
+    mAddrs[pos] = addr;
+    mBytes[pos] = bytes;
+    mLastUse[pos] = ++mClock;
+    mUsed.setBit(pos);
+    return mPages[pos];
+}
+
+void
+ReadCache::invalidate(Addr addr)
+{
+    uint16_t pos = findPos(addr);
+    if (pos != readCacheSize)
+    {
+        mUsed.resetBit(pos);
+    }
+}
+
+void
+ReadCache::clear()
+{
+    mUsed.clear();
+    memset(mLastUse, 0, sizeof(mLastUse));
+    mClock = 0;
+}
+
+const ReadCacheStatistics&
+ReadCache::getStatistics()
+{
+    return mStats;
+}
+
+void
+ReadCache::resetStatistics()
+{
+    memset(&mStats, 0, sizeof(ReadCacheStatistics));
+}
+
+uint16_t
+ReadCache::findPos(Addr addr)
+{
+    for (uint16_t i = 0; i < readCacheSize; i++)
+    {
+        if (mUsed.getBit(i) && mAddrs[i] == addr)
+        {
+            return i;
+        }
+    }
+    return readCacheSize;
+}
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2017, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Authors:
+ * - 2017, Pascal Pieper (DLR RY-AVS)
+ */
+// ----------------------------------------------------------------------------
+
+#pragma once
+#include "bitlist.hpp"
+#include "commonTypes.hpp"
+
+namespace paffs
+{
+struct ReadCacheStatistics
+{
+    uint32_t hits;        // page reads answered from the cache
+    uint32_t misses;      // page reads that went to flash
+    uint32_t readBytes;   // bytes read from flash on misses
+};
+
+/**
+ * Copies of recently read data pages, keyed by their address.
+ * Only the beginning of a page may be cached, if no more of it was read.
+ * Pages are written out of place, so the content behind an address only changes
+ * if a new page is written there. DataIO invalidates an address before writing to it.
+ */
+class ReadCache
+{
+    uint8_t mPages[readCacheSize][dataBytesPerPage];
+    Addr mAddrs[readCacheSize];
+    // Number of bytes from the beginning of each page that are cached
+    uint16_t mBytes[readCacheSize];
+    // Value of mClock at the last use of each slot, smallest is evicted first
+    uint32_t mLastUse[readCacheSize];
+    BitList<readCacheSize> mUsed;
+    uint32_t mClock;
+
+    ReadCacheStatistics mStats;
+
+public:
+    ReadCache();
+
+    /**
+     * @return nullptr if less than the first \p bytes of the page are cached
+     */
+    const uint8_t*
+    get(Addr addr, uint16_t bytes);
+
+    /**
+     * @return true if at least the beginning of the page is cached
+     */
+    bool
+    contains(Addr addr);
+
+    /**
+     * Returns the buffer the first \p bytes of the page at addr have to be read into.
+     * May evict the least recently used page.
+     */
+    uint8_t*
+    put(Addr addr, uint16_t bytes);
+
+    void
+    invalidate(Addr addr);
+
+    void
+    clear();
+
+    const ReadCacheStatistics&
+    getStatistics();
+
+    void
+    resetStatistics();
+
+private:
+    /**
+     * @return readCacheSize if not found
+     */
+    uint16_t
+    findPos(Addr addr);
+};
+}
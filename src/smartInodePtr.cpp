@@ -24,6 +24,12 @@ SmartInodePtr::SmartInodePtr(const SmartInodePtr& other) : mInode(nullptr), mPoo
 }
 
 SmartInodePtr::~SmartInodePtr()
+{
+    reset();
+}
+
+void
+SmartInodePtr::reset()
 {
     if (mInode == nullptr)
     {
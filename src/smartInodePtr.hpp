@@ -30,6 +30,11 @@ public:
     ~SmartInodePtr();
     void
     setInode(Inode& inode, InodePoolBase& pool);
+    /**
+     * Drops the reference, the Inode may be freed from its pool afterwards
+     */
+    void
+    reset();
     Inode* operator->() const;
     operator Inode*() const;
     SmartInodePtr&
@@ -85,6 +85,42 @@ AreaSummaryElem::setStatus(PageOffs page, SummaryEntry value)
         mDirtyPages++;
     }
 }
+PageOffs
+AreaSummaryElem::countStatus(SummaryEntry value)
+{
+    if (!isUsed())
+    {
+        PAFFS_DBG(PAFFS_TRACE_BUG, "Tried to count Status of unused cache elem!");
+        return 0;
+    }
+    return mEntries.countValue(static_cast<uint8_t>(value));
+}
+void
+AreaSummaryElem::setSummary(const TwoBitList<dataPagesPerArea>& summary)
+{
+    if (!isUsed())
+    {
+        PAFFS_DBG(PAFFS_TRACE_BUG, "Tried to set Summary of unused cache elem!");
+        return;
+    }
+    if (mEntries != summary)
+    {
+        setDirty();
+        setLoadedFromSuperPage(false);
+    }
+    mEntries = summary;
+    mDirtyPages += summary.countValue(static_cast<uint8_t>(SummaryEntry::dirty));
+}
+PageOffs
+AreaSummaryElem::findFirstStatus(SummaryEntry value)
+{
+    if (!isUsed())
+    {
+        PAFFS_DBG(PAFFS_TRACE_BUG, "Tried to search Status of unused cache elem!");
+        return dataPagesPerArea;
+    }
+    return mEntries.findFirstValue(static_cast<uint8_t>(value));
+}
 void
 AreaSummaryElem::setStatus(PageOffs page, SummaryEntry value, TwoBitList<dataPagesPerArea>& list)
 {
@@ -232,8 +268,11 @@ SummaryCache::SummaryCache(Device* mdev) : dev(mdev)
                   "AreaSummaryCacheSize is less than 3!\n"
                   "\tThis is not recommended, as Errors can happen.");
     }
-    mTranslation.reserve(areaSummaryCacheSize);
+    memset(mTranslation, noCachePos, areasNo * sizeof(uint8_t));
     memset(&firstUncommittedElem, 0, areasNo * sizeof(JournalEntryPosition));
+    memset(mAreaDirtyPages, 0, areasNo * sizeof(PageOffs));
+    memset(mAreaUsedPages, 0, areasNo * sizeof(PageOffs));
+    memset(mAreaLastWrite, 0, areasNo * sizeof(uint32_t));
 }
 
 SummaryCache::~SummaryCache()
@@ -289,6 +328,49 @@ SummaryCache::printStatus()
     }
 }
 
+const SummaryCacheStatistics&
+SummaryCache::getStatistics()
+{
+    return mStatistics;
+}
+
+void
+SummaryCache::resetStatistics()
+{
+    mStatistics = {};
+}
+
+void
+SummaryCache::updatePageCounts(AreaPos area, SummaryEntry oldState, SummaryEntry newState)
+{
+    if (oldState == SummaryEntry::dirty)
+    {
+        mAreaDirtyPages[area]--;
+    }
+    else if (oldState == SummaryEntry::used)
+    {
+        mAreaUsedPages[area]--;
+    }
+    if (newState == SummaryEntry::dirty)
+    {
+        mAreaDirtyPages[area]++;
+    }
+    else if (newState == SummaryEntry::used)
+    {
+        mAreaUsedPages[area]++;
+        mAreaLastWrite[area] = static_cast<uint32_t>(dev->superblock.getOverallDeletions());
+    }
+    mPageCountsChanged = true;
+}
+
+void
+SummaryCache::setPageCounts(AreaPos area, const TwoBitList<dataPagesPerArea>& list)
+{
+    mAreaDirtyPages[area] = list.countValue(static_cast<uint8_t>(SummaryEntry::dirty));
+    mAreaUsedPages[area] = list.countValue(static_cast<uint8_t>(SummaryEntry::used));
+    mPageCountsChanged = true;
+}
+
 void
 SummaryCache::enableSummaryElem(uint16_t pos, AreaPos area)
 {
@@ -297,6 +379,7 @@ SummaryCache::enableSummaryElem(uint16_t pos, AreaPos area)
         PAFFS_DBG(PAFFS_TRACE_BUG, "Tried adding an existent Summary Elem!");
     }
     mTranslation[area] = pos;
+    mCachedAreas++;
     mSummaryCache[pos].setArea(area);
 }
 void
@@ -307,7 +390,8 @@ SummaryCache::removeSummaryElem(AreaPos area)
         return;
     }
     mSummaryCache[getSummaryElemPos(area)].clear();
-    mTranslation.erase(area);
+    mTranslation[area] = noCachePos;
+    mCachedAreas--;
 }
 
 uint16_t
@@ -322,7 +406,7 @@ SummaryCache::getSummaryElemPos(AreaPos area)
 bool
 SummaryCache::existsSummaryElem(AreaPos area)
 {
-    return mTranslation.find(area) != mTranslation.end();
+    return area < areasNo && mTranslation[area] != noCachePos;
 }
 
 Result
@@ -331,26 +415,30 @@ SummaryCache::commitAreaSummaryHard(int& clearedAreaCachePosition, bool desperat
     PageOffs favDirtyPages = 0;
     AreaPos favouriteArea = 0;
     uint16_t cachePos = 0;
-    for (std::pair<AreaPos, uint16_t> it : mTranslation)
+    for (cachePos = 0; cachePos < areaSummaryCacheSize; cachePos++)
     {
+        if (!mSummaryCache[cachePos].isUsed())
+        {
+            continue;
+        }
         // found a cached element
-        cachePos = it.second;
+        AreaPos area = mSummaryCache[cachePos].getArea();
         if ((mSummaryCache[cachePos].isDirty() || desperate)
             && mSummaryCache[cachePos].isAreaSummaryWritten()
-            && dev->superblock.getStatus(it.first) != AreaStatus::active
-            && (dev->superblock.getType(it.first) == AreaType::data
-                || dev->superblock.getType(it.first) == AreaType::index))
+            && dev->superblock.getStatus(area) != AreaStatus::active
+            && (dev->superblock.getType(area) == AreaType::data
+                || dev->superblock.getType(area) == AreaType::index))
         {
             PageOffs dirtyPages = countDirtyPages(cachePos);
             PAFFS_DBG_S(PAFFS_TRACE_ASCACHE,
                         "Checking Area %" PTYPE_AREAPOS " "
                         "with %" PTYPE_PAGEOFFS " dirty pages",
-                        it.first,
+                        area,
                         dirtyPages);
             if (dirtyPages >= favDirtyPages)
             {
-                favouriteArea = it.first;
-                clearedAreaCachePosition = it.second;
+                favouriteArea = area;
+                clearedAreaCachePosition = cachePos;
                 favDirtyPages = dirtyPages;
             }
         }
@@ -359,8 +447,8 @@ SummaryCache::commitAreaSummaryHard(int& clearedAreaCachePosition, bool desperat
             PAFFS_DBG_S(PAFFS_TRACE_ASCACHE,
                         "Ignored Area %" PTYPE_AREAPOS " "
                         "at cache pos %" PRIu16,
-                        it.first,
-                        it.second);
+                        area,
+                        cachePos);
             if (!mSummaryCache[cachePos].isDirty())
             {
                 PAFFS_DBG_S(PAFFS_TRACE_ASCACHE, "\tnot dirty");
@@ -369,14 +457,14 @@ SummaryCache::commitAreaSummaryHard(int& clearedAreaCachePosition, bool desperat
             {
                 PAFFS_DBG_S(PAFFS_TRACE_ASCACHE, "\tno AS written");
             }
-            if (dev->superblock.getStatus(it.first) == AreaStatus::active)
+            if (dev->superblock.getStatus(area) == AreaStatus::active)
             {
                 PAFFS_DBG_S(PAFFS_TRACE_ASCACHE,
                             "\tis active (%s)",
-                            areaNames[dev->superblock.getType(it.first)]);
+                            areaNames[dev->superblock.getType(area)]);
             }
-            if (dev->superblock.getType(it.first) != AreaType::data
-                && dev->superblock.getType(it.first) != AreaType::index)
+            if (dev->superblock.getType(area) != AreaType::data
+                && dev->superblock.getType(area) != AreaType::index)
             {
                 PAFFS_DBG_S(PAFFS_TRACE_ASCACHE, "\tnot data/index");
             }
@@ -416,8 +504,7 @@ SummaryCache::commitAreaSummaryHard(int& clearedAreaCachePosition, bool desperat
                 favouriteArea,
                 dev->superblock.getPos(favouriteArea));
 
-    SummaryEntry summary[dataPagesPerArea];
-    unpackStatusArray(cachePos, summary);
+    TwoBitList<dataPagesPerArea> summary = *mSummaryCache[cachePos].exposeSummary();
 
     bool validDataLeft;
     Result r = dev->areaMgmt.gc.moveValidDataToNewArea(
@@ -447,28 +534,11 @@ SummaryCache::commitAreaSummaryHard(int& clearedAreaCachePosition, bool desperat
 
         setSummaryStatus(favouriteArea, summary);
     }
+    mStatistics.hardCommits++;
 
     return Result::ok;
 }
 
-void
-SummaryCache::unpackStatusArray(uint16_t position, SummaryEntry* arr)
-{
-    for (uint16_t i = 0; i < dataPagesPerArea; i++)
-    {
-        arr[i] = mSummaryCache[position].getStatus(i);
-    }
-}
-
-void
-SummaryCache::packStatusArray(uint16_t position, SummaryEntry* arr)
-{
-    for (uint16_t i = 0; i < dataPagesPerArea; i++)
-    {
-        mSummaryCache[position].setStatus(i, arr[i]);
-    }
-}
-
 int
 SummaryCache::findNextFreeCacheEntry()
 {
@@ -515,8 +585,13 @@ SummaryCache::setPageStatus(AreaPos area, PageOffs page, SummaryEntry state)
                   "but this is only allowed by deleting the Area!",
                   area, page);
     }
-    if (!existsSummaryElem(area))
+    if (existsSummaryElem(area))
     {
+        mStatistics.hits++;
+    }
+    else
+    {
+        mStatistics.misses++;
         Result r = loadUnbufferedArea(area, true);
         if (r != Result::ok)
         {
@@ -535,7 +610,8 @@ SummaryCache::setPageStatus(AreaPos area, PageOffs page, SummaryEntry state)
         return Result::bug;
     }
 
-    if (mSummaryCache[getSummaryElemPos(area)].getStatus(page) == state)
+    SummaryEntry oldState = mSummaryCache[getSummaryElemPos(area)].getStatus(page);
+    if (oldState == state)
     {
         PAFFS_DBG_S(PAFFS_TRACE_ASCACHE, "Skipping set status b.c. status is the same");
         return Result::ok;
@@ -544,8 +620,10 @@ SummaryCache::setPageStatus(AreaPos area, PageOffs page, SummaryEntry state)
     dev->journal.addEvent(journalEntry::summaryCache::SetStatus(area, page, state));
     FAILPOINT;
     mSummaryCache[getSummaryElemPos(area)].setStatus(page, state);
+    updatePageCounts(area, oldState, state);
     if (!journalReplayMode && state == SummaryEntry::dirty)
     {
+        dev->areaMgmt.gc.pageInvalidated(area, page);
         if (traceMask & PAFFS_WRITE_VERIFY_AS)
         {
             uint8_t* writebuf = dev->driver.getPageBuffer();
@@ -570,6 +648,20 @@ SummaryCache::setPageStatus(AreaPos area, PageOffs page, SummaryEntry state)
                           mSummaryCache[getSummaryElemPos(area)].getDirtyPages());
                 return Result::fail;
             }
+            if (dirtyPagesCheck != mAreaDirtyPages[area]
+                || countUsedPages(getSummaryElemPos(area)) != mAreaUsedPages[area])
+            {
+                PAFFS_DBG(PAFFS_TRACE_BUG,
+                          "Page counters differ from actual count! "
+                          "(Area %" PTYPE_AREAPOS " has %" PTYPE_PAGEOFFS "/%" PTYPE_PAGEOFFS
+                          " dirty/used, thought %" PTYPE_PAGEOFFS "/%" PTYPE_PAGEOFFS ")",
+                          area,
+                          dirtyPagesCheck,
+                          countUsedPages(getSummaryElemPos(area)),
+                          mAreaDirtyPages[area],
+                          mAreaUsedPages[area]);
+                return Result::fail;
+            }
         }
 
         // Commit to Flash, nothing will change the data pages in flash
@@ -606,8 +698,13 @@ SummaryCache::getPageStatus(AreaPos area, PageOffs page, Result& result)
         result = Result::invalidInput;
         return SummaryEntry::error;
     }
-    if (!existsSummaryElem(area))
+    if (existsSummaryElem(area))
+    {
+        mStatistics.hits++;
+    }
+    else
     {
+        mStatistics.misses++;
         Result r = loadUnbufferedArea(area, false);
         if (r == Result::noSpace)
         {
@@ -652,14 +749,14 @@ SummaryCache::getPageStatus(AreaPos area, PageOffs page, Result& result)
 }
 
 Result
-SummaryCache::getSummaryStatus(AreaPos area, SummaryEntry* summary)
+SummaryCache::getSummaryStatus(AreaPos area, TwoBitList<dataPagesPerArea>& summary)
 {
     if (!existsSummaryElem(area))
     {
-        TwoBitList<dataPagesPerArea> list;
+        summary.clear();
         // This one does not have to be copied into Cache
         // Because it is just for a one-shot of Garbage collection looking for the best area
-        Result r = readAreasummary(area, list);
+        Result r = readAreasummary(area, summary);
         if (r == Result::ok || r == Result::biterrorCorrected)
         {
             // TODO: Handle biterror
@@ -672,20 +769,16 @@ SummaryCache::getSummaryStatus(AreaPos area, SummaryEntry* summary)
                         "Area %" PTYPE_AREAPOS " on %" PTYPE_AREAPOS, area, dev->superblock.getPos(area));
             r = Result::ok;
         }
-        for(uint16_t i = 0; i < dataPagesPerArea; i++)
-        {
-            summary[i] = AreaSummaryElem::getStatus(i, list);
-        }
         return r;
     }else
     {
-        unpackStatusArray(getSummaryElemPos(area), summary);
+        summary = *mSummaryCache[getSummaryElemPos(area)].exposeSummary();
         return Result::ok;
     }
 }
 
 Result
-SummaryCache::scanAreaForSummaryStatus(AreaPos area, SummaryEntry* summary)
+SummaryCache::scanAreaForSummaryStatus(AreaPos area, TwoBitList<dataPagesPerArea>& summary)
 {
     uint8_t* readbuf = dev->driver.getPageBuffer();
     for (PageOffs i = 0; i < dataPagesPerArea; i++)
@@ -695,7 +788,7 @@ SummaryCache::scanAreaForSummaryStatus(AreaPos area, SummaryEntry* summary)
         if (r != Result::ok)
         {
             //ignore
-            summary[i] = SummaryEntry::dirty;
+            AreaSummaryElem::setStatus(i, SummaryEntry::dirty, summary);
             continue;
         }
         bool containsData = false;
@@ -709,11 +802,11 @@ SummaryCache::scanAreaForSummaryStatus(AreaPos area, SummaryEntry* summary)
         }
         if (containsData)
         {
-            summary[i] = SummaryEntry::used;
+            AreaSummaryElem::setStatus(i, SummaryEntry::used, summary);
         }
         else
         {
-            summary[i] = SummaryEntry::free;
+            AreaSummaryElem::setStatus(i, SummaryEntry::free, summary);
         }
     }
     return Result::ok;
@@ -723,22 +816,20 @@ SummaryCache::scanAreaForSummaryStatus(AreaPos area, SummaryEntry* summary)
  * This function will not call garbage collection.
  */
 Result
-SummaryCache::setSummaryStatus(AreaPos area, SummaryEntry* summary)
+SummaryCache::setSummaryStatus(AreaPos area, const TwoBitList<dataPagesPerArea>& summary)
 {
     // Dont set Dirty, because GC just deleted AS and dirty Pages
     // This area ist likely to be used soon
     if (!existsSummaryElem(area))
     {
         Result r = loadUnbufferedArea(area, false);
-        if (r == Result::notFound)
+        if (r == Result::noSpace)
         {
             //No space for loading this area, so directly hardcommit this (Ugly!)
             AreaSummaryElem tmp;
-            tmp.setArea(dev->superblock.getActiveArea(AreaType::garbageBuffer));
-            for (uint16_t i = 0; i < dataPagesPerArea; i++)
-            {
-                tmp.setStatus(i, summary[i]);
-            }
+            tmp.setArea(area);
+            tmp.setSummary(summary);
+            setPageCounts(area, *tmp.exposeSummary());
             writeAreasummary(tmp);
             return Result::ok;
         }
@@ -749,7 +840,8 @@ SummaryCache::setSummaryStatus(AreaPos area, SummaryEntry* summary)
         }
     }
 
-    packStatusArray(getSummaryElemPos(area), summary);
+    mSummaryCache[getSummaryElemPos(area)].setSummary(summary);
+    setPageCounts(area, *mSummaryCache[getSummaryElemPos(area)].exposeSummary());
     dev->journal.addEvent(journalEntry::summaryCache::SetStatusBlock(
             area, *mSummaryCache[getSummaryElemPos(area)].exposeSummary()));
     return Result::ok;
@@ -758,6 +850,9 @@ SummaryCache::setSummaryStatus(AreaPos area, SummaryEntry* summary)
 Result
 SummaryCache::deleteSummary(AreaPos area)
 {
+    mAreaDirtyPages[area] = 0;
+    mAreaUsedPages[area] = 0;
+    mPageCountsChanged = true;
     if (!existsSummaryElem(area))
     {
         // This is not a bug, because an uncached area may also be deleted
@@ -773,6 +868,25 @@ SummaryCache::deleteSummary(AreaPos area)
     return Result::ok;
 }
 
+PageOffs
+SummaryCache::getDirtyPages(AreaPos area)
+{
+    return mAreaDirtyPages[area];
+}
+
+PageOffs
+SummaryCache::getUsedPages(AreaPos area)
+{
+    return mAreaUsedPages[area];
+}
+
+uint32_t
+SummaryCache::getAge(AreaPos area)
+{
+    // Wraps around together with the truncated deletion counter
+    return static_cast<uint32_t>(dev->superblock.getOverallDeletions()) - mAreaLastWrite[area];
+}
+
 // For Garbage collection to consider cached AS-Areas before others
 bool
 SummaryCache::shouldClearArea(AreaPos area)
@@ -830,6 +944,9 @@ SummaryCache::loadAreaSummaries()
     memset(&index, 0, sizeof(SuperIndex));
     index.summaries[0] = mSummaryCache[0].exposeSummary();
     index.summaries[1] = mSummaryCache[1].exposeSummary();
+    index.dirtyPages = mAreaDirtyPages;
+    index.usedPages = mAreaUsedPages;
+    index.lastWrite = mAreaLastWrite;
 
     PAFFS_DBG_S(PAFFS_TRACE_VERBOSE, "Inited SuperIndex");
 
@@ -840,6 +957,7 @@ SummaryCache::loadAreaSummaries()
         return r;
     }
     dev->superblock.setUsedAreas(index.usedAreas);
+    mPageCountsChanged = false;
     PAFFS_DBG_S(PAFFS_TRACE_VERBOSE, "read superIndex successfully");
 
     for (uint8_t i = 0; i < 2; i++)
@@ -903,7 +1021,7 @@ SummaryCache::commitAreaSummaries(bool createNew)
         PAFFS_DBG_S(PAFFS_TRACE_ASCACHE, "Committing AreaSummaries:");
         printStatus();
     }
-    while (mTranslation.size() > 2)
+    while (mCachedAreas > 2)
     {
         r = freeNextBestSummaryCacheEntry(true);
         if (r != Result::ok)
@@ -919,13 +1037,20 @@ SummaryCache::commitAreaSummaries(bool createNew)
 
     SuperIndex index;
     memset(&index, 0, sizeof(SuperIndex));
+    index.dirtyPages = mAreaDirtyPages;
+    index.usedPages = mAreaUsedPages;
+    index.lastWrite = mAreaLastWrite;
     // Rest of members are inited in superblock.cpp
 
-    bool someDirty = false;
+    bool someDirty = mPageCountsChanged;
 
     // write the open/uncommitted AS'es to Superindex
-    for (std::pair<AreaPos, uint16_t> cacheElem : mTranslation)
+    for (uint16_t cachePos = 0; cachePos < areaSummaryCacheSize; cachePos++)
     {
+        if (!mSummaryCache[cachePos].isUsed())
+        {
+            continue;
+        }
         // Clean Areas are not committed unless they are active
         if (pos >= 2)
         {
@@ -934,15 +1059,17 @@ SummaryCache::commitAreaSummaries(bool createNew)
                       "\tskipping lossy, because we have to unmount.");
             break;
         }
-        if (!mSummaryCache[cacheElem.second].isDirty()
-            && mSummaryCache[cacheElem.second].isAreaSummaryWritten())
+        // Elems loaded from the SuperIndex may carry dirty pages their AS does not know about
+        if (!mSummaryCache[cachePos].isDirty()
+            && mSummaryCache[cachePos].isAreaSummaryWritten()
+            && !mSummaryCache[cachePos].isLoadedFromSuperPage())
             continue;
 
-        someDirty |= mSummaryCache[cacheElem.second].isDirty()
-                     && !mSummaryCache[cacheElem.second].isLoadedFromSuperPage();
+        someDirty |= mSummaryCache[cachePos].isDirty()
+                     && !mSummaryCache[cachePos].isLoadedFromSuperPage();
 
-        index.areaSummaryPositions[pos] = cacheElem.first;
-        index.summaries[pos++] = mSummaryCache[cacheElem.second].exposeSummary();
+        index.areaSummaryPositions[pos] = mSummaryCache[cachePos].getArea();
+        index.summaries[pos++] = mSummaryCache[cachePos].exposeSummary();
     }
 
     r = dev->superblock.commitSuperIndex(&index, someDirty, createNew);
@@ -962,11 +1089,15 @@ SummaryCache::commitAreaSummaries(bool createNew)
         return r;
     }
 
-    for (std::pair<AreaPos, uint16_t> cacheElem : mTranslation)
+    for (uint16_t cachePos = 0; cachePos < areaSummaryCacheSize; cachePos++)
     {
-    	mSummaryCache[cacheElem.second].setDirty(false);
-    	mSummaryCache[cacheElem.second].setLoadedFromSuperPage();
+        if (mSummaryCache[cachePos].isUsed())
+        {
+            mSummaryCache[cachePos].setDirty(false);
+            mSummaryCache[cachePos].setLoadedFromSuperPage();
+        }
     }
+    mPageCountsChanged = false;
 
     return Result::ok;
 }
@@ -974,12 +1105,21 @@ SummaryCache::commitAreaSummaries(bool createNew)
 void
 SummaryCache::clear()
 {
-    for (std::pair<AreaPos, uint16_t> cacheElem : mTranslation)
+    for (uint16_t cachePos = 0; cachePos < areaSummaryCacheSize; cachePos++)
     {
-    	mSummaryCache[cacheElem.second].clear();
+        if (mSummaryCache[cachePos].isUsed())
+        {
+            mSummaryCache[cachePos].clear();
+        }
     }
-    mTranslation.clear();
+    memset(mTranslation, noCachePos, areasNo * sizeof(uint8_t));
+    mCachedAreas = 0;
     memset(firstUncommittedElem, 0, sizeof(JournalEntryPosition) * areasNo);
+    memset(mAreaDirtyPages, 0, sizeof(PageOffs) * areasNo);
+    memset(mAreaUsedPages, 0, sizeof(PageOffs) * areasNo);
+    memset(mAreaLastWrite, 0, sizeof(uint32_t) * areasNo);
+    mPageCountsChanged = false;
+    mRecountAfterReplay.clear();
 }
 
 JournalEntry::Topic
@@ -1007,6 +1147,10 @@ SummaryCache::preScan(const journalEntry::Max& entry, JournalEntryPosition posit
     }
 
     firstUncommittedElem[entry.summaryCache.area] = position;
+    if (entry.summaryCache.subtype == journalEntry::SummaryCache::Subtype::commit)
+    {
+        mRecountAfterReplay.setBit(entry.summaryCache.area);
+    }
     PAFFS_DBG_S(PAFFS_TRACE_ASCACHE | PAFFS_TRACE_JOURNAL,
               "Commit of %" PTYPE_AREAPOS " at %" PRIu32,
               entry.summaryCache.area, position.mram.offs);
@@ -1054,15 +1198,8 @@ SummaryCache::processEntry(const journalEntry::Max& entry, JournalEntryPosition
                       entry.summaryCache_.setStatus.status);
         break;
     case journalEntry::SummaryCache::Subtype::setStatusBlock:
-    {
-        SummaryEntry tmp[dataPagesPerArea];
-        for(PageOffs i = 0; i < dataPagesPerArea; i++)
-        {
-            tmp[i] = AreaSummaryElem::getStatus(i, entry.summaryCache_.setStatusBlock.status);
-        }
-        setSummaryStatus(entry.summaryCache.area, tmp);
+        setSummaryStatus(entry.summaryCache.area, entry.summaryCache_.setStatusBlock.status);
         break;
-    }
     default:
         return Result::nimpl;
     }
@@ -1072,6 +1209,29 @@ void
 SummaryCache::signalEndOfLog()
 {
     journalReplayMode = false;
+    // Changes before the last commit of an area were skipped, so its counters are outdated
+    for (AreaPos area = 0; area < areasNo; area++)
+    {
+        if (!mRecountAfterReplay.getBit(area))
+        {
+            continue;
+        }
+        mRecountAfterReplay.resetBit(area);
+        if (existsSummaryElem(area))
+        {
+            setPageCounts(area, *mSummaryCache[getSummaryElemPos(area)].exposeSummary());
+            continue;
+        }
+        TwoBitList<dataPagesPerArea> list;
+        Result r = readAreasummary(area, list);
+        if (r != Result::ok && r != Result::biterrorCorrected && r != Result::notFound)
+        {
+            PAFFS_DBG(PAFFS_TRACE_ERROR,
+                      "Could not recount pages of area %" PTYPE_AREAPOS, area);
+            continue;
+        }
+        setPageCounts(area, list);
+    }
     if(traceMask & PAFFS_TRACE_ASCACHE)
     {
         PAFFS_DBG_S(PAFFS_TRACE_ASCACHE, "EndOfLog AreaSummaries:");
@@ -1141,8 +1301,11 @@ SummaryCache::freeNextBestSummaryCacheEntry(bool urgent)
     {
         if (mSummaryCache[i].isUsed())
         {
-            if (!(mSummaryCache[i].isDirty() || mSummaryCache[i].isLoadedFromSuperPage())
-                || dev->superblock.getStatus(mSummaryCache[i].getArea()) == AreaStatus::empty)
+            AreaStatus status = dev->superblock.getStatus(mSummaryCache[i].getArea());
+            // The SuperIndex needs the summaries of active areas, even unchanged ones
+            if (status != AreaStatus::active
+                && (!(mSummaryCache[i].isDirty() || mSummaryCache[i].isLoadedFromSuperPage())
+                    || status == AreaStatus::empty))
             {
                 if (mSummaryCache[i].isDirty()
                     && dev->superblock.getStatus(mSummaryCache[i].getArea()) == AreaStatus::empty)
@@ -1160,6 +1323,7 @@ SummaryCache::freeNextBestSummaryCacheEntry(bool urgent)
                             "of area %" PTYPE_AREAPOS,
                             mSummaryCache[i].getArea());
                 removeSummaryElem(mSummaryCache[i].getArea());
+                mStatistics.evictions++;
                 fav = i;
             }
         }
@@ -1205,11 +1369,12 @@ SummaryCache::freeNextBestSummaryCacheEntry(bool urgent)
 
     PAFFS_DBG_S(PAFFS_TRACE_ASCACHE,
                 "freeNextBestCache found no uncommitted Area, activating Garbage collection");
+    mStatistics.collections++;
     Result r = dev->areaMgmt.gc.collectGarbage(AreaType::unset);
 
     if (r == Result::ok)
     {
-        if (mTranslation.size() < areaSummaryCacheSize)
+        if (mCachedAreas < areaSummaryCacheSize)
         {
             // GC freed something
             return Result::ok;
@@ -1289,29 +1454,24 @@ SummaryCache::freeNextBestSummaryCacheEntry(bool urgent)
 PageOffs
 SummaryCache::countDirtyPages(uint16_t position)
 {
-    uint32_t dirty = 0;
-    for (uint32_t i = 0; i < dataPagesPerArea; i++)
-    {
-        if (mSummaryCache[position].getStatus(i) == SummaryEntry::dirty)
-        {
-            dirty++;
-        }
-    }
-    return dirty;
+    return mSummaryCache[position].countStatus(SummaryEntry::dirty);
 }
 
 PageOffs
 SummaryCache::countUsedPages(uint16_t position)
 {
-    uint32_t used = 0;
-    for (uint32_t i = 0; i < dataPagesPerArea; i++)
+    return mSummaryCache[position].countStatus(SummaryEntry::used);
+}
+
+Result
+SummaryCache::findFirstFreePage(PageOffs& page, AreaPos area)
+{
+    if (!existsSummaryElem(area))
     {
-        if (mSummaryCache[position].getStatus(i) == SummaryEntry::used)
-        {
-            used++;
-        }
+        return Result::notFound;
     }
-    return used;
+    page = mSummaryCache[getSummaryElemPos(area)].findFirstStatus(SummaryEntry::free);
+    return page < dataPagesPerArea ? Result::ok : Result::noSpace;
 }
 
 PageOffs
@@ -1340,6 +1500,7 @@ SummaryCache::commitAndEraseElem(uint16_t position)
                 "entry of area %" PRId16 "",
                 mSummaryCache[position].getArea());
     removeSummaryElem(mSummaryCache[position].getArea());
+    mStatistics.evictions++;
     return Result::ok;
 }
 
@@ -1356,68 +1517,46 @@ SummaryCache::writeAreasummary(AreaSummaryElem& elem)
         PAFFS_DBG(PAFFS_TRACE_BUG, "Tried to commit an elem in Journal replay!");
         return Result::bug;
     }
-    uint8_t* summary;
-    if(areaSummaryIsPacked)
-    {
-        BitList<dataPagesPerArea> packedSummary;
-        if(packedSummary.byteUsage != static_cast<size_t>(areaSummarySizePacked - 1))
-        {
-            PAFFS_DBG(PAFFS_TRACE_BUG, "Calculated Bytes for areaSummary differ!"
-                    "(BitList: %zu, autocalc: %" PRIu16 ")",
-                    packedSummary.byteUsage, areaSummarySizePacked - 1);
-            return Result::bug;
-        }
-        // TODO: Check if areaOOB is clean, and maybe Verify written data
-        PAFFS_DBG_S(
-                PAFFS_TRACE_ASCACHE, "Committing AreaSummary to Area %" PRId16 "", elem.getArea());
+    // TODO: Check if areaOOB is clean, and maybe Verify written data
+    PAFFS_DBG_S(PAFFS_TRACE_ASCACHE, "Committing AreaSummary to Area %" PRId16 "", elem.getArea());
 
-        for (uint16_t j = 0; j < dataPagesPerArea; j++)
+    const uint8_t* summary = elem.exposeSummary()->expose();
+    uint16_t written = 0;
+    for (PageOffs i = 0; i < oobPagesPerArea; i++)
+    {
+        PageAbs page = getPageNumber(combineAddress(elem.getArea(), dataPagesPerArea + i), *dev);
+        Result r;
+        if (traceMask & PAFFS_TRACE_VERIFY_AS)
         {
-            if (elem.getStatus(j) != SummaryEntry::dirty)
+            uint8_t* readbuf = dev->driver.getPageBuffer();
+            r = dev->driver.readPage(page, readbuf, totalBytesPerPage);
+            for(uint16_t j = 0; j < totalBytesPerPage; j++)
             {
-                packedSummary.setBit(j);
+                if (static_cast<uint8_t>(readbuf[j]) != 0xFF)
+                {
+                    PAFFS_DBG(PAFFS_TRACE_BUG,
+                              "Area %" PTYPE_AREAPOS,
+                              elem.getArea());
+                    return Result::bug;
+                }
             }
         }
-        summary = packedSummary.expose();
-    }else
-    {
-        summary = elem.exposeSummary()->expose();
-    }
-
-    PageAbs page =
-            getPageNumber(combineAddress(elem.getArea(), dataPagesPerArea), *dev);
-    Result r;
-    uint16_t btw;
-    if(areaSummaryIsPacked)
-    {
-        btw = areaSummarySizePacked;
-    }else
-    {
-        btw = areaSummarySizeUnpacked;
-    }
-
-    if (traceMask & PAFFS_TRACE_VERIFY_AS)
-    {
-        uint8_t* readbuf = dev->driver.getPageBuffer();
-        r = dev->driver.readPage(page, readbuf, totalBytesPerPage);
-        for(uint16_t i = 0; i < totalBytesPerPage; i++)
+        uint8_t* writebuf = dev->driver.getPageBuffer();
+        // First page starts with the magic marker
+        uint16_t offs = i == 0 ? sizeof(uint8_t) : 0;
+        uint16_t btw = areaSummarySize - 1 - written;
+        if (btw > dataBytesPerPage - offs)
         {
-            if (static_cast<uint8_t>(readbuf[i]) != 0xFF)
-            {
-                PAFFS_DBG(PAFFS_TRACE_BUG,
-                          "Area %" PTYPE_AREAPOS,
-                          elem.getArea());
-                return Result::bug;
-            }
+            btw = dataBytesPerPage - offs;
         }
-    }
-    uint8_t* writebuf = dev->driver.getPageBuffer();
-    writebuf[0] = 0;
-    memcpy(&writebuf[sizeof(uint8_t)], summary, btw - 1);
-    r = dev->driver.writePage(page, writebuf, btw);
-    if (r != Result::ok)
-    {
-        return r;
+        writebuf[0] = 0;
+        memcpy(&writebuf[offs], &summary[written], btw);
+        r = dev->driver.writePage(page, writebuf, offs + btw);
+        if (r != Result::ok)
+        {
+            return r;
+        }
+        written += btw;
     }
     dev->journal.addEvent(journalEntry::summaryCache::Commit(elem.getArea()));
     elem.setAreaSummaryWritten();
@@ -1429,91 +1568,41 @@ Result
 SummaryCache::readAreasummary(AreaPos area, TwoBitList<dataPagesPerArea>& elem)
 {
     bool bitErrorWasCorrected = false;
-    PageAbs basePage = getPageNumber(combineAddress(area, dataPagesPerArea), *dev);
-    Result r;
-    uint16_t btr;
-    if(areaSummaryIsPacked)
-    {
-        btr = areaSummarySizePacked;
-    }else
-    {
-        btr = areaSummarySizeUnpacked;
-    }
-    uint8_t* readbuf = dev->driver.getPageBuffer();
-    r = dev->driver.readPage(basePage, readbuf, btr);
-    if (r != Result::ok)
-    {
-        if (r == Result::biterrorCorrected)
-        {
-            bitErrorWasCorrected = true;
-            PAFFS_DBG(PAFFS_TRACE_INFO,
-                      "Corrected biterror, triggering dirty areaSummary for rewrite.");
-        }
-        else
+    uint8_t* summary = elem.expose();
+    uint16_t read = 0;
+    for (PageOffs i = 0; i < oobPagesPerArea; i++)
+    {
+        PageAbs page = getPageNumber(combineAddress(area, dataPagesPerArea + i), *dev);
+        uint16_t offs = i == 0 ? sizeof(uint8_t) : 0;
+        uint16_t btr = areaSummarySize - 1 - read;
+        if (btr > dataBytesPerPage - offs)
         {
-            return r;
+            btr = dataBytesPerPage - offs;
         }
-    }
-
-    if (readbuf[0] != 0)
-    {
-        // Magic marker not here, so no AS present
-        PAFFS_DBG_S(PAFFS_TRACE_ASCACHE, "And just found an unset AS.");
-        return Result::notFound;
-    }
-
-    if(areaSummaryIsPacked)
-    {
-        uint8_t summary[areaSummarySizePacked - 1];
-        memcpy(summary, &readbuf[1], areaSummarySizePacked - 1);
-        for (uint16_t i = 0; i < dataPagesPerArea; i++)
+        uint8_t* readbuf = dev->driver.getPageBuffer();
+        Result r = dev->driver.readPage(page, readbuf, offs + btr);
+        if (r != Result::ok)
         {
-            //Extract every Bit of this bitlist
-            if (BitList<areaSummarySizePacked>::getBit(i, summary))
+            if (r == Result::biterrorCorrected)
             {
-                Addr tmp = combineAddress(area, i);
-                r = dev->driver.readPage(getPageNumber(tmp, *dev), readbuf, totalBytesPerPage);
-                if (r != Result::ok)
-                {
-                    if (r == Result::biterrorCorrected)
-                    {
-                        bitErrorWasCorrected = true;
-                        PAFFS_DBG(PAFFS_TRACE_INFO,
-                                  "Corrected biterror, triggering dirty areaSummary for "
-                                  "rewrite by Garbage collection.\n\t(Hopefully it runs before an "
-                                  "additional bitflip happens)");
-                    }
-                    else
-                    {
-                        return r;
-                    }
-                }
-                bool containsData = false;
-                for (uint16_t byte = 0; byte < totalBytesPerPage; byte++)
-                {
-                    if (readbuf[byte] != 0xFF)
-                    {
-                        containsData = true;
-                        break;
-                    }
-                }
-                if (containsData)
-                {
-                    AreaSummaryElem::setStatus(i, SummaryEntry::used, elem);
-                }
-                else
-                {
-                    AreaSummaryElem::setStatus(i, SummaryEntry::free, elem);
-                }
+                bitErrorWasCorrected = true;
+                PAFFS_DBG(PAFFS_TRACE_INFO,
+                          "Corrected biterror, triggering dirty areaSummary for rewrite.");
             }
             else
             {
-                AreaSummaryElem::setStatus(i, SummaryEntry::dirty, elem);
+                return r;
             }
         }
-    }else
-    {
-        memcpy(elem.expose(), &readbuf[1], areaSummarySizeUnpacked-1);
+
+        if (i == 0 && readbuf[0] != 0)
+        {
+            // Magic marker not here, so no AS present
+            PAFFS_DBG_S(PAFFS_TRACE_ASCACHE, "And just found an unset AS.");
+            return Result::notFound;
+        }
+        memcpy(&summary[read], &readbuf[offs], btr);
+        read += btr;
     }
 
     if (bitErrorWasCorrected)
@@ -16,7 +16,6 @@
 #include "commonTypes.hpp"
 #include "journalTopic.hpp"
 #include "bitlist.hpp"
-#include <unordered_map>
 
 namespace paffs
 {
@@ -41,6 +40,21 @@ public:
     setStatus(PageOffs page, SummaryEntry value);
     static void
     setStatus(PageOffs page, SummaryEntry value, TwoBitList<dataPagesPerArea>& list);
+    /**
+     * Number of pages with status \p value, counted word by word
+     */
+    PageOffs
+    countStatus(SummaryEntry value);
+    /**
+     * Replaces all entries at once, same as calling setStatus for every page
+     */
+    void
+    setSummary(const TwoBitList<dataPagesPerArea>& summary);
+    /**
+     * First page with status \p value, dataPagesPerArea if there is none
+     */
+    PageOffs
+    findFirstStatus(SummaryEntry value);
     bool
     isDirty();
     void
@@ -70,16 +84,41 @@ public:
     exposeSummary();
 };
 
+struct SummaryCacheStatistics
+{
+    uint32_t hits;         // page status accesses of cached areas
+    uint32_t misses;       // page status accesses that had to load an area summary
+    uint32_t evictions;    // cache elements freed to make room for another area
+    uint32_t collections;  // garbage collections run because nothing could be evicted
+    uint32_t hardCommits;  // evictions that swapped a whole area through the GC buffer
+};
+
 class SummaryCache : public JournalTopic
 {
     // excess byte is for dirty- and wasASWritten marker
     AreaSummaryElem mSummaryCache[areaSummaryCacheSize];
 
-    std::unordered_map<AreaPos, uint16_t> mTranslation;  // from area number to array offset
+    // From area number to array offset, noCachePos if the area is not cached.
+    // A direct table instead of a hash map, so lookups never allocate or hash.
+    static constexpr uint8_t noCachePos = 0xFF;
+    static_assert(areaSummaryCacheSize < noCachePos, "Cache positions must fit into a byte");
+    uint8_t mTranslation[areasNo];
+    uint8_t mCachedAreas = 0;
     Device* dev;
 
     bool journalReplayMode = false;
     JournalEntryPosition firstUncommittedElem[areasNo];
+
+    // Dirty and used pages of every area, cached or not. Persisted with the SuperIndex.
+    PageOffs mAreaDirtyPages[areasNo];
+    PageOffs mAreaUsedPages[areasNo];
+    // Overall deletions at the last page written to every area
+    uint32_t mAreaLastWrite[areasNo];
+    bool mPageCountsChanged = false;
+    // Areas whose AS got committed after the SuperIndex, so their counters are recounted on replay
+    BitList<areasNo> mRecountAfterReplay;
+
+    SummaryCacheStatistics mStatistics = {};
 public:
     SummaryCache(Device* mdev);
     ~SummaryCache();
@@ -103,20 +142,20 @@ public:
     getPageStatus(AreaPos area, PageOffs page, Result& result);
 
     Result
-    setSummaryStatus(AreaPos area, SummaryEntry* summary);
+    setSummaryStatus(AreaPos area, const TwoBitList<dataPagesPerArea>& summary);
 
     /**
      * This one does not copy into Cache
      * Because it is just for a one-shot of Garbage collection looking for the best area
      */
     Result
-    getSummaryStatus(AreaPos area, SummaryEntry* summary);
+    getSummaryStatus(AreaPos area, TwoBitList<dataPagesPerArea>& summary);
 
     /*
      * Reads every Page for data instead of scanning just OOB
      */
     Result
-    scanAreaForSummaryStatus(AreaPos area, SummaryEntry* summary);
+    scanAreaForSummaryStatus(AreaPos area, TwoBitList<dataPagesPerArea>& summary);
 
     /*
      * \warn Only for retired or unused Areas
@@ -124,6 +163,28 @@ public:
     Result
     deleteSummary(AreaPos area);
 
+    /**
+     * Used by Garbage collection to select a victim without loading its AS
+     */
+    PageOffs
+    getDirtyPages(AreaPos area);
+
+    PageOffs
+    getUsedPages(AreaPos area);
+
+    /**
+     * @return the number of area deletions since the last page was written to area
+     */
+    uint32_t
+    getAge(AreaPos area);
+
+    /**
+     * Searches the cached summary of \p area for its first free page.
+     * Returns Result::notFound if the area is not cached, Result::noSpace if it is full.
+     */
+    Result
+    findFirstFreePage(PageOffs& page, AreaPos area);
+
     /**
      * Used by Garbage collection to consider cached AS-Areas before others
      */
@@ -170,8 +231,17 @@ public:
     void
     printStatus();
 
+    const SummaryCacheStatistics&
+    getStatistics();
+    void
+    resetStatistics();
 
 private:
+    void
+    updatePageCounts(AreaPos area, SummaryEntry oldState, SummaryEntry newState);
+    void
+    setPageCounts(AreaPos area, const TwoBitList<dataPagesPerArea>& list);
+
     void
     enableSummaryElem(uint16_t pos, AreaPos area);
     void
@@ -197,12 +267,6 @@ private:
     void
     setPackedStatus(uint16_t position, PageOffs page, SummaryEntry value);
 
-    void
-    unpackStatusArray(uint16_t position, SummaryEntry* arr);
-
-    void
-    packStatusArray(uint16_t position, SummaryEntry* arr);
-
     int
     findNextFreeCacheEntry();
 
@@ -215,6 +279,7 @@ private:
     Result
     freeNextBestSummaryCacheEntry(bool urgent);
 
+
     PageOffs
     countDirtyPages(uint16_t position);
 
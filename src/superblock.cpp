@@ -38,6 +38,12 @@ SuperIndex::deserializeFromBuffer(const uint8_t* buf)
     pointer += AreaType::no * sizeof(AreaPos);
     memcpy(&overallDeletions, &buf[pointer], sizeof(uint64_t));
     pointer += sizeof(uint64_t);
+    memcpy(dirtyPages, &buf[pointer], areasNo * sizeof(PageOffs));
+    pointer += areasNo * sizeof(PageOffs);
+    memcpy(usedPages, &buf[pointer], areasNo * sizeof(PageOffs));
+    pointer += areasNo * sizeof(PageOffs);
+    memcpy(lastWrite, &buf[pointer], areasNo * sizeof(uint32_t));
+    pointer += areasNo * sizeof(uint32_t);
     memcpy(areaSummaryPositions, &buf[pointer], 2 * sizeof(AreaPos));
     pointer += 2 * sizeof(AreaPos);
 
@@ -79,6 +85,11 @@ SuperIndex::serializeToBuffer(uint8_t* buf)
         PAFFS_DBG(PAFFS_TRACE_BUG, "ActiveArea not set!");
         return Result::bug;
     }
+    if (dirtyPages == nullptr || usedPages == nullptr || lastWrite == nullptr)
+    {
+        PAFFS_DBG(PAFFS_TRACE_BUG, "Page counters not set!");
+        return Result::bug;
+    }
     uint16_t pointer = 0;
     memcpy(&buf[pointer], &logPrev, sizeof(AreaPos));
     pointer += sizeof(AreaPos);
@@ -92,6 +103,12 @@ SuperIndex::serializeToBuffer(uint8_t* buf)
     pointer += AreaType::no * sizeof(AreaPos);
     memcpy(&buf[pointer], &overallDeletions, sizeof(uint64_t));
     pointer += sizeof(uint64_t);
+    memcpy(&buf[pointer], dirtyPages, areasNo * sizeof(PageOffs));
+    pointer += areasNo * sizeof(PageOffs);
+    memcpy(&buf[pointer], usedPages, areasNo * sizeof(PageOffs));
+    pointer += areasNo * sizeof(PageOffs);
+    memcpy(&buf[pointer], lastWrite, areasNo * sizeof(uint32_t));
+    pointer += areasNo * sizeof(uint32_t);
     memcpy(&buf[pointer], areaSummaryPositions, 2 * sizeof(AreaPos));
     pointer += 2 * sizeof(AreaPos);
 
@@ -195,6 +212,15 @@ SuperIndex::isPlausible()
             ++usedAreasCheck;
         }
         overallDeletionsCheck += areaMap[i].erasecount;
+        if (dirtyPages[i] + usedPages[i] > dataPagesPerArea)
+        {
+            PAFFS_DBG(PAFFS_TRACE_ERROR,
+                      "Page counters of area %" PTYPE_AREAPOS " are unplausible! "
+                      "(%" PTYPE_PAGEOFFS " dirty, %" PTYPE_PAGEOFFS " used, "
+                      "should <= %" PTYPE_PAGEOFFS ")",
+                      i, dirtyPages[i], usedPages[i], dataPagesPerArea);
+            return false;
+        }
     }
     if(usedAreasCheck != usedAreas)
     {
@@ -226,6 +252,8 @@ SuperIndex::print()
         printf("\t%02" PTYPE_AREAPOS "->%02" PTYPE_AREAPOS, i, areaMap[i].position);
         printf(" %10s", areaNames[areaMap[i].type]);
         printf(" %6s", areaStatusNames[areaMap[i].status]);
+        printf(" %3" PTYPE_PAGEOFFS "/%3" PTYPE_PAGEOFFS " dirty/used",
+               dirtyPages[i], usedPages[i]);
         bool found = false;
         for (uint8_t asOffs = 0; asOffs < 2; asOffs++)
         {
@@ -777,7 +805,7 @@ Superblock::readSuperIndex(SuperIndex* index)
                         static_cast<unsigned int>(index->areaMap[i].type));
             return Result::fail;
         }
-        if (index->areaMap[i].status > AreaStatus::empty)
+        if (index->areaMap[i].status > AreaStatus::erasePending)
         {
             PAFFS_DBG_S(PAFFS_TRACE_ERROR,
                         "Status of area %" PTYPE_AREAPOS " unplausible! (%" PTYPE_AREAPOS ")",
@@ -62,6 +62,11 @@ struct SuperIndex
     Area* areaMap;
     AreaPos* activeArea;
     uint64_t overallDeletions;
+    //! dirty and used pages of every area, to select GC victims without reading summaries
+    PageOffs* dirtyPages;
+    PageOffs* usedPages;
+    //! overall deletions at the last write to an area, as its age for the GC
+    uint32_t* lastWrite;
     //"internal"
     AreaPos areaSummaryPositions[2];
     //! may contain non-active areaSummaries.
@@ -77,6 +82,8 @@ struct SuperIndex
                sizeof(Area) * areasNo +          // AreaMap
                sizeof(AreaPos) * AreaType::no +  // ActiveAreas
                sizeof(uint64_t) +                // overallDeletions
+               sizeof(PageOffs) * areasNo * 2 +  // dirty and used page counters
+               sizeof(uint32_t) * areasNo +      // last write of areas
                sizeof(AreaPos) * 2
                +  // Area Summary Positions
                TwoBitList<dataPagesPerArea>::byteUsage * numberOfAreaSummaries
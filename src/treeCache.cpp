@@ -25,6 +25,7 @@ namespace paffs
 TreeCache::TreeCache(Device* mdev) : dev(mdev), statemachine(mdev->journal, mdev->sumCache)
 {
     clear();
+    resetStatistics();
 };
 
 void
@@ -58,7 +59,7 @@ TreeCache::findFirstFreeIndex()
 }
 
 uint16_t
-TreeCache::getIndexFromPointer(TreeCacheNode& tcn)
+TreeCache::getIndexFromPointer(const TreeCacheNode& tcn)
 {
     if (&tcn - mCache >= treeNodeCacheSize)
     {
@@ -69,6 +70,46 @@ TreeCache::getIndexFromPointer(TreeCacheNode& tcn)
     return &tcn - mCache;
 }
 
+TreeCacheLink
+TreeCache::getLink(const TreeCacheNode& tcn)
+{
+    return getIndexFromPointer(tcn) + 1;
+}
+
+TreeCacheNode*
+TreeCache::getNode(TreeCacheLink link)
+{
+    if (link == noCacheLink)
+    {
+        return nullptr;
+    }
+    return &mCache[link - 1];
+}
+
+TreeCacheNode*
+TreeCache::getChild(const TreeCacheNode& tcn, uint16_t index)
+{
+    return getNode(tcn.pointers[index]);
+}
+
+void
+TreeCache::setChild(TreeCacheNode& tcn, uint16_t index, TreeCacheNode* child)
+{
+    tcn.pointers[index] = child == nullptr ? noCacheLink : getLink(*child);
+}
+
+TreeCacheNode*
+TreeCache::getParent(const TreeCacheNode& tcn)
+{
+    return getNode(tcn.parent);
+}
+
+void
+TreeCache::setParent(TreeCacheNode& tcn, TreeCacheNode* parent)
+{
+    tcn.parent = parent == nullptr ? noCacheLink : getLink(*parent);
+}
+
 /**
  * Deletes all the nodes
  */
@@ -76,6 +117,8 @@ void
 TreeCache::clear()
 {
     memset(mCache, 0, treeNodeCacheSize * sizeof(TreeCacheNode));
+    memset(mLastUse, 0, sizeof(mLastUse));
+    mClock = 0;
     mCacheUsage.clear();
     resetState();
 }
@@ -131,6 +174,7 @@ TreeCache::tryAddNewCacheNode(TreeCacheNode*& newTcn)
     newTcn = &mCache[index];
     memset(newTcn, 0, sizeof(TreeCacheNode));
     setIndexUsed(index);
+    touch(*newTcn);
     PAFFS_DBG_S(PAFFS_TRACE_TREECACHE, "Created new Cache element %p (position %d)", newTcn, index);
     return Result::ok;
 }
@@ -144,10 +188,10 @@ TreeCache::tryGetHeight(uint16_t &heightOut)
         if(mCacheUsage.getBit(node) && mCache[node].raw.isLeaf)
         {
             TreeCacheNode* curr = &mCache[node];
-            while(curr != curr->parent)
+            while(curr != getParent(*curr))
             {
                 ++heightOut;
-                curr = curr->parent;
+                curr = getParent(*curr);
             }
             return Result::ok;
         }
@@ -193,15 +237,15 @@ TreeCache::isParentPathClean(TreeCacheNode& tcn)
 {
     if (tcn.dirty)
         return false;
-    if (tcn.parent == &tcn)
+    if (getParent(tcn) == &tcn)
         return true;
-    if (tcn.parent == nullptr)
+    if (tcn.parent == noCacheLink)
     {
         PAFFS_DBG(PAFFS_TRACE_BUG, "Parent of %p is nullptr!", &tcn);
         dev->lasterr = Result::bug;
         return false;
     }
-    return isParentPathClean(*tcn.parent);
+    return isParentPathClean(*getParent(tcn));
 }
 
 /**
@@ -217,9 +261,9 @@ TreeCache::areSiblingsClean(TreeCacheNode& tcn)
         return !tcn.dirty;
     for (int i = 0; i <= tcn.raw.keys; i++)
     {
-        if (tcn.pointers[i] == nullptr)  // Siblings not in cache
+        if (tcn.pointers[i] == noCacheLink)  // Siblings not in cache
             continue;
-        if (!areSiblingsClean(*tcn.pointers[i]))
+        if (!areSiblingsClean(*getChild(tcn, i)))
         {
             tcn.dirty = true;
             return false;
@@ -236,7 +280,7 @@ TreeCache::isSubTreeValid(TreeCacheNode& node,
 {
     reachable.setBit(getIndexFromPointer(node));
 
-    if (node.parent == nullptr)
+    if (node.parent == noCacheLink)
     {
         PAFFS_DBG(PAFFS_TRACE_BUG, "Node n° %d has invalid parent!", getIndexFromPointer(node));
         return false;
@@ -360,26 +404,26 @@ TreeCache::isSubTreeValid(TreeCacheNode& node,
                 first = false;
             }
 
-            if (node.pointers[i] != nullptr)
+            if (node.pointers[i] != noCacheLink)
             {
-                if (node.pointers[i] - mCache >= treeNodeCacheSize)
+                if (node.pointers[i] > treeNodeCacheSize)
                 {
                     PAFFS_DBG(PAFFS_TRACE_BUG, "Node %" PRIu16 " contains invalid non-zero child at %" PRIu16,
                               getIndexFromPointer(node), i);
                     return false;
                 }
-                if (node.pointers[i]->parent != &node)
+                if (getParent(*getChild(node, i)) != &node)
                 {
                     PAFFS_DBG(PAFFS_TRACE_BUG,
                               "Node n° %" PRIu16 " stated parent was %" PRIu16 ", but is actually %" PRIu16 "!",
-                              getIndexFromPointer(*node.pointers[i]),
-                              getIndexFromPointer(*node.pointers[i]->parent),
+                              getIndexFromPointer(*getChild(node, i)),
+                              getIndexFromPointer(*getParent(*getChild(node, i))),
                               getIndexFromPointer(node));
                     return false;
                 }
                 long keyMin_n = i == 0 ? 0 : node.raw.as.branch.keys[i - 1];
                 long keyMax_n = i >= node.raw.keys ? 0 : node.raw.as.branch.keys[i];
-                if (!isSubTreeValid(*node.pointers[i], reachable, keyMin_n, keyMax_n))
+                if (!isSubTreeValid(*getChild(node, i), reachable, keyMin_n, keyMax_n))
                     return false;
             }
         }
@@ -416,21 +460,21 @@ TreeCache::isTreeCacheValid()
                 {
                     // it is allowed if we are moving a parent around
                     bool parentLocked = false;
-                    TreeCacheNode* par = mCache[i].parent;
+                    TreeCacheNode* par = getParent(mCache[i]);
                     if(par == nullptr)
                     {
                         PAFFS_DBG(PAFFS_TRACE_BUG, "Cache entry %" PRIu16 " parent is null!", i);
                         valid = false;
                         break;
                     }
-                    while (par != par->parent)
+                    while (par != getParent(*par))
                     {
                         if (par->locked)
                         {
                             parentLocked = true;
                             break;
                         }
-                        par = par->parent;
+                        par = getParent(*par);
                     }
                     if (!parentLocked)
                     {
@@ -461,11 +505,11 @@ TreeCache::resolveDirtyPaths(TreeCacheNode& tcn)
     bool anyDirt = false;
     for (int i = 0; i <= tcn.raw.keys; i++)
     {
-        if (tcn.pointers[i] == nullptr)
+        if (tcn.pointers[i] == noCacheLink)
             continue;
-        if (!isIndexUsed(getIndexFromPointer(*tcn.pointers[i])))  // Sibling is not in cache)
+        if (!isIndexUsed(getIndexFromPointer(*getChild(tcn, i))))  // Sibling is not in cache)
             continue;
-        if (resolveDirtyPaths(*tcn.pointers[i]))
+        if (resolveDirtyPaths(*getChild(tcn, i)))
         {
             tcn.dirty = true;
             anyDirt = true;
@@ -478,21 +522,21 @@ void
 TreeCache::markParentPathDirty(TreeCacheNode& tcn)
 {
     tcn.dirty = true;
-    if (tcn.parent == &tcn)
+    if (getParent(tcn) == &tcn)
         return;
-    if (isIndexUsed(getIndexFromPointer(*tcn.parent)))
+    if (isIndexUsed(getIndexFromPointer(*getParent(tcn))))
     {
         PAFFS_DBG(PAFFS_TRACE_BUG, "Parent of %p is not in cache!", &tcn);
         dev->lasterr = Result::bug;
         return;
     }
-    return markParentPathDirty(*tcn.parent);
+    return markParentPathDirty(*getParent(tcn));
 }
 
 void
 TreeCache::deleteFromParent(TreeCacheNode& tcn)
 {
-    if (tcn.parent == nullptr)
+    if (tcn.parent == noCacheLink)
     {
         PAFFS_DBG(PAFFS_TRACE_BUG,
                   "Tried to delete node %d from nullptr parent!",
@@ -501,7 +545,7 @@ TreeCache::deleteFromParent(TreeCacheNode& tcn)
         dev->lasterr = Result::bug;
         return;
     }
-    TreeCacheNode*& parent = tcn.parent;
+    TreeCacheNode* parent = getParent(tcn);
     if (parent == &tcn)
         return;
     if (!isIndexUsed(getIndexFromPointer(*parent)))
@@ -513,9 +557,9 @@ TreeCache::deleteFromParent(TreeCacheNode& tcn)
     }
     for (unsigned int i = 0; i <= parent->raw.keys; i++)
     {
-        if (parent->pointers[i] == &tcn)
+        if (getChild(*parent, i) == &tcn)
         {
-            parent->pointers[i] = nullptr;
+            parent->pointers[i] = noCacheLink;
             return;
         }
     }
@@ -527,26 +571,43 @@ TreeCache::hasNoChilds(TreeCacheNode& tcn)
     if (tcn.raw.isLeaf)
         return true;
     for (int i = 0; i <= tcn.raw.keys; i++)
-        if (tcn.pointers[i] != nullptr)
+        if (tcn.pointers[i] != noCacheLink)
             return false;
     return true;
 }
 
-uint16_t
-TreeCache::deletePathToRoot(TreeCacheNode& tcn)
+void
+TreeCache::touch(TreeCacheNode& tcn)
 {
-    if (tcn.dirty || tcn.locked || tcn.inheritedLock)
-        return 0;
+    mLastUse[getIndexFromPointer(tcn)] = ++mClock;
+}
 
-    deleteFromParent(tcn);
-    setIndexFree(getIndexFromPointer(tcn));
-    if (tcn.parent != &tcn && hasNoChilds(*tcn.parent))
-        return 1 + deletePathToRoot(*tcn.parent);
-    return 1;
+int16_t
+TreeCache::findEvictionCandidate(bool leavesOnly)
+{
+    int16_t candidate = -1;
+    bool candidateIsRoot = true;
+    for (uint16_t i = 0; i < treeNodeCacheSize; i++)
+    {
+        if (!isIndexUsed(i))
+            continue;
+        if (mCache[i].dirty || mCache[i].locked || mCache[i].inheritedLock)
+            continue;
+        if (leavesOnly ? !mCache[i].raw.isLeaf : !hasNoChilds(mCache[i]))
+            continue;
+        bool isRoot = i == mCacheRoot;
+        if (candidate < 0 || (candidateIsRoot && !isRoot)
+            || (isRoot == candidateIsRoot && mLastUse[i] < mLastUse[candidate]))
+        {
+            candidate = i;
+            candidateIsRoot = isRoot;
+        }
+    }
+    return candidate;
 }
 
 /*
- * Just frees clean leaf nodes
+ * Just frees clean leaf nodes, least recently used first
  */
 Result
 TreeCache::cleanFreeLeafNodes(uint16_t& neededCleanNodes)
@@ -556,26 +617,25 @@ TreeCache::cleanFreeLeafNodes(uint16_t& neededCleanNodes)
     if (dev->lasterr != Result::ok)
         return dev->lasterr;
 
-    for (unsigned int i = 0; i < treeNodeCacheSize; i++)
+    while (neededCleanNodes > 0)
     {
-        if (!isIndexUsed(getIndexFromPointer(mCache[i])))
-            continue;
-        if (!mCache[i].dirty && !mCache[i].locked && !mCache[i].inheritedLock && mCache[i].raw.isLeaf)
+        int16_t victim = findEvictionCandidate(true);
+        if (victim < 0)
         {
-            deleteFromParent(mCache[i]);
-            setIndexFree(i);
-            neededCleanNodes--;
-            if (neededCleanNodes == 0)
-            {
-                return Result::ok;
-            }
+            return Result::ok;
         }
+        deleteFromParent(mCache[victim]);
+        setIndexFree(victim);
+        mStats.evictions++;
+        neededCleanNodes--;
     }
     return Result::ok;
 }
 
 /*
- * Frees clean nodes
+ * Frees clean nodes, least recently used first.
+ * A branch only becomes a candidate once all its children are gone,
+ * so the upper levels stay cached the longest.
  */
 Result
 TreeCache::cleanFreeNodes(uint16_t& neededCleanNodes)
@@ -584,25 +644,18 @@ TreeCache::cleanFreeNodes(uint16_t& neededCleanNodes)
     resolveDirtyPaths(mCache[mCacheRoot]);
     if (dev->lasterr != Result::ok)
         return dev->lasterr;
-    for (unsigned int i = 0; i < treeNodeCacheSize; i++)
+
+    while (neededCleanNodes > 0)
     {
-        if (!isIndexUsed(getIndexFromPointer(mCache[i])))
-            continue;
-        if (!mCache[i].dirty && !mCache[i].locked && !mCache[i].inheritedLock && hasNoChilds(mCache[i]))
+        int16_t victim = findEvictionCandidate(false);
+        if (victim < 0)
         {
-            uint16_t cleaned = deletePathToRoot(mCache[i]);
-            setIndexFree(i);
-            if (cleaned > neededCleanNodes)
-            {
-                neededCleanNodes = 0;
-                return Result::ok;
-            }
-            neededCleanNodes -= cleaned;
-            if (neededCleanNodes == 0)
-            {
-                return Result::ok;
-            }
+            return Result::ok;
         }
+        deleteFromParent(mCache[victim]);
+        setIndexFree(victim);
+        mStats.evictions++;
+        neededCleanNodes--;
     }
     return Result::ok;
 }
@@ -612,71 +665,129 @@ TreeCache::cleanFreeNodes(uint16_t& neededCleanNodes)
 Result
 TreeCache::updateFlashAddressInParent(TreeCacheNode& node)
 {
-    if (node.parent == &node)
+    TreeCacheNode* parent = getParent(node);
+    if (parent == &node)
     {
         // Rootnode
         return dev->superblock.registerRootnode(node.raw.self);
     }
-    for (int i = 0; i <= node.parent->raw.keys; i++)
+    for (int i = 0; i <= parent->raw.keys; i++)
     {
-        if (node.parent->pointers[i] == &node)
+        if (getChild(*parent, i) == &node)
         {
-            node.parent->raw.as.branch.pointers[i] = node.raw.self;
-            node.parent->dirty = true;
+            parent->raw.as.branch.pointers[i] = node.raw.self;
+            parent->dirty = true;
             return Result::ok;
         }
     }
     PAFFS_DBG(PAFFS_TRACE_BUG,
               "Could not find Node %d in its parent (Node %d)!",
               getIndexFromPointer(node),
-              getIndexFromPointer(*node.parent));
+              getIndexFromPointer(*parent));
     return Result::notFound;
 }
 
-Result
-TreeCache::commitNodesRecursively(TreeCacheNode& node)
+void
+TreeCache::collectDirtyNodes(TreeCacheNode& node, TreeCacheNode** list, uint16_t& count)
 {
     if (!node.dirty)
     {
-        return Result::ok;
+        return;
     }
-    Result r;
-    if (node.raw.isLeaf)
+    if (!node.raw.isLeaf)
     {
-        r = writeTreeNode(node);
-        if (r != Result::ok)
+        for (uint16_t i = 0; i <= node.raw.keys; i++)
         {
-            PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not write cached Treenode leaf!");
-            return r;
+            if (node.pointers[i] != noCacheLink)
+            {
+                collectDirtyNodes(*getChild(node, i), list, count);
+            }
         }
-        node.dirty = false;
-        return r;
     }
-    FAILPOINT;
-    for (uint16_t i = 0; i <= node.raw.keys; i++)
+    // Children first, as the parent stores their new addresses
+    list[count++] = &node;
+}
+
+Result
+TreeCache::writeTreeNodes(TreeCacheNode** nodes, uint16_t count)
+{
+    if (count == 0)
     {
-        if (node.pointers[i] == nullptr)
-            continue;
-        r = commitNodesRecursively(*node.pointers[i]);
+        return Result::ok;
+    }
+    if (dev->readOnly)
+    {
+        PAFFS_DBG(PAFFS_TRACE_BUG, "Tried writing TreeNode in readOnly mode!");
+        return Result::bug;
+    }
+    AreaPos area = 0;
+    PageOffs page = 0;
+    Result r;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        // Continue the run of pages unless something else took the area or the page
+        if (area == 0 || dev->superblock.getActiveArea(AreaType::index) != area
+            || dev->sumCache.getPageStatus(area, page, r) != SummaryEntry::free)
+        {
+            r = findWritablePage(area, page);
+            if (r != Result::ok)
+            {
+                return r;
+            }
+        }
+        FAILPOINT;
+        r = writeTreeNode(*nodes[i], combineAddress(area, page));
         if (r != Result::ok)
         {
             PAFFS_DBG(PAFFS_TRACE_ERROR,
-                      "Could not write Node %" PRIu16 "'s child n° %" PRIu16 " (%" PRIu16 ") to flash!",
-                      getIndexFromPointer(node),
-                      i,
-                      getIndexFromPointer(*node.pointers[i]));
+                      "Could not write cached Treenode %" PRIu16 "!",
+                      getIndexFromPointer(*nodes[i]));
             return r;
         }
+        nodes[i]->dirty = false;
+        if (++page == dataPagesPerArea)
+        {
+            area = 0;
+        }
     }
-    FAILPOINT;
-    r = writeTreeNode(node);
+    return dev->areaMgmt.manageActiveAreaFull(AreaType::index);
+}
+
+Result
+TreeCache::findWritablePage(AreaPos& area, PageOffs& page)
+{
+    // The run may have ended on the last free page of the active area
+    Result r = dev->areaMgmt.manageActiveAreaFull(AreaType::index);
     if (r != Result::ok)
     {
-        PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not write cached Treenode!");
         return r;
     }
-    node.dirty = false;
-    return r;
+    dev->lasterr = Result::ok;
+    dev->areaMgmt.findWritableArea(AreaType::index);
+    if (dev->lasterr != Result::ok)
+    {
+        return dev->lasterr;
+    }
+    area = dev->superblock.getActiveArea(AreaType::index);
+    if (area == 0)
+    {
+        PAFFS_DBG(PAFFS_TRACE_BUG, "WRITE TREE NODE findWritableArea returned 0");
+        return Result::bug;
+    }
+    if (dev->superblock.getStatus(area) != AreaStatus::active)
+    {
+        PAFFS_DBG(PAFFS_TRACE_BUG, "BUG: findWritableArea returned inactive area!");
+        return Result::bug;
+    }
+    if (dev->areaMgmt.findFirstFreePage(page, area) == Result::noSpace)
+    {
+        PAFFS_DBG(PAFFS_TRACE_BUG,
+                  "BUG: findWritableArea returned full area (%" PTYPE_AREAPOS " on %" PTYPE_AREAPOS ").",
+                  area,
+                  dev->superblock.getPos(area));
+        return dev->lasterr = Result::bug;
+    }
+    return Result::ok;
 }
 
 /**
@@ -701,7 +812,11 @@ TreeCache::commitCache()
     {
         return dev->lasterr;
     }
-    Result r = commitNodesRecursively(mCache[mCacheRoot]);
+    TreeCacheNode* dirtyNodes[treeNodeCacheSize];
+    uint16_t dirtyCount = 0;
+    collectDirtyNodes(mCache[mCacheRoot], dirtyNodes, dirtyCount);
+    FAILPOINT;
+    Result r = writeTreeNodes(dirtyNodes, dirtyCount);
     if (r != Result::ok)
     {
         PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not write Node to flash! (%s)", err_msg(r));
@@ -783,6 +898,7 @@ TreeCache::freeNodes(uint16_t neededCleanNodes)
     if (neededCleanNodes == 0)
         return Result::ok;
 
+    mStats.forcedCommits++;
     r = commitCache();
     if(r != Result::ok)
     {
@@ -820,14 +936,14 @@ Result
 TreeCache::TreeCache::lockTreeCacheNode(TreeCacheNode& tcn)
 {
     tcn.locked = true;
-    if (tcn.parent == nullptr)
+    if (tcn.parent == noCacheLink)
         return Result::ok;
 
-    TreeCacheNode* curr = tcn.parent;
-    while (curr->parent != curr)
+    TreeCacheNode* curr = getParent(tcn);
+    while (getParent(*curr) != curr)
     {
         curr->inheritedLock = true;
-        curr = curr->parent;
+        curr = getParent(*curr);
     }
     curr->inheritedLock = true;
 
@@ -843,9 +959,9 @@ TreeCache::hasLockedChilds(TreeCacheNode& tcn)
     }
     for (int i = 0; i <= tcn.raw.keys; i++)
     {
-        if (tcn.pointers[i] != nullptr)
+        if (tcn.pointers[i] != noCacheLink)
         {
-            if (tcn.pointers[i]->inheritedLock || tcn.pointers[i]->locked)
+            if (getChild(tcn, i)->inheritedLock || getChild(tcn, i)->locked)
                 return true;
         }
     }
@@ -862,13 +978,13 @@ TreeCache::unlockTreeCacheNode(TreeCacheNode& tcn)
     }
     tcn.locked = false;
 
-    if (tcn.parent == nullptr)
+    if (tcn.parent == noCacheLink)
     {
         PAFFS_DBG(PAFFS_TRACE_ERROR, "Node %d with invalid parent !", getIndexFromPointer(tcn));
         return Result::fail;
     }
 
-    TreeCacheNode* curr = tcn.parent;
+    TreeCacheNode* curr = getParent(tcn);
     TreeCacheNode* old = nullptr;
     do
     {
@@ -880,13 +996,13 @@ TreeCache::unlockTreeCacheNode(TreeCacheNode& tcn)
         if (curr->locked)
             break;
 
-        if (tcn.parent == nullptr)
+        if (tcn.parent == noCacheLink)
         {
             PAFFS_DBG(PAFFS_TRACE_ERROR, "Node %d with invalid parent !", getIndexFromPointer(tcn));
             return Result::fail;
         }
         old = curr;
-        curr = curr->parent;
+        curr = getParent(*curr);
 
     } while (old != curr);
 
@@ -899,10 +1015,11 @@ TreeCache::getRootNodeFromCache(TreeCacheNode*& tcn)
     if (isIndexUsed(mCacheRoot))
     {
         tcn = &mCache[mCacheRoot];
-        mCacheHits++;
+        touch(*tcn);
+        mStats.hits++;
         return Result::ok;
     }
-    mCacheMisses++;
+    mStats.misses++;
 
     PAFFS_DBG_S(PAFFS_TRACE_TREECACHE, "Load rootnode from Flash");
 
@@ -919,7 +1036,7 @@ TreeCache::getRootNodeFromCache(TreeCacheNode*& tcn)
                   treeNodeCacheSize);
         return r;
     }
-    new_root->parent = new_root;
+    setParent(*new_root, new_root);
     r = setRoot(*new_root);
     if (r != Result::ok)
         return r;
@@ -964,12 +1081,13 @@ TreeCache::getTreeNodeAtIndexFrom(uint16_t index, TreeCacheNode& parent, TreeCac
         return Result::bug;
     }
 
-    TreeCacheNode* target = parent.pointers[index];
+    TreeCacheNode* target = getChild(parent, index);
     // To make sure parent and child can point to the same address, target is used as tmp buffer
     if (target != nullptr)
     {
         child = target;
-        mCacheHits++;
+        touch(*target);
+        mStats.hits++;
         if(traceMask & PAFFS_TRACE_VERBOSE)
         {
             PAFFS_DBG_S(PAFFS_TRACE_TREECACHE,
@@ -996,7 +1114,7 @@ TreeCache::getTreeNodeAtIndexFrom(uint16_t index, TreeCacheNode& parent, TreeCac
         return Result::invalidInput;
     }
 
-    mCacheMisses++;
+    mStats.misses++;
     if (traceMask & PAFFS_TRACE_VERBOSE)
     {
         PAFFS_DBG_S(PAFFS_TRACE_TREECACHE, "Cache Miss");
@@ -1011,8 +1129,8 @@ TreeCache::getTreeNodeAtIndexFrom(uint16_t index, TreeCacheNode& parent, TreeCac
     }
     unlockTreeCacheNode(parent);
 
-    target->parent = &parent;
-    parent.pointers[index] = target;
+    setParent(*target, &parent);
+    setChild(parent, index, target);
     child = target;
 
     r = readTreeNode(parent.raw.as.branch.pointers[index], child->raw);
@@ -1044,7 +1162,7 @@ TreeCache::removeNode(TreeCacheNode& tcn)
 Result
 TreeCache::commitIfNodesWereRemoved()
 {
-    if(statemachine.getMinSpaceLeft() == treeNodeCacheSize)
+    if(statemachine.getMinSpaceLeft() == maxPendingPages)
     {
         //nothing was removed
         return Result::ok;
@@ -1057,7 +1175,7 @@ TreeCache::commitIfNodesWereRemoved()
 Result
 TreeCache::setRoot(TreeCacheNode& rootTcn)
 {
-    if (rootTcn.parent != &rootTcn)
+    if (getParent(rootTcn) != &rootTcn)
     {
         PAFFS_DBG(PAFFS_TRACE_BUG, "BUG: setCacheRoot with root->parent not pointing to itself");
         return Result::bug;
@@ -1085,16 +1203,28 @@ TreeCache::getCacheSize()
     return treeNodeCacheSize;
 }
 
-uint16_t
+uint32_t
 TreeCache::getCacheHits()
 {
-    return mCacheHits;
+    return mStats.hits;
 }
 
-uint16_t
+uint32_t
 TreeCache::getCacheMisses()
 {
-    return mCacheMisses;
+    return mStats.misses;
+}
+
+const TreeCacheStatistics&
+TreeCache::getStatistics()
+{
+    return mStats;
+}
+
+void
+TreeCache::resetStatistics()
+{
+    memset(&mStats, 0, sizeof(TreeCacheStatistics));
 }
 
 void
@@ -1103,7 +1233,7 @@ TreeCache::printNode(TreeCacheNode& node)
     printf("[%sID: %d PAR: %d %s%s%s|",
                mCacheUsage.getBit(getIndexFromPointer(node)) ? "" : "X ",
                getIndexFromPointer(node),
-               getIndexFromPointer(*node.parent),
+               getIndexFromPointer(*getParent(node)),
                node.dirty ? "d" : "-",
                node.locked ? "l" : "-",
                node.inheritedLock ? "i" : "-");
@@ -1118,17 +1248,17 @@ TreeCache::printNode(TreeCacheNode& node)
         }
         else
         {
-            if (node.pointers[0] == 0)
+            if (node.pointers[0] == noCacheLink)
                 printf("x");
             else
-                printf("%d", getIndexFromPointer(*node.pointers[0]));
+                printf("%d", getIndexFromPointer(*getChild(node, 0)));
 
             bool isGap = false;
             for (int i = 1; i <= node.raw.keys; i++)
             {
                 if (!isGap)
                     printf("/%" PRIu32 "\\", node.raw.as.branch.keys[i - 1]);
-                if (node.pointers[i] == 0)
+                if (node.pointers[i] == noCacheLink)
                 {
                     if (!isGap)
                     {
@@ -1138,7 +1268,7 @@ TreeCache::printNode(TreeCacheNode& node)
                 }
                 else
                 {
-                    printf("%d", getIndexFromPointer(*node.pointers[i]));
+                    printf("%d", getIndexFromPointer(*getChild(node, i)));
                     isGap = false;
                 }
             }
@@ -1163,9 +1293,9 @@ TreeCache::printSubtree(int layer, BitList<treeNodeCacheSize>& reached, TreeCach
     printNode(node);
     for (int i = 0; i <= node.raw.keys; i++)
     {
-        if (node.pointers[i] != 0)
+        if (node.pointers[i] != noCacheLink)
         {
-            printSubtree(layer + 1, reached, *node.pointers[i]);
+            printSubtree(layer + 1, reached, *getChild(node, i));
         }
     }
 
@@ -1208,31 +1338,8 @@ TreeCache::printTreeCache()
  * \warn changes address in parent Node
  */
 Result
-TreeCache::writeTreeNode(TreeCacheNode& node)
+TreeCache::writeTreeNode(TreeCacheNode& node, Addr newAddr)
 {
-    if (dev->readOnly)
-    {
-        PAFFS_DBG(PAFFS_TRACE_BUG, "Tried writing TreeNode in readOnly mode!");
-        return Result::bug;
-    }
-    dev->lasterr = Result::ok;
-    dev->areaMgmt.findWritableArea(AreaType::index);
-    if (dev->lasterr != Result::ok)
-    {
-        return dev->lasterr;
-    }
-    FAILPOINT;
-    // Handle Areas
-    if (dev->superblock.getStatus(dev->superblock.getActiveArea(AreaType::index)) != AreaStatus::active)
-    {
-        PAFFS_DBG(PAFFS_TRACE_BUG, "BUG: findWritableArea returned inactive area!");
-        return Result::bug;
-    }
-    if (dev->superblock.getActiveArea(AreaType::index) == 0)
-    {
-        PAFFS_DBG(PAFFS_TRACE_BUG, "WRITE TREE NODE findWritableArea returned 0");
-        return Result::bug;
-    }
     Result r;
     if(node.raw.self != 0)
     {
@@ -1258,18 +1365,6 @@ TreeCache::writeTreeNode(TreeCacheNode& node)
             return Result::bug;
         }
     }
-    PageOffs firstFreePage = 0;
-    if (dev->areaMgmt.findFirstFreePage(firstFreePage,
-                                        dev->superblock.getActiveArea(AreaType::index))
-        == Result::noSpace)
-    {
-        PAFFS_DBG(PAFFS_TRACE_BUG,
-                  "BUG: findWritableArea returned full area (%" PTYPE_AREAPOS " on %" PTYPE_AREAPOS ").",
-                  dev->superblock.getActiveArea(AreaType::index),
-                  dev->superblock.getPos(dev->superblock.getActiveArea(AreaType::index)));
-        return dev->lasterr = Result::bug;
-    }
-    Addr newAddr = combineAddress(dev->superblock.getActiveArea(AreaType::index), firstFreePage);
     Addr oldSelf = node.raw.self;
     node.raw.self = newAddr;
     FAILPOINT;
@@ -1280,7 +1375,9 @@ TreeCache::writeTreeNode(TreeCacheNode& node)
         PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not mark tree node page used because %s", err_msg(r));
     }
     FAILPOINT;
-    r = dev->driver.writePage(getPageNumber(node.raw.self, *dev), &node, sizeof(TreeNode));
+    uint8_t buf[dataBytesPerPage];
+    uint16_t len = encodeTreeNode(node.raw, buf);
+    r = dev->driver.writePage(getPageNumber(node.raw.self, *dev), buf, len);
     if (r != Result::ok)
     {
         PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not write TreeNode to page");
@@ -1293,13 +1390,6 @@ TreeCache::writeTreeNode(TreeCacheNode& node)
         PAFFS_DBG(PAFFS_TRACE_ERROR, "Could not update node address in Parent!");
         return r;
     }
-    FAILPOINT;
-    r = dev->areaMgmt.manageActiveAreaFull(AreaType::index);
-    if (r != Result::ok)
-    {
-        return r;
-    }
-
     return Result::ok;
 }
 
@@ -1374,7 +1464,9 @@ TreeCache::readTreeNode(Addr addr, TreeNode& node)
         }
     }
 
-    r = dev->driver.readPage(getPageNumber(addr, *dev), &node, sizeof(TreeNode));
+    uint8_t buf[dataBytesPerPage];
+    r = dev->driver.readPage(getPageNumber(addr, *dev), buf, dataBytesPerPage);
+    decodeTreeNode(buf, node);
     if (r != Result::ok)
     {
         if (r == Result::biterrorCorrected)
@@ -1409,6 +1501,133 @@ TreeCache::readTreeNode(Addr addr, TreeNode& node)
     return r;
 }
 
+namespace
+{
+template <typename T>
+inline void
+put(uint8_t*& buf, T value)
+{
+    memcpy(buf, &value, sizeof(T));
+    buf += sizeof(T);
+}
+
+template <typename T>
+inline T
+get(const uint8_t*& buf)
+{
+    T value;
+    memcpy(&value, buf, sizeof(T));
+    buf += sizeof(T);
+    return value;
+}
+
+// Byte by byte, so that hosts of either endianness keep the lower bits
+inline void
+putTimestamp(uint8_t*& buf, uint64_t value)
+{
+    for (uint16_t i = 0; i < packedTimestampSize; i++)
+    {
+        *buf++ = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+inline uint64_t
+getTimestamp(const uint8_t*& buf)
+{
+    uint64_t value = 0;
+    for (uint16_t i = 0; i < packedTimestampSize; i++)
+    {
+        value |= static_cast<uint64_t>(*buf++) << (8 * i);
+    }
+    return value;
+}
+}
+
+uint16_t
+TreeCache::encodeTreeNode(const TreeNode& node, uint8_t* buf)
+{
+    uint8_t* curr = buf;
+    put(curr, node.self);
+    put(curr, node.isLeaf);
+    put(curr, node.keys);
+    if (!node.isLeaf)
+    {
+        for (uint16_t i = 0; i < branchOrder - 1; i++)
+        {
+            put(curr, node.as.branch.keys[i]);
+        }
+        for (uint16_t i = 0; i < branchOrder; i++)
+        {
+            put(curr, node.as.branch.pointers[i]);
+        }
+        return curr - buf;
+    }
+    for (uint16_t i = 0; i < node.keys; i++)
+    {
+        const Inode& inode = node.as.leaf.pInodes[i];
+        put(curr, inode.no);
+        put(curr, inode.type);
+        put(curr, static_cast<Permission>(inode.perm));
+        put(curr, inode.reservedPages);
+        put(curr, inode.size);
+        putTimestamp(curr, inode.crea);
+        putTimestamp(curr, inode.mod);
+        for (uint16_t j = 0; j < directAddrCount; j++)
+        {
+            put(curr, inode.direct[j]);
+        }
+        put(curr, inode.indir);
+        put(curr, inode.d_indir);
+        put(curr, inode.t_indir);
+    }
+    return curr - buf;
+}
+
+void
+TreeCache::decodeTreeNode(const uint8_t* buf, TreeNode& node)
+{
+    memset(&node, 0, sizeof(TreeNode));
+    node.self = get<Addr>(buf);
+    node.isLeaf = get<bool>(buf);
+    node.keys = get<uint16_t>(buf);
+    if (!node.isLeaf)
+    {
+        for (uint16_t i = 0; i < branchOrder - 1; i++)
+        {
+            node.as.branch.keys[i] = get<InodeNo>(buf);
+        }
+        for (uint16_t i = 0; i < branchOrder; i++)
+        {
+            node.as.branch.pointers[i] = get<Addr>(buf);
+        }
+        return;
+    }
+    if (node.keys > leafOrder)
+    {   // Garbage, the caller notices the wrong self address
+        node.keys = 0;
+        return;
+    }
+    for (uint16_t i = 0; i < node.keys; i++)
+    {
+        Inode& inode = node.as.leaf.pInodes[i];
+        inode.no = get<InodeNo>(buf);
+        inode.type = get<InodeType>(buf);
+        inode.perm = get<Permission>(buf);
+        inode.reservedPages = get<uint16_t>(buf);
+        inode.size = get<FileSize>(buf);
+        inode.crea = getTimestamp(buf);
+        inode.mod = getTimestamp(buf);
+        for (uint16_t j = 0; j < directAddrCount; j++)
+        {
+            inode.direct[j] = get<Addr>(buf);
+        }
+        inode.indir = get<Addr>(buf);
+        inode.d_indir = get<Addr>(buf);
+        inode.t_indir = get<Addr>(buf);
+        node.as.leaf.keys[i] = inode.no;
+    }
+}
+
 Result
 TreeCache::deleteTreeNode(TreeNode& node)
 {
@@ -21,6 +21,14 @@
 
 namespace paffs
 {
+struct TreeCacheStatistics
+{
+    uint32_t hits;          // nodes found in cache
+    uint32_t misses;        // nodes that had to be read from flash
+    uint32_t evictions;     // clean nodes dropped to make room
+    uint32_t forcedCommits; // commits because no clean node could be dropped
+};
+
 class TreeCache
 {
     Device* dev;
@@ -30,11 +38,16 @@ class TreeCache
     TreeCacheNode mCache[treeNodeCacheSize];
 
     BitList<treeNodeCacheSize> mCacheUsage;
-    PageStateMachine<treeNodeCacheSize, 0, JournalEntry::Topic::tree> statemachine;
+    // A commit may rewrite every cached node after a deletion removed a path of nodes
+    static constexpr uint16_t maxPendingPages = 2 * treeNodeCacheSize;
+    PageStateMachine<maxPendingPages, 0, JournalEntry::Topic::tree> statemachine;
+
+    // Value of mClock at the last access of each node, smallest is evicted first
+    uint32_t mLastUse[treeNodeCacheSize];
+    uint32_t mClock = 0;
 
     // Just for debug/tuning purposes
-    uint16_t mCacheHits = 0;
-    uint16_t mCacheMisses = 0;
+    TreeCacheStatistics mStats;
 
     bool mJournalIsRecovering;
 
@@ -127,14 +140,42 @@ public:
     getCacheUsage();
     uint16_t
     getCacheSize();
-    uint16_t
+    uint32_t
     getCacheHits();
-    uint16_t
+    uint32_t
     getCacheMisses();
+    const TreeCacheStatistics&
+    getStatistics();
+    void
+    resetStatistics();
     void
     printTreeCache();
     uint16_t
-    getIndexFromPointer(TreeCacheNode& tcn);
+    getIndexFromPointer(const TreeCacheNode& tcn);
+    TreeCacheLink
+    getLink(const TreeCacheNode& tcn);
+    /**
+     * \return nullptr if the link points to no cached node
+     */
+    TreeCacheNode*
+    getNode(TreeCacheLink link);
+    TreeCacheNode*
+    getChild(const TreeCacheNode& tcn, uint16_t index);
+    void
+    setChild(TreeCacheNode& tcn, uint16_t index, TreeCacheNode* child);
+    TreeCacheNode*
+    getParent(const TreeCacheNode& tcn);
+    void
+    setParent(TreeCacheNode& tcn, TreeCacheNode* parent);
+
+    /**
+     * Serializes the node into its on-flash layout
+     * \return number of bytes used in buf
+     */
+    static uint16_t
+    encodeTreeNode(const TreeNode& node, uint8_t* buf);
+    static void
+    decodeTreeNode(const uint8_t* buf, TreeNode& node);
 private:
 
     Result
@@ -151,16 +192,31 @@ private:
     deleteFromParent(TreeCacheNode& tcn);
     bool
     hasNoChilds(TreeCacheNode& tcn);
-    //! \return number of deleted Nodes
-    uint16_t
-    deletePathToRoot(TreeCacheNode& tcn);
+    void
+    touch(TreeCacheNode& tcn);
+    /**
+     * Least recently used clean and unlocked node without cached children.
+     * The root is only chosen if no other node qualifies.
+     * \return -1 if there is none
+     */
+    int16_t
+    findEvictionCandidate(bool leavesOnly);
     Result
     tryAddNewCacheNode(TreeCacheNode*& newTcn);
     /**
+     * Lists the dirty nodes below node, children before their parents.
      * \warn Only valid if resolveDirtyPaths has been called before
      */
+    void
+    collectDirtyNodes(TreeCacheNode& node, TreeCacheNode** list, uint16_t& count);
+    /**
+     * Writes the nodes in list order to a run of consecutive index pages,
+     * only looking for a new area or free page when the run is interrupted
+     */
+    Result
+    writeTreeNodes(TreeCacheNode** nodes, uint16_t count);
     Result
-    commitNodesRecursively(TreeCacheNode& node);
+    findWritablePage(AreaPos& area, PageOffs& page);
     void
     setIndexUsed(uint16_t index);
     void
@@ -201,7 +257,7 @@ private:
     cleanFreeNodes(uint16_t& neededCleanNodes);
 
     Result
-    writeTreeNode(TreeCacheNode& node);
+    writeTreeNode(TreeCacheNode& node, Addr newAddr);
     Result
     readTreeNode(Addr addr, TreeNode& node);
     Result
@@ -17,13 +17,21 @@
 
 namespace paffs
 {
+// On flash, every node starts with its own address, the leaf flag and the number of keys
+static constexpr uint16_t treeNodeHeaderSize = sizeof(Addr) + sizeof(bool) + sizeof(uint16_t);
+// Timestamps are milliseconds, 48 bit last for about 8900 years
+static constexpr uint16_t packedTimestampSize = 6;
+// Leaves store their inodes without padding and without a separate key list,
+// as the keys are the inode numbers. See TreeCache::encodeTreeNode.
+static constexpr uint16_t packedInodeSize =
+        sizeof(InodeNo) + sizeof(InodeType) + sizeof(Permission) + sizeof(uint16_t)
+        + sizeof(FileSize) + 2 * packedTimestampSize + (directAddrCount + 3) * sizeof(Addr);
+
 // Calculates how many pointers a node can hold in one page
 static constexpr uint16_t branchOrder =
         (dataBytesPerPage - sizeof(Addr) - sizeof(bool) - sizeof(unsigned char))
         / (sizeof(Addr) + sizeof(InodeNo));
-static constexpr uint16_t leafOrder =
-        (dataBytesPerPage - sizeof(Addr) - sizeof(bool) - sizeof(unsigned char))
-        / (sizeof(Inode) + sizeof(InodeNo));
+static constexpr uint16_t leafOrder = (dataBytesPerPage - treeNodeHeaderSize) / packedInodeSize;
 
 // Note that this struct is not packed.
 struct TreeNode
@@ -46,14 +54,25 @@ struct TreeNode
                      // If Branch: Number of addresses - 1
 };
 
-static_assert(sizeof(TreeNode) <= dataBytesPerPage, "At least one treenode must fit in a page");
+static_assert(treeNodeHeaderSize + (branchOrder - 1) * sizeof(InodeNo)
+              + branchOrder * sizeof(Addr) <= dataBytesPerPage,
+              "An encoded branch must fit in a page");
+static_assert(treeNodeHeaderSize + leafOrder * packedInodeSize <= dataBytesPerPage,
+              "An encoded leaf must fit in a page");
+static_assert(leafOrder >= 2, "At least two inodes have to fit in a leaf");
+
+// Links between cached nodes are cache positions plus one, so a zeroed node links to nothing.
+// This keeps a node's child table at one byte per possible child instead of one pointer.
+typedef uint8_t TreeCacheLink;
+static constexpr TreeCacheLink noCacheLink = 0;
+static_assert(treeNodeCacheSize <= 255, "Tree cache positions have to fit into a TreeCacheLink");
 
 struct TreeCacheNode
 {
     TreeNode raw;
-    struct TreeCacheNode* parent;  // Parent either points to parent or to node itself if is root.
-                                   // Special case: NULL if node is invalid.
-    struct TreeCacheNode* pointers[branchOrder];
+    TreeCacheLink parent;  // Parent either links to parent or to node itself if is root.
+                           // Special case: noCacheLink if node is invalid.
+    TreeCacheLink pointers[branchOrder];
     bool dirty : 1;
     bool locked : 1;
     bool inheritedLock : 1;
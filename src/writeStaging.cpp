@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2017, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Authors:
+ * - 2017, Pascal Pieper (DLR RY-AVS)
+ */
+// ----------------------------------------------------------------------------
+
+#include "writeStaging.hpp"
+#include "device.hpp"
+#include "paffs_trace.hpp"
+#include <inttypes.h>
+#include <string.h>
+
+namespace paffs
+{
+bool
+WriteStaging::isEnabled()
+{
+    return mramSize != 0;
+}
+
+void
+WriteStaging::stage(uint8_t slot, InodeNo inode, FileSize offs, const uint8_t* buffer,
+                    uint16_t from, uint16_t bytes)
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+    PageAbs start = getSlotStart(slot);
+    dev->driver.writeMRAM(start + sizeof(StagedWrite) + from, &buffer[from], bytes);
+    StagedWrite header;
+    memset(&header, 0, sizeof(StagedWrite));
+    header.inode = inode;
+    header.offs = offs;
+    header.bytes = from + bytes;
+    dev->driver.writeMRAM(start, &header, sizeof(StagedWrite));
+    PAFFS_DBG_S(PAFFS_TRACE_WRITE, "Staged %" PRIu16 " bytes at %" PTYPE_FILSIZE
+                " of Inode %" PTYPE_INODENO " in slot %" PRIu8, header.bytes, offs, inode, slot);
+}
+
+void
+WriteStaging::unstage(uint8_t slot)
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+    StagedWrite header;
+    memset(&header, 0, sizeof(StagedWrite));
+    dev->driver.writeMRAM(getSlotStart(slot), &header, sizeof(StagedWrite));
+}
+
+bool
+WriteStaging::read(uint8_t slot, StagedWrite& header, uint8_t* data)
+{
+    if (!isEnabled())
+    {
+        return false;
+    }
+    PageAbs start = getSlotStart(slot);
+    dev->driver.readMRAM(start, &header, sizeof(StagedWrite));
+    if (header.bytes == 0 || header.bytes > dataBytesPerPage)
+    {
+        // Larger sizes only come from uninitialized MRAM
+        return false;
+    }
+    dev->driver.readMRAM(start + sizeof(StagedWrite), data, header.bytes);
+    return true;
+}
+
+void
+WriteStaging::clear()
+{
+    for (uint8_t slot = 0; slot < maxWriteBufferedFiles; slot++)
+    {
+        unstage(slot);
+    }
+}
+
+PageAbs
+WriteStaging::getSlotStart(uint8_t slot)
+{
+    return mramJournalSize + slot * mramStagingSlotSize;
+}
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2017, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Authors:
+ * - 2017, Pascal Pieper (DLR RY-AVS)
+ */
+// ----------------------------------------------------------------------------
+
+#pragma once
+#include "commonTypes.hpp"
+
+namespace paffs
+{
+/**
+ * Header of a staging slot, followed by one page of data
+ */
+struct StagedWrite
+{
+    InodeNo inode;
+    FileSize offs;   // File offset of the first staged byte
+    uint16_t bytes;  // 0 if the slot is empty
+};
+
+// The write buffers of objects opened with FB are mirrored to the end of the MRAM,
+// one slot per write buffer. The journal uses the MRAM in front of them.
+static constexpr uint32_t mramStagingSlotSize = sizeof(StagedWrite) + dataBytesPerPage;
+static constexpr uint32_t mramStagingSize =
+        mramSize == 0 ? 0 : maxWriteBufferedFiles * mramStagingSlotSize;
+static constexpr uint32_t mramJournalSize = mramSize - mramStagingSize;
+static_assert(mramSize == 0 || mramStagingSize + reservedLogsize < mramSize,
+              "MRAM is too small to stage the write buffers of all files");
+
+/**
+ * Makes data in the write buffers of objects durable before it is written to flash.
+ * Staged data that was not written to flash before a power loss
+ * is written when the device is mounted the next time.
+ */
+class WriteStaging
+{
+    Device* dev;
+
+public:
+    WriteStaging(Device* mdev) : dev(mdev){};
+
+    bool
+    isEnabled();
+
+    /**
+     * Appends bytes [from, from + bytes) of a write buffer to the slot.
+     * The data is written before the header, so the header never references unwritten data.
+     */
+    void
+    stage(uint8_t slot, InodeNo inode, FileSize offs, const uint8_t* buffer,
+          uint16_t from, uint16_t bytes);
+
+    /**
+     * To be called after the staged data was written to flash
+     */
+    void
+    unstage(uint8_t slot);
+
+    /**
+     * @param data has to hold dataBytesPerPage bytes
+     * @return false if the slot is empty
+     */
+    bool
+    read(uint8_t slot, StagedWrite& header, uint8_t* data);
+
+    void
+    clear();
+
+private:
+    PageAbs
+    getSlotStart(uint8_t slot);
+};
+}
@@ -12,6 +12,7 @@
  */
 // ----------------------------------------------------------------------------
 
+#include <chrono>
 #include <iostream>
 
 #include "commonTest.hpp"
@@ -92,3 +93,118 @@ TEST(TwoBitlist, SetAndGetBits)
         ASSERT_EQ(bitlist.getValue(i), i % 4);
     }
 }
+
+template <size_t size>
+static void
+checkWordOperations()
+{
+    paffs::BitList<size> bitlist;
+    paffs::TwoBitList<size> twoBitlist;
+    srand(size);
+    for (unsigned run = 0; run < 16; run++)
+    {
+        size_t from = rand() % size;
+        size_t to = from + rand() % (size - from + 1);
+        bitlist.clear();
+        bitlist.setRange(from, to);
+        twoBitlist.clear();
+        twoBitlist.setRange(from, to, run % 3 + 1);
+
+        size_t setBits = 0, firstFree = size;
+        size_t matching[4] = {0, 0, 0, 0};
+        size_t firstMatching[4] = {size, size, size, size};
+        for (size_t i = 0; i < size; i++)
+        {
+            ASSERT_EQ(bitlist.getBit(i), i >= from && i < to);
+            ASSERT_EQ(twoBitlist.getValue(i), i >= from && i < to ? run % 3 + 1 : 0u);
+            setBits += bitlist.getBit(i);
+            if (!bitlist.getBit(i) && firstFree == size)
+            {
+                firstFree = i;
+            }
+            uint8_t value = twoBitlist.getValue(i);
+            matching[value]++;
+            if (firstMatching[value] == size)
+            {
+                firstMatching[value] = i;
+            }
+        }
+        ASSERT_EQ(bitlist.countSetBits(), setBits);
+        ASSERT_EQ(bitlist.findFirstFree(), firstFree);
+        for (uint8_t value = 0; value < 4; value++)
+        {
+            ASSERT_EQ(twoBitlist.countValue(value), matching[value]);
+            ASSERT_EQ(twoBitlist.findFirstValue(value), firstMatching[value]);
+        }
+
+        bitlist.resetRange(0, size);
+        ASSERT_FALSE(bitlist.isSetSomewhere());
+    }
+}
+
+TEST(Bitlist, WordOperations)
+{
+    checkWordOperations<1>();
+    checkWordOperations<63>();
+    checkWordOperations<64>();
+    checkWordOperations<100>();
+    checkWordOperations<255>();
+    checkWordOperations<1023>();
+}
+
+template <size_t size>
+static void
+benchmarkTwoBitList()
+{
+    static constexpr unsigned int runs = 2000;
+    paffs::TwoBitList<size> list;
+    for (size_t i = 0; i < size; i++)
+    {
+        list.setValue(i, rand() % 3);
+    }
+    list.setValue(size - 1, 3);
+
+    size_t naive = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int run = 0; run < runs; run++)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            naive += list.getValue(i) == run % 3;
+        }
+        for (size_t i = 0; i < size; i++)
+        {
+            if (list.getValue(i) == 3)
+            {
+                naive += i;
+                break;
+            }
+        }
+    }
+    auto naiveTime = std::chrono::steady_clock::now() - start;
+
+    size_t word = 0;
+    start = std::chrono::steady_clock::now();
+    for (unsigned int run = 0; run < runs; run++)
+    {
+        word += list.countValue(run % 3);
+        word += list.findFirstValue(3);
+    }
+    auto wordTime = std::chrono::steady_clock::now() - start;
+    ASSERT_EQ(word, naive);
+
+    printf("TwoBitList<%4zu> count + find: %8.1f ns element wise, %7.1f ns word wise\n",
+           size,
+           static_cast<double>(
+                   std::chrono::duration_cast<std::chrono::nanoseconds>(naiveTime).count()) / runs,
+           static_cast<double>(
+                   std::chrono::duration_cast<std::chrono::nanoseconds>(wordTime).count()) / runs);
+}
+
+TEST(TwoBitlist, Benchmark)
+{
+    benchmarkTwoBitList<63>();
+    benchmarkTwoBitList<255>();
+    benchmarkTwoBitList<1023>();
+    benchmarkTwoBitList<4095>();
+}
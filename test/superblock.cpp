@@ -29,6 +29,12 @@ TEST(Superblock, IsIndexSerializeFunctionValid)
     AreaPos outputActiveArea[AreaType::no];
     TwoBitList<dataPagesPerArea> correctSummaries[2];
     TwoBitList<dataPagesPerArea> outputSummaries[2];
+    PageOffs correctDirtyPages[areasNo];
+    PageOffs correctUsedPages[areasNo];
+    PageOffs outputDirtyPages[areasNo];
+    PageOffs outputUsedPages[areasNo];
+    uint32_t correctLastWrite[areasNo];
+    uint32_t outputLastWrite[areasNo];
 
     Result r;
     uint64_t deletions = 0;
@@ -49,6 +55,10 @@ TEST(Superblock, IsIndexSerializeFunctionValid)
         correctMap[i].erasecount = areasNo - i;
         correctMap[i].type = static_cast<AreaType>(i % AreaType::no);
 
+        correctDirtyPages[i] = i % dataPagesPerArea;
+        correctUsedPages[i] = dataPagesPerArea - correctDirtyPages[i];
+        correctLastWrite[i] = i * 1000;
+
         deletions += correctMap[i].erasecount;
         usedAreas += correctMap[i].status != AreaStatus::empty ? 1 : 0;
     }
@@ -67,6 +77,9 @@ TEST(Superblock, IsIndexSerializeFunctionValid)
     input.usedAreas = usedAreas;
     input.activeArea = correctActiveArea;
     input.overallDeletions = deletions;
+    input.dirtyPages = correctDirtyPages;
+    input.usedPages = correctUsedPages;
+    input.lastWrite = correctLastWrite;
     input.areaSummaryPositions[0] = correctActiveArea[AreaType::data];
     input.areaSummaryPositions[1] = correctActiveArea[AreaType::index];
     input.summaries[0] = &correctSummaries[0];
@@ -76,6 +89,9 @@ TEST(Superblock, IsIndexSerializeFunctionValid)
 
     output.areaMap = outputMap;
     output.activeArea = outputActiveArea;
+    output.dirtyPages = outputDirtyPages;
+    output.usedPages = outputUsedPages;
+    output.lastWrite = outputLastWrite;
     output.summaries[0] = &outputSummaries[0];
     output.summaries[1] = &outputSummaries[1];
 
@@ -90,6 +106,9 @@ TEST(Superblock, IsIndexSerializeFunctionValid)
     ASSERT_EQ(input.usedAreas, output.usedAreas);
     ASSERT_TRUE(ArraysMatch(correctActiveArea, outputActiveArea));;
     ASSERT_EQ(input.overallDeletions, output.overallDeletions);
+    ASSERT_TRUE(ArraysMatch(correctDirtyPages, outputDirtyPages));
+    ASSERT_TRUE(ArraysMatch(correctUsedPages, outputUsedPages));
+    ASSERT_TRUE(ArraysMatch(correctLastWrite, outputLastWrite));
     ASSERT_TRUE(ArraysMatch(input.areaSummaryPositions, output.areaSummaryPositions));
     ASSERT_EQ(correctSummaries[0], outputSummaries[0]);
     ASSERT_EQ(correctSummaries[1], outputSummaries[1]);